@@ -325,6 +325,65 @@ key_opts_decode_distance(const char *str)
 	return RTREE_INDEX_DISTANCE_TYPE_EUCLID; /* unreachabe */
 }
 
+/**
+ * Support function for key_def_new_from_tuple(..)
+ * Decode RTREE coordinate type name to enum.
+ * Throws an error if the name does not correspond to any type.
+ */
+static enum rtree_index_coord_type
+key_opts_decode_coord_type(const char *str)
+{
+	enum rtree_index_coord_type type =
+		STR2ENUM(rtree_index_coord_type, str);
+	if (type == rtree_index_coord_type_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS, INDEX_OPTS,
+			  "coord_type must be either 'double' or 'float'");
+	}
+	return type;
+}
+
+/**
+ * Support function for key_def_new_from_tuple(..)
+ * Decode vinyl compaction policy name to enum.
+ * Throws an error if the name does not correspond to any policy.
+ */
+static enum vy_compaction_policy
+key_opts_decode_compaction_policy(const char *str)
+{
+	enum vy_compaction_policy policy = STR2ENUM(vy_compaction_policy, str);
+	if (policy == vy_compaction_policy_MAX) {
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS, INDEX_OPTS,
+			  "compaction_policy must be one of 'tiered', "
+			  "'leveled' or 'time_window'");
+	}
+	return policy;
+}
+
+/**
+ * Support function for key_def_new_from_tuple(..)
+ * Decode the list of fields included into a vinyl secondary
+ * index, e.g. "2,4", to a column mask.
+ * Throws an error if the list is malformed.
+ */
+static uint64_t
+key_opts_decode_include(const char *str)
+{
+	uint64_t mask = 0;
+	while (*str != '\0') {
+		char *end;
+		unsigned long fieldno = strtoul(str, &end, 10);
+		if (end == str || fieldno >= 64 ||
+		    (*end != ',' && *end != '\0')) {
+			tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+				  INDEX_OPTS, "include must be a list of "
+				  "field numbers less than 64");
+		}
+		mask |= ((uint64_t) 1) << (63 - fieldno);
+		str = *end == ',' ? end + 1 : end;
+	}
+	return mask;
+}
+
 /**
  * Support function for key_def_new_from_tuple(..)
  * 1.6.6+
@@ -341,12 +400,23 @@ key_opts_create(struct key_opts *opts, const char *map)
 				     ER_WRONG_INDEX_OPTIONS, INDEX_OPTS);
 	if (opts->distancebuf[0] != '\0')
 		opts->distance = key_opts_decode_distance(opts->distancebuf);
+	if (opts->coord_typebuf[0] != '\0')
+		opts->coord_type = key_opts_decode_coord_type(opts->coord_typebuf);
+	if (opts->compaction_policybuf[0] != '\0') {
+		opts->compaction_policy =
+			key_opts_decode_compaction_policy(opts->compaction_policybuf);
+	}
+	if (opts->includebuf[0] != '\0')
+		opts->include_mask = key_opts_decode_include(opts->includebuf);
 	if (opts->run_count_per_level <= 0)
 		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS, INDEX_OPTS,
 			  "run_count_per_level must be > 0");
 	if (opts->run_size_ratio <= 1)
 		tnt_raise(ClientError, ER_WRONG_SPACE_OPTIONS, INDEX_OPTS,
 			  "run_size_ratio must be > 1");
+	if (opts->cache_size < 0)
+		tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS, INDEX_OPTS,
+			  "cache_size must be >= 0");
 	return map;
 }
 
@@ -1164,7 +1234,9 @@ key_def_change_require_index_rebuid(struct key_def *old_key_def,
 	}
 	if (old_key_def->type == RTREE) {
 		if (old_key_def->opts.dimension != new_key_def->opts.dimension
-		    || old_key_def->opts.distance != new_key_def->opts.distance)
+		    || old_key_def->opts.distance != new_key_def->opts.distance
+		    || old_key_def->opts.coord_type !=
+		       new_key_def->opts.coord_type)
 			return true;
 	}
 	return false;
@@ -68,6 +68,9 @@
 #include "authentication.h"
 #include "path_lock.h"
 #include "xctl.h"
+#include "expiration.h"
+#include "memtx_defrag.h"
+#include "hot_stat.h"
 
 static char status[64] = "unknown";
 
@@ -156,11 +159,31 @@ request_rebind_to_primary_key(struct request *request, struct space *space,
 	request->header = NULL;
 }
 
+/** Account a sampled DML request to its space, index and key. */
+static void
+hot_stat_end_rw(uint64_t sample, struct request *request,
+		struct space *space)
+{
+	const char *key = request->key;
+	const char *key_end = request->key_end;
+	Index *pk = space_index(space, 0);
+	if (key == NULL && request->tuple != NULL && pk != NULL) {
+		/* INSERT, REPLACE and UPSERT: take the primary key. */
+		uint32_t key_size;
+		key = tuple_extract_key_raw(request->tuple, request->tuple_end,
+					    pk->key_def, &key_size);
+		key_end = key != NULL ? key + key_size : NULL;
+	}
+	hot_stat_end_key(sample, request->space_id, request->index_id,
+			 key, key_end);
+}
+
 static void
 process_rw(struct request *request, struct space *space, struct tuple **result)
 {
 	assert(iproto_type_is_dml(request->type));
 	rmean_collect(rmean_box, request->type, 1);
+	uint64_t sample = hot_stat_begin();
 	try {
 		struct txn *txn = txn_begin_stmt(space);
 		access_check_space(space, PRIV_W);
@@ -203,6 +226,9 @@ process_rw(struct request *request, struct space *space, struct tuple **result)
 		default:
 			tuple = NULL;
 		}
+		/* Do not account the WAL write to the request. */
+		if (sample != 0)
+			hot_stat_end_rw(sample, request, space);
 		/*
 		 * Pin the tuple locally before the commit,
 		 * otherwise it may go away during yield in
@@ -408,6 +434,26 @@ box_check_wal_max_size(int64_t wal_max_size)
 	return wal_max_size;
 }
 
+static double
+box_check_expiration_rate_limit(double limit)
+{
+	if (limit < 0) {
+		tnt_raise(ClientError, ER_CFG, "expiration_rate_limit",
+			  "the value must not be negative");
+	}
+	return limit;
+}
+
+static double
+box_check_memtx_defrag_threshold(double threshold)
+{
+	if (threshold < 0 || threshold > 1) {
+		tnt_raise(ClientError, ER_CFG, "memtx_defrag_threshold",
+			  "the value must be between 0 and 1");
+	}
+	return threshold;
+}
+
 void
 box_check_config()
 {
@@ -419,6 +465,8 @@ box_check_config()
 	box_check_wal_max_size(cfg_geti64("wal_max_size"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
 	box_check_memtx_min_tuple_size(cfg_geti64("memtx_min_tuple_size"));
+	box_check_expiration_rate_limit(cfg_getd("expiration_rate_limit"));
+	box_check_memtx_defrag_threshold(cfg_getd("memtx_defrag_threshold"));
 	if (cfg_geti64("vinyl_page_size") > cfg_geti64("vinyl_range_size"))
 		tnt_raise(ClientError, ER_CFG, "vinyl_page_size",
 			  "can't be greater than vinyl_range_size");
@@ -539,6 +587,28 @@ box_set_snap_io_rate_limit(void)
 		memtx->setSnapIoRateLimit(cfg_getd("snap_io_rate_limit"));
 }
 
+void
+box_set_vinyl_io_rate_limit(void)
+{
+	VinylEngine *vinyl = (VinylEngine *) engine_find("vinyl");
+	if (vinyl)
+		vinyl->setIoRateLimit(cfg_getd("vinyl_io_rate_limit"));
+}
+
+void
+box_set_expiration_rate_limit(void)
+{
+	double limit = cfg_getd("expiration_rate_limit");
+	expiration_set_rate_limit(box_check_expiration_rate_limit(limit));
+}
+
+void
+box_set_memtx_defrag_threshold(void)
+{
+	double threshold = cfg_getd("memtx_defrag_threshold");
+	memtx_defrag_set_threshold(box_check_memtx_defrag_threshold(threshold));
+}
+
 void
 box_set_too_long_threshold(void)
 {
@@ -704,8 +774,10 @@ box_select(struct port *port, uint32_t space_id, uint32_t index_id,
 		struct space *space = space_cache_find(space_id);
 		access_check_space(space, PRIV_R);
 		struct txn *txn = txn_begin_ro_stmt(space);
+		uint64_t sample = hot_stat_begin();
 		space->handler->executeSelect(txn, space, index_id, iterator,
 					      offset, limit, key, key_end, port);
+		hot_stat_end_key(sample, space_id, index_id, key, key_end);
 		txn_commit_ro_stmt(txn);
 		return 0;
 	} catch (Exception *e) {
@@ -1057,11 +1129,13 @@ box_process_call(struct request *request, struct obuf *out)
 	}
 
 	int rc;
+	uint64_t sample = hot_stat_begin();
 	if (func && func->def.language == FUNC_LANGUAGE_C) {
 		rc = func_call(func, request, out);
 	} else {
 		rc = box_lua_call(request, out);
 	}
+	hot_stat_end_func(sample, name, name_len);
 
 	if (func && func->def.setuid) {
 		/* Restore original credentials after SUID */
@@ -1352,6 +1426,7 @@ box_free(void)
 		engine_shutdown();
 		wal_thread_stop();
 		xctl_free();
+		hot_stat_free();
 	}
 }
 
@@ -1527,6 +1602,7 @@ box_cfg_xc(void)
 
 	rmean_box = rmean_new(iproto_type_strs, IPROTO_TYPE_STAT_MAX);
 	rmean_error = rmean_new(rmean_error_strings, RMEAN_ERROR_LAST);
+	hot_stat_init();
 
 	xctl_init();
 	engine_init();
@@ -1677,6 +1753,11 @@ box_cfg_xc(void)
 			applier_resume(replica->applier);
 	}
 
+	/* Start deleting expired tuples */
+	expiration_init();
+	/* Start moving tuples out of sparse slabs */
+	memtx_defrag_init();
+
 	title("running");
 	say_info("ready to accept requests");
 
@@ -157,6 +157,9 @@ void box_set_replication(void);
 void box_set_log_level(void);
 void box_set_io_collect_interval(void);
 void box_set_snap_io_rate_limit(void);
+void box_set_vinyl_io_rate_limit(void);
+void box_set_expiration_rate_limit(void);
+void box_set_memtx_defrag_threshold(void);
 void box_set_too_long_threshold(void);
 void box_set_readahead(void);
 void box_set_force_recovery(void);
@@ -40,6 +40,8 @@ struct relay;
 
 enum engine_flags {
 	ENGINE_CAN_BE_TEMPORARY = 1,
+	ENGINE_CAN_EXPIRE = 2,
+	ENGINE_CAN_MMAP_SNAPSHOT = 4,
 };
 
 extern struct rlist engines;
@@ -258,6 +260,18 @@ engine_can_be_temporary(uint32_t flags)
 	return flags & ENGINE_CAN_BE_TEMPORARY;
 }
 
+static inline bool
+engine_can_expire(uint32_t flags)
+{
+	return flags & ENGINE_CAN_EXPIRE;
+}
+
+static inline bool
+engine_can_mmap_snapshot(uint32_t flags)
+{
+	return flags & ENGINE_CAN_MMAP_SNAPSHOT;
+}
+
 static inline uint32_t
 engine_id(Handler *space)
 {
@@ -182,6 +182,7 @@ struct errcode_record {
 	/*127 */_(ER_INDEX_FIELD_COUNT_LIMIT,	"Indexed field count limit reached: %d indexed fields") \
 	/*128 */_(ER_LOCAL_INSTANCE_ID_IS_READ_ONLY, "The local instance id %u is read-only") \
 	/*129 */_(ER_BACKUP_IN_PROGRESS,	"Backup is already in progress") \
+	/*130 */_(ER_INVALID_SNAP_IMAGE,	"Invalid snapshot image %s: %s") \
 
 /*
  * !IMPORTANT! Please follow instructions at start of the file
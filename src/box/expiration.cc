@@ -0,0 +1,346 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "expiration.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "box.h"
+#include "txn.h"
+#include "index.h"
+#include "space.h"
+#include "schema.h"
+#include "tuple.h"
+#include "fiber.h"
+#include "rmean.h"
+#include "say.h"
+#include "msgpuck/msgpuck.h"
+
+enum {
+	/** Max number of tuples deleted in one transaction. */
+	EXPIRATION_BATCH = 100,
+	/** Max size of an encoded backlog key: [now]. */
+	EXPIRATION_KEY_MAX = 16,
+	/** Max number of expired tuples counted per space. */
+	EXPIRATION_BACKLOG_MAX = 10000,
+};
+
+/** Pause between scans when there is nothing to expire, seconds. */
+static const double EXPIRATION_PERIOD = 1.0;
+
+enum expiration_stat_name {
+	EXPIRATION_STAT_EXPIRED,
+	EXPIRATION_STAT_MAX,
+};
+
+static const char *expiration_stat_strs[] = {
+	"EXPIRED",
+};
+
+static struct fiber *expiration_fiber;
+static struct rmean *rmean_expiration;
+static double expiration_limit;
+
+/** Ids of the spaces with ttl_field set, collected for a scan. */
+static uint32_t *expiration_spaces;
+static uint32_t expiration_space_count;
+static uint32_t expiration_space_max;
+
+struct Index *
+space_expiration_index(struct space *space)
+{
+	if (space->def.opts.ttl_field <= 0)
+		return NULL;
+	uint32_t fieldno = space->def.opts.ttl_field - 1;
+	for (uint32_t i = 1; i < space->index_count; i++) {
+		Index *index = space->index[i];
+		struct key_def *key_def = index->key_def;
+		if (key_def->type != TREE ||
+		    key_def->parts[0].fieldno != fieldno)
+			continue;
+		switch (key_def->parts[0].type) {
+		case FIELD_TYPE_UNSIGNED:
+		case FIELD_TYPE_INTEGER:
+		case FIELD_TYPE_NUMBER:
+			return index;
+		default:
+			break;
+		}
+	}
+	return NULL;
+}
+
+void
+expiration_set_rate_limit(double limit)
+{
+	expiration_limit = limit;
+}
+
+double
+expiration_rate_limit(void)
+{
+	return expiration_limit;
+}
+
+static void
+expiration_add_space(struct space *space, void *udata)
+{
+	(void) udata;
+	if (space->def.opts.ttl_field <= 0)
+		return;
+	if (expiration_space_count == expiration_space_max) {
+		uint32_t max = MAX(expiration_space_max * 2, 16);
+		uint32_t *spaces = (uint32_t *)
+			realloc(expiration_spaces, max * sizeof(*spaces));
+		if (spaces == NULL)
+			return;
+		expiration_spaces = spaces;
+		expiration_space_max = max;
+	}
+	expiration_spaces[expiration_space_count++] = space_id(space);
+}
+
+/**
+ * Collect the ids of the spaces to expire. The spaces are
+ * looked up by id again before each batch, since they may be
+ * altered or dropped while the scan yields.
+ */
+static void
+expiration_collect_spaces(void)
+{
+	expiration_space_count = 0;
+	space_foreach(expiration_add_space, NULL);
+}
+
+/**
+ * Get the expiration time stored in a field.
+ * @retval false the field is not a number
+ */
+static bool
+expiration_field_time(const char *field, double *time)
+{
+	switch (mp_typeof(*field)) {
+	case MP_UINT:
+		*time = mp_decode_uint(&field);
+		return true;
+	case MP_INT:
+		*time = mp_decode_int(&field);
+		return true;
+	case MP_FLOAT:
+		*time = mp_decode_float(&field);
+		return true;
+	case MP_DOUBLE:
+		*time = mp_decode_double(&field);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Delete at most @a limit tuples of a space which expired by
+ * @a now, in a single transaction.
+ * @retval >= 0 the number of deleted tuples
+ * @retval -1 error, the diagnostics area is set
+ */
+static int
+expiration_delete_batch(uint32_t space_id, uint32_t index_id,
+			uint32_t fieldno, double now, int limit)
+{
+	const char *keys[EXPIRATION_BATCH];
+	const char *key_ends[EXPIRATION_BATCH];
+	int count = 0;
+	char key[1];
+	mp_encode_array(key, 0);
+	box_iterator_t *it = box_index_iterator(space_id, index_id, ITER_ALL,
+						key, key + sizeof(key));
+	if (it == NULL)
+		return -1;
+	while (count < limit) {
+		box_tuple_t *tuple;
+		if (box_iterator_next(it, &tuple) != 0) {
+			box_iterator_free(it);
+			return -1;
+		}
+		if (tuple == NULL)
+			break;
+		const char *field = box_tuple_field(tuple, fieldno);
+		double time;
+		if (field == NULL || !expiration_field_time(field, &time) ||
+		    time > now)
+			break;
+		uint32_t key_size;
+		keys[count] = box_tuple_extract_key(tuple, space_id, 0,
+						    &key_size);
+		if (keys[count] == NULL) {
+			box_iterator_free(it);
+			return -1;
+		}
+		key_ends[count] = keys[count] + key_size;
+		count++;
+	}
+	box_iterator_free(it);
+	if (count == 0)
+		return 0;
+	/*
+	 * Nothing yields between the scan and the deletes, so
+	 * the tuples are still there and still expired.
+	 */
+	if (box_txn_begin() != 0)
+		return -1;
+	for (int i = 0; i < count; i++) {
+		if (box_delete(space_id, 0, keys[i], key_ends[i], NULL) != 0) {
+			box_txn_rollback();
+			return -1;
+		}
+	}
+	if (box_txn_commit() != 0)
+		return -1;
+	return count;
+}
+
+/**
+ * Delete a batch of expired tuples from each space with
+ * ttl_field set.
+ * @retval true some of the spaces may have more tuples to expire
+ */
+static bool
+expiration_run(void)
+{
+	bool has_more = false;
+	expiration_collect_spaces();
+	for (uint32_t i = 0; i < expiration_space_count; i++) {
+		if (fiber_is_cancelled() || box_is_ro())
+			break;
+		struct space *space = space_by_id(expiration_spaces[i]);
+		if (space == NULL)
+			continue;
+		Index *index = space_expiration_index(space);
+		if (index == NULL)
+			continue;
+		int limit = EXPIRATION_BATCH;
+		if (expiration_limit > 0 && expiration_limit < limit)
+			limit = MAX((int) expiration_limit, 1);
+		int count = expiration_delete_batch(space_id(space),
+						    index->key_def->iid,
+						    space->def.opts.ttl_field - 1,
+						    fiber_time(), limit);
+		fiber_gc();
+		if (count < 0) {
+			error_log(diag_last_error(diag_get()));
+			continue;
+		}
+		rmean_collect(rmean_expiration, EXPIRATION_STAT_EXPIRED, count);
+		if (count == limit)
+			has_more = true;
+		/* Yield between batches, keeping up with the limit. */
+		if (expiration_limit > 0)
+			fiber_sleep(count / expiration_limit);
+		else
+			fiber_sleep(0);
+	}
+	return has_more;
+}
+
+static int
+expiration_f(va_list ap)
+{
+	(void) ap;
+	while (! fiber_is_cancelled()) {
+		double delay = EXPIRATION_PERIOD;
+		if (! box_is_ro() && expiration_run())
+			delay = 0;
+		fiber_sleep(delay);
+	}
+	return 0;
+}
+
+/**
+ * Count the tuples of a space which expired by now but are not
+ * deleted yet and add them to the backlog. This is done in tx
+ * thread on each box.info.expiration() call, so to bound the
+ * cost, counting stops at EXPIRATION_BACKLOG_MAX tuples.
+ */
+static void
+expiration_add_backlog(struct space *space, void *udata)
+{
+	struct expiration_stat *stat = (struct expiration_stat *) udata;
+	Index *index = space_expiration_index(space);
+	if (index == NULL)
+		return;
+	double now = fiber_time();
+	char key[EXPIRATION_KEY_MAX];
+	char *key_end = mp_encode_array(key, 1);
+	if (index->key_def->parts[0].type == FIELD_TYPE_NUMBER)
+		key_end = mp_encode_double(key_end, now);
+	else if (now >= 0)
+		key_end = mp_encode_uint(key_end, (uint64_t) now);
+	else
+		return;
+	box_iterator_t *it = box_index_iterator(space_id(space),
+						index->key_def->iid,
+						ITER_LE, key, key_end);
+	if (it == NULL)
+		return;
+	box_tuple_t *tuple;
+	int count = 0;
+	while (count < EXPIRATION_BACKLOG_MAX &&
+	       box_iterator_next(it, &tuple) == 0 && tuple != NULL)
+		count++;
+	box_iterator_free(it);
+	stat->backlog += count;
+}
+
+void
+expiration_stat(struct expiration_stat *stat)
+{
+	memset(stat, 0, sizeof(*stat));
+	if (rmean_expiration == NULL)
+		return;
+	stat->expired = rmean_total(rmean_expiration,
+				    EXPIRATION_STAT_EXPIRED);
+	stat->rps = rmean_mean(rmean_expiration, EXPIRATION_STAT_EXPIRED);
+	/* Counting does not yield in memtx, iterate in place. */
+	space_foreach(expiration_add_backlog, stat);
+}
+
+void
+expiration_init(void)
+{
+	rmean_expiration = rmean_new(expiration_stat_strs,
+				     EXPIRATION_STAT_MAX);
+	if (rmean_expiration == NULL)
+		panic("failed to allocate expiration statistics");
+	expiration_fiber = fiber_new("expiration", expiration_f);
+	if (expiration_fiber == NULL)
+		panic("failed to start expiration fiber");
+	fiber_start(expiration_fiber);
+}
@@ -0,0 +1,95 @@
+#ifndef INCLUDES_TARANTOOL_BOX_EXPIRATION_H
+#define INCLUDES_TARANTOOL_BOX_EXPIRATION_H
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct space;
+struct Index;
+
+/**
+ * Expiration of tuples by time.
+ *
+ * A space with ttl_field option set keeps in that field the
+ * time, in seconds since the Epoch, after which the tuple is
+ * no longer needed. A built-in fiber periodically walks a TREE
+ * index starting with this field and deletes expired tuples in
+ * small batches, yielding between them. The deletes are regular
+ * requests: they are written to WAL and replicated.
+ */
+
+/** Expiration statistics, see box.info.expiration(). */
+struct expiration_stat {
+	/** Total number of tuples deleted since start. */
+	int64_t expired;
+	/** Tuples deleted per second, averaged. */
+	int64_t rps;
+	/**
+	 * Number of expired tuples not deleted yet, counted
+	 * up to 10000 per space.
+	 */
+	int64_t backlog;
+};
+
+/**
+ * Find the index used to expire tuples of the space, i.e. the
+ * first secondary TREE index whose first part is ttl_field.
+ * @retval NULL if the space has no ttl_field or no such index.
+ */
+struct Index *
+space_expiration_index(struct space *space);
+
+/** Limit the number of tuples deleted per second, 0 - no limit. */
+void
+expiration_set_rate_limit(double limit);
+
+/** Get the rate limit set by expiration_set_rate_limit(). */
+double
+expiration_rate_limit(void);
+
+/** Collect expiration statistics. */
+void
+expiration_stat(struct expiration_stat *stat);
+
+/** Start the expiration fiber, called when box is configured. */
+void
+expiration_init(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_EXPIRATION_H */
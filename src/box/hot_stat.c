@@ -0,0 +1,334 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "hot_stat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "assoc.h"
+#include "say.h"
+#include "salad/wyhash.h"
+
+#define HEAP_FORWARD_DECLARATION
+#include "salad/heap.h"
+
+enum {
+	/** Count-min sketch dimensions. */
+	HOT_STAT_CMS_DEPTH = 4,
+	HOT_STAT_CMS_WIDTH = 4096,
+	/** Max size of a key or a function name kept in the top. */
+	HOT_STAT_DATA_MAX = 128,
+};
+
+/** An entry of the top of hot keys or functions. */
+struct hot_stat_entry {
+	/** Link in the min-heap of the top, by count. */
+	struct heap_node in_top;
+	/** Hash of the key, identifies the entry. */
+	uint64_t hash;
+	/** Public part, data points to the buffer below. */
+	struct hot_stat_item item;
+	char buf[HOT_STAT_DATA_MAX];
+};
+
+#define HEAP_NAME hot_stat_heap
+
+static bool
+hot_stat_entry_less(struct heap_node *a, struct heap_node *b)
+{
+	struct hot_stat_entry *left =
+		container_of(a, struct hot_stat_entry, in_top);
+	struct hot_stat_entry *right =
+		container_of(b, struct hot_stat_entry, in_top);
+	return left->item.count < right->item.count;
+}
+
+#define HEAP_LESS(h, l, r) hot_stat_entry_less(l, r)
+
+#include "salad/heap.h"
+
+#undef HEAP_LESS
+#undef HEAP_NAME
+
+/** The hottest keys or functions seen so far. */
+struct hot_stat_top {
+	/** Min-heap of the entries, the top is the coldest one. */
+	heap_t heap;
+	struct hot_stat_entry entries[HOT_STAT_TOP_MAX];
+	uint32_t size;
+};
+
+int hot_stat_countdown = HOT_STAT_SAMPLE_PERIOD;
+
+/** State of the generator of sampling intervals. */
+static uint64_t hot_stat_rand = 0x9e3779b97f4a7c15ULL;
+/** Sampled CPU time per index, (index_id << 32 | space_id) => object. */
+static struct mh_i64ptr_t *hot_stat_objects;
+/** Count-min sketch of the number of samples per key. */
+static uint32_t hot_stat_cms[HOT_STAT_CMS_DEPTH][HOT_STAT_CMS_WIDTH];
+static struct hot_stat_top hot_stat_keys;
+static struct hot_stat_top hot_stat_funcs;
+
+uint64_t
+hot_stat_sample(void)
+{
+	/*
+	 * Randomize the interval, so that requests which come
+	 * in a fixed order are sampled evenly. xorshift64.
+	 */
+	hot_stat_rand ^= hot_stat_rand << 13;
+	hot_stat_rand ^= hot_stat_rand >> 7;
+	hot_stat_rand ^= hot_stat_rand << 17;
+	hot_stat_countdown = 1 + hot_stat_rand % (2 * HOT_STAT_SAMPLE_PERIOD - 1);
+	if (hot_stat_objects == NULL)
+		return 0;
+	uint64_t now = clock_thread64();
+	return now != 0 ? now : 1;
+}
+
+/** Elapsed time of a sample scaled to all requests it stands for. */
+static uint64_t
+hot_stat_elapsed(uint64_t start)
+{
+	uint64_t now = clock_thread64();
+	return (now > start ? now - start : 0) * HOT_STAT_SAMPLE_PERIOD;
+}
+
+/**
+ * Add a sample of a key to the count-min sketch.
+ * @return the estimated number of samples of the key
+ */
+static uint32_t
+hot_stat_cms_add(uint64_t hash)
+{
+	uint32_t h1 = (uint32_t) hash;
+	uint32_t h2 = (uint32_t) (hash >> 32) | 1;
+	uint32_t estimate = UINT32_MAX;
+	for (int i = 0; i < HOT_STAT_CMS_DEPTH; i++) {
+		uint32_t *counter =
+			&hot_stat_cms[i][(h1 + i * h2) % HOT_STAT_CMS_WIDTH];
+		if (*counter < UINT32_MAX)
+			++*counter;
+		estimate = MIN(estimate, *counter);
+	}
+	return estimate;
+}
+
+static void
+hot_stat_top_create(struct hot_stat_top *top)
+{
+	hot_stat_heap_create(&top->heap);
+	top->size = 0;
+}
+
+static void
+hot_stat_top_destroy(struct hot_stat_top *top)
+{
+	hot_stat_heap_destroy(&top->heap);
+}
+
+/**
+ * Account a sample of a key to the top: update the entry of
+ * the key, or make it replace the coldest entry if the key is
+ * now estimated to be hotter.
+ */
+static void
+hot_stat_top_add(struct hot_stat_top *top, uint64_t hash,
+		 uint32_t space_id, uint32_t index_id,
+		 const char *data, uint32_t size, uint64_t time)
+{
+	uint64_t count = (uint64_t) hot_stat_cms_add(hash) *
+			 HOT_STAT_SAMPLE_PERIOD;
+	struct hot_stat_entry *entry;
+	for (uint32_t i = 0; i < top->size; i++) {
+		entry = &top->entries[i];
+		if (entry->hash == hash && entry->item.space_id == space_id &&
+		    entry->item.index_id == index_id) {
+			entry->item.count = count;
+			entry->item.time += time;
+			hot_stat_heap_update(&top->heap, &entry->in_top);
+			return;
+		}
+	}
+	bool is_new = top->size < HOT_STAT_TOP_MAX;
+	if (is_new) {
+		entry = &top->entries[top->size];
+	} else {
+		entry = container_of(hot_stat_heap_top(&top->heap),
+				     struct hot_stat_entry, in_top);
+		if (entry->item.count >= count)
+			return;
+	}
+	entry->hash = hash;
+	entry->item.space_id = space_id;
+	entry->item.index_id = index_id;
+	entry->item.count = count;
+	entry->item.time = time;
+	if (data != NULL && size <= HOT_STAT_DATA_MAX) {
+		memcpy(entry->buf, data, size);
+		entry->item.data = entry->buf;
+		entry->item.size = size;
+	} else {
+		entry->item.data = NULL;
+		entry->item.size = 0;
+	}
+	if (! is_new) {
+		hot_stat_heap_update(&top->heap, &entry->in_top);
+		return;
+	}
+	if (hot_stat_heap_insert(&top->heap, &entry->in_top) == 0)
+		top->size++;
+}
+
+static int
+hot_stat_entry_cmp(const void *a, const void *b)
+{
+	const struct hot_stat_entry *left = *(const struct hot_stat_entry **) a;
+	const struct hot_stat_entry *right = *(const struct hot_stat_entry **) b;
+	if (left->item.count != right->item.count)
+		return left->item.count > right->item.count ? -1 : 1;
+	return 0;
+}
+
+static void
+hot_stat_top_foreach(struct hot_stat_top *top, hot_stat_item_cb cb,
+		     void *arg)
+{
+	struct hot_stat_entry *sorted[HOT_STAT_TOP_MAX];
+	for (uint32_t i = 0; i < top->size; i++)
+		sorted[i] = &top->entries[i];
+	qsort(sorted, top->size, sizeof(*sorted), hot_stat_entry_cmp);
+	for (uint32_t i = 0; i < top->size; i++)
+		cb(&sorted[i]->item, arg);
+}
+
+void
+hot_stat_record_key(uint64_t start, uint32_t space_id, uint32_t index_id,
+		    const char *key, const char *key_end)
+{
+	uint64_t time = hot_stat_elapsed(start);
+	uint64_t id = (uint64_t) index_id << 32 | space_id;
+	struct hot_stat_object *object;
+	mh_int_t k = mh_i64ptr_find(hot_stat_objects, id, NULL);
+	if (k != mh_end(hot_stat_objects)) {
+		object = (struct hot_stat_object *)
+			mh_i64ptr_node(hot_stat_objects, k)->val;
+	} else {
+		object = (struct hot_stat_object *) calloc(1, sizeof(*object));
+		if (object == NULL)
+			return;
+		object->space_id = space_id;
+		object->index_id = index_id;
+		struct mh_i64ptr_node_t node = { id, object };
+		if (mh_i64ptr_put(hot_stat_objects, &node,
+				  NULL, NULL) == mh_end(hot_stat_objects)) {
+			free(object);
+			return;
+		}
+	}
+	object->count += HOT_STAT_SAMPLE_PERIOD;
+	object->time += time;
+	if (key == NULL)
+		return;
+	uint32_t size = key_end - key;
+	hot_stat_top_add(&hot_stat_keys, wyhash(key, size, id),
+			 space_id, index_id, key, size, time);
+}
+
+void
+hot_stat_record_func(uint64_t start, const char *name, uint32_t name_len)
+{
+	uint64_t time = hot_stat_elapsed(start);
+	/* Do not mix functions with keys of space 0 in the sketch. */
+	hot_stat_top_add(&hot_stat_funcs, wyhash(name, name_len, UINT64_MAX),
+			 0, 0, name, name_len, time);
+}
+
+void
+hot_stat_foreach_object(hot_stat_object_cb cb, void *arg)
+{
+	if (hot_stat_objects == NULL)
+		return;
+	mh_int_t k;
+	mh_foreach(hot_stat_objects, k)
+		cb(mh_i64ptr_node(hot_stat_objects, k)->val, arg);
+}
+
+void
+hot_stat_foreach_key(hot_stat_item_cb cb, void *arg)
+{
+	hot_stat_top_foreach(&hot_stat_keys, cb, arg);
+}
+
+void
+hot_stat_foreach_func(hot_stat_item_cb cb, void *arg)
+{
+	hot_stat_top_foreach(&hot_stat_funcs, cb, arg);
+}
+
+void
+hot_stat_reset(void)
+{
+	if (hot_stat_objects != NULL) {
+		mh_int_t k;
+		mh_foreach(hot_stat_objects, k)
+			free(mh_i64ptr_node(hot_stat_objects, k)->val);
+		mh_i64ptr_clear(hot_stat_objects);
+	}
+	memset(hot_stat_cms, 0, sizeof(hot_stat_cms));
+	hot_stat_top_destroy(&hot_stat_keys);
+	hot_stat_top_create(&hot_stat_keys);
+	hot_stat_top_destroy(&hot_stat_funcs);
+	hot_stat_top_create(&hot_stat_funcs);
+}
+
+void
+hot_stat_init(void)
+{
+	hot_stat_objects = mh_i64ptr_new();
+	if (hot_stat_objects == NULL)
+		panic("failed to allocate hot stat hash");
+	hot_stat_top_create(&hot_stat_keys);
+	hot_stat_top_create(&hot_stat_funcs);
+}
+
+void
+hot_stat_free(void)
+{
+	if (hot_stat_objects == NULL)
+		return;
+	hot_stat_reset();
+	mh_i64ptr_delete(hot_stat_objects);
+	hot_stat_objects = NULL;
+	hot_stat_top_destroy(&hot_stat_keys);
+	hot_stat_top_destroy(&hot_stat_funcs);
+}
@@ -0,0 +1,169 @@
+#ifndef INCLUDES_TARANTOOL_BOX_HOT_STAT_H
+#define INCLUDES_TARANTOOL_BOX_HOT_STAT_H
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trivia/util.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Sampling profiler of the requests served by the tx thread.
+ *
+ * Roughly one of HOT_STAT_SAMPLE_PERIOD requests is sampled:
+ * the tx thread CPU time spent on it is measured and accounted
+ * to its space and index, and its key or function name is fed
+ * to a count-min sketch. The keys and functions with the
+ * highest estimates are kept in a small top list. All counters
+ * are scaled by the sampling period, so they are estimates of
+ * the real numbers. A request which is not sampled costs a
+ * decrement and a branch.
+ */
+
+enum {
+	/** On average, one of that many requests is sampled. */
+	HOT_STAT_SAMPLE_PERIOD = 16,
+	/** The number of hottest keys and functions kept. */
+	HOT_STAT_TOP_MAX = 32,
+};
+
+/** Statistics of an index. */
+struct hot_stat_object {
+	uint32_t space_id;
+	uint32_t index_id;
+	/** Estimated number of requests. */
+	uint64_t count;
+	/** Estimated tx thread CPU time, in nanoseconds. */
+	uint64_t time;
+};
+
+/** A hot key or a hot function. */
+struct hot_stat_item {
+	/** Space and index ids of a key, 0 for a function. */
+	uint32_t space_id;
+	uint32_t index_id;
+	/**
+	 * MsgPack key or function name. NULL if the key is too
+	 * long to be kept.
+	 */
+	const char *data;
+	uint32_t size;
+	/** Estimated number of requests. */
+	uint64_t count;
+	/** Estimated tx thread CPU time, in nanoseconds. */
+	uint64_t time;
+};
+
+/** Requests left to skip before the next sample. */
+extern int hot_stat_countdown;
+
+/** Take a sample, see hot_stat_begin(). */
+uint64_t
+hot_stat_sample(void);
+
+/**
+ * Called when a request starts.
+ * @retval 0 the request is not sampled
+ * @retval the tx thread CPU time, to be passed to
+ *         hot_stat_end_*() when the request ends
+ */
+static inline uint64_t
+hot_stat_begin(void)
+{
+	if (likely(--hot_stat_countdown > 0))
+		return 0;
+	return hot_stat_sample();
+}
+
+void
+hot_stat_record_key(uint64_t start, uint32_t space_id, uint32_t index_id,
+		    const char *key, const char *key_end);
+
+void
+hot_stat_record_func(uint64_t start, const char *name, uint32_t name_len);
+
+/**
+ * Account a request to a space and an index and a key, which
+ * is a MsgPack array and may be NULL.
+ */
+static inline void
+hot_stat_end_key(uint64_t start, uint32_t space_id, uint32_t index_id,
+		 const char *key, const char *key_end)
+{
+	if (start != 0)
+		hot_stat_record_key(start, space_id, index_id, key, key_end);
+}
+
+/** Account a request to a stored function. */
+static inline void
+hot_stat_end_func(uint64_t start, const char *name, uint32_t name_len)
+{
+	if (start != 0)
+		hot_stat_record_func(start, name, name_len);
+}
+
+typedef void
+(*hot_stat_object_cb)(const struct hot_stat_object *object, void *arg);
+
+typedef void
+(*hot_stat_item_cb)(const struct hot_stat_item *item, void *arg);
+
+/** Invoke a callback for each index which served requests. */
+void
+hot_stat_foreach_object(hot_stat_object_cb cb, void *arg);
+
+/** Invoke a callback for each hot key, the hottest first. */
+void
+hot_stat_foreach_key(hot_stat_item_cb cb, void *arg);
+
+/** Invoke a callback for each hot function, the hottest first. */
+void
+hot_stat_foreach_func(hot_stat_item_cb cb, void *arg);
+
+/** Forget everything collected so far. */
+void
+hot_stat_reset(void);
+
+void
+hot_stat_init(void);
+
+void
+hot_stat_free(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_HOT_STAT_H */
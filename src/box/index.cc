@@ -493,27 +493,36 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	}
 }
 
+/**
+ * Check that the index the iterator was created for has not
+ * been altered or dropped since the last call.
+ */
+static bool
+box_iterator_is_valid(box_iterator_t *itr)
+{
+	if (itr->sc_version == sc_version)
+		return true;
+	try {
+		struct space *space;
+		/* no tx management */
+		Index *index = check_index(itr->space_id, itr->index_id,
+					   &space);
+		if (index != itr->index)
+			return false;
+		if (index->sc_version > itr->sc_version)
+			return false;
+		itr->sc_version = sc_version;
+		return true;
+	} catch (Exception *) {
+		return false;
+	}
+}
+
 int
 box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 {
 	assert(result != NULL);
-	try {
-		if (itr->sc_version != sc_version) {
-			struct space *space;
-			/* no tx management */
-			Index *index = check_index(itr->space_id, itr->index_id,
-						   &space);
-			if (index != itr->index) {
-				*result = NULL;
-				return 0;
-			}
-			if (index->sc_version > itr->sc_version) {
-				*result = NULL; /* invalidate iterator */
-				return 0;
-			}
-			itr->sc_version = sc_version;
-		}
-	} catch (Exception *) {
+	if (!box_iterator_is_valid(itr)) {
 		*result = NULL;
 		return 0; /* invalidate iterator */
 	}
@@ -526,6 +535,30 @@ box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 	}
 }
 
+int
+box_iterator_next_batch(box_iterator_t *itr, box_tuple_t **result,
+			uint32_t count)
+{
+	assert(result != NULL);
+	if (!box_iterator_is_valid(itr))
+		return 0; /* invalidate iterator */
+	uint32_t n = 0;
+	try {
+		for (; n < count; n++) {
+			struct tuple *tuple = itr->next(itr);
+			if (tuple == NULL)
+				break;
+			tuple_ref_xc(tuple);
+			result[n] = tuple;
+		}
+		return n;
+	} catch (Exception *) {
+		for (uint32_t i = 0; i < n; i++)
+			tuple_unref(result[i]);
+		return -1;
+	}
+}
+
 void
 box_iterator_free(box_iterator_t *it)
 {
@@ -122,6 +122,26 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 int
 box_iterator_next(box_iterator_t *iterator, box_tuple_t **result);
 
+/**
+ * Retrieve up to \a count next items from the \a iterator.
+ *
+ * Unlike box_iterator_next(), every returned tuple is referenced
+ * and must be released with box_tuple_unref() by the caller.
+ * Fetching tuples in batches amortizes the per-call overhead of
+ * the iterator API, which dominates full scans from Lua and C
+ * modules.
+ *
+ * \param iterator an iterator returned by box_index_iterator().
+ * \param[out] result an array of at least \a count tuples.
+ * \param count the maximal number of tuples to retrieve.
+ * \retval -1 on error (check box_error_last() for details)
+ * \retval the number of retrieved tuples otherwise. A value less
+ * than \a count means the end of data.
+ */
+int
+box_iterator_next_batch(box_iterator_t *iterator, box_tuple_t **result,
+			uint32_t count);
+
 /**
  * Destroy and deallocate iterator.
  *
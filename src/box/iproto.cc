@@ -62,6 +62,26 @@
 /* The number of iproto messages in flight */
 enum { IPROTO_MSG_MAX = 768 };
 
+/*
+ * The part of IPROTO_MSG_MAX which can only be used by
+ * high priority connections.
+ */
+enum { IPROTO_MSG_HIGH_RESERVE = 128 };
+
+/*
+ * The number of messages in flight a single bulk connection
+ * may have, so that a client pipelining lots of heavy requests
+ * can not occupy the whole message budget. High priority
+ * connections are only limited by IPROTO_MSG_MAX.
+ */
+enum { IPROTO_CONNECTION_MSG_MAX = IPROTO_MSG_MAX / 4 };
+
+/*
+ * The number of idle iobufs kept warm in the net thread
+ * for reuse by any connection.
+ */
+enum { IPROTO_IOBUF_CACHE_MAX = 64 };
+
 /* {{{ iproto_msg - declaration */
 
 /**
@@ -98,6 +118,13 @@ struct iproto_msg: public cmsg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/** Admission class the request was accounted in. */
+	uint8_t queue;
+	/**
+	 * Priority of the connection session after the request
+	 * was processed, set in tx thread.
+	 */
+	uint8_t priority;
 };
 
 static struct mempool iproto_msg_pool;
@@ -164,6 +191,8 @@ enum rmean_net_name {
 
 const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
 
+const char *iproto_priority_strs[] = { "BULK", "HIGH" };
+
 /** Context of a single client connection. */
 struct iproto_connection
 {
@@ -173,6 +202,11 @@ struct iproto_connection
 	 * iobuf[0] is moved to iobuf[1], for flushing. As soon as
 	 * all output in iobuf[1].out is sent to the client, iobuf[1]
 	 * and iobuf[0] are moved around again.
+	 *
+	 * The buffers are taken from the iobuf cache only while
+	 * there is data in flight and are returned to it as soon
+	 * as they become idle, so either of them may be NULL.
+	 * This way an idle connection holds no buffer memory.
 	 */
 	struct iobuf *iobuf[2];
 	/*
@@ -195,22 +229,162 @@ struct iproto_connection
 	/* Pre-allocated disconnect msg. */
 	struct iproto_msg *disconnect;
 	struct rlist in_stop_list;
+	/** Admission class, enum iproto_priority. */
+	uint8_t priority;
+	/** The number of requests of the connection in flight. */
+	int n_msgs;
+	/**
+	 * True if input is stopped because the connection has
+	 * too many requests in flight. Input is resumed by
+	 * a reply to one of them.
+	 */
+	bool is_throttled;
 };
 
 static struct mempool iproto_connection_pool;
-static RLIST_HEAD(stopped_connections);
+/** Connections waiting for admission, per class. */
+static struct rlist stopped_connections[iproto_priority_MAX];
+/** The number of requests in flight, per class. */
+static size_t iproto_queue[iproto_priority_MAX];
+/** The number of stopped connections, per class. */
+static size_t iproto_stopped[iproto_priority_MAX];
+
+size_t
+iproto_queue_size(enum iproto_priority priority)
+{
+	return iproto_queue[priority];
+}
+
+size_t
+iproto_stopped_count(enum iproto_priority priority)
+{
+	return iproto_stopped[priority];
+}
+
+/** {{{ iobuf cache */
+
+/**
+ * Idle iobufs shared by all connections of the net thread.
+ * The buffers keep their memory, so a connection which
+ * becomes active again does not have to allocate it anew.
+ */
+static RLIST_HEAD(iobuf_cache);
+static int iobuf_cache_size;
+/** The number of iobufs taken by connections. */
+static int iobuf_used_count;
+
+size_t
+iproto_iobuf_used()
+{
+	return iobuf_used_count;
+}
+
+size_t
+iproto_iobuf_cached()
+{
+	return iobuf_cache_size;
+}
+
+static void
+tx_process_iobuf_delete(struct cmsg *msg);
+static void
+net_finish_iobuf_delete(struct cmsg *msg);
+
+static const struct cmsg_hop iobuf_delete_route[] = {
+	{ tx_process_iobuf_delete, &net_pipe },
+	{ net_finish_iobuf_delete, NULL },
+};
+
+/** Take an iobuf from the cache or create a new one. */
+static struct iobuf *
+iobuf_cache_get()
+{
+	struct iobuf *iobuf;
+	if (rlist_empty(&iobuf_cache)) {
+		iobuf = iobuf_new_mt(&tx_cord->slabc);
+	} else {
+		iobuf = rlist_shift_entry(&iobuf_cache, struct iobuf,
+					  in_cache);
+		iobuf_cache_size--;
+	}
+	iobuf_used_count++;
+	return iobuf;
+}
 
 /**
- * Returns true if we have enough spare messages
- * in the message pool. Disconnect messages are
- * discounted: they are mostly reserved and idle.
+ * Return an idle iobuf to the cache. If the cache is full,
+ * the buffer is destroyed: its output buffer belongs to tx
+ * thread, so it is freed there. Never throws.
+ */
+static void
+iobuf_cache_put(struct iobuf *iobuf)
+{
+	assert(iobuf_is_idle(iobuf));
+	iobuf_used_count--;
+	iobuf_reset_mt(iobuf);
+	if (iobuf_cache_size >= IPROTO_IOBUF_CACHE_MAX) {
+		struct iproto_msg *msg = (struct iproto_msg *)
+			mempool_alloc(&iproto_msg_pool);
+		if (msg != NULL) {
+			/* Release input memory right away. */
+			ibuf_reinit(&iobuf->in);
+			msg->connection = NULL;
+			msg->iobuf = iobuf;
+			cmsg_init(msg, iobuf_delete_route);
+			cpipe_push(&tx_pipe, msg);
+			return;
+		}
+		/* Keep the buffer cached rather than leak it. */
+	}
+	rlist_add(&iobuf_cache, &iobuf->in_cache);
+	iobuf_cache_size++;
+}
+
+/** Free the output buffer of an evicted iobuf in tx thread. */
+static void
+tx_process_iobuf_delete(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	obuf_destroy(&msg->iobuf->out);
+}
+
+static void
+net_finish_iobuf_delete(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	iobuf_delete_mt(msg->iobuf);
+	iproto_msg_delete(msg);
+}
+
+/** }}} */
+
+/**
+ * Returns true if there are not enough spare messages
+ * in the message pool for a connection of the given class.
+ * Disconnect messages are discounted: they are mostly
+ * reserved and idle.
  */
 static inline bool
-iproto_stop_input()
+iproto_stop_input(uint8_t priority)
 {
 	size_t connection_count = mempool_count(&iproto_connection_pool);
 	size_t request_count = mempool_count(&iproto_msg_pool);
-	return request_count > connection_count + IPROTO_MSG_MAX;
+	size_t limit = connection_count + IPROTO_MSG_MAX;
+	if (priority == IPROTO_PRIORITY_BULK)
+		limit -= IPROTO_MSG_HIGH_RESERVE;
+	return request_count > limit;
+}
+
+/**
+ * Returns true if the connection has too many requests
+ * in flight and must wait for replies before enqueueing
+ * more.
+ */
+static inline bool
+iproto_connection_is_full(struct iproto_connection *con)
+{
+	return con->priority == IPROTO_PRIORITY_BULK &&
+		con->n_msgs >= IPROTO_CONNECTION_MSG_MAX;
 }
 
 /**
@@ -224,17 +398,19 @@ iproto_resume()
 {
 	/*
 	 * Most of the time we have nothing to do here: throttling
-	 * is not active.
+	 * is not active. High priority connections go first, the
+	 * connections of the same class are resumed in turn.
 	 */
-	if (rlist_empty(&stopped_connections))
-		return;
-	if (iproto_stop_input())
+	for (int i = iproto_priority_MAX - 1; i >= 0; i--) {
+		struct rlist *list = &stopped_connections[i];
+		if (rlist_empty(list) || iproto_stop_input(i))
+			continue;
+		struct iproto_connection *con;
+		con = rlist_first_entry(list, struct iproto_connection,
+					in_stop_list);
+		ev_feed_event(con->loop, &con->input, EV_READ);
 		return;
-
-	struct iproto_connection *con;
-	con = rlist_first_entry(&stopped_connections, struct iproto_connection,
-				in_stop_list);
-	ev_feed_event(con->loop, &con->input, EV_READ);
+	}
 }
 
 /**
@@ -255,8 +431,26 @@ iproto_resume()
 static inline bool
 iproto_connection_is_idle(struct iproto_connection *con)
 {
-	return ibuf_used(&con->iobuf[0]->in) == 0 &&
-		ibuf_used(&con->iobuf[1]->in) == 0;
+	return (con->iobuf[0] == NULL || ibuf_used(&con->iobuf[0]->in) == 0) &&
+		(con->iobuf[1] == NULL || ibuf_used(&con->iobuf[1]->in) == 0);
+}
+
+/**
+ * Return the buffers which have no data in flight to the
+ * iobuf cache. Called whenever input or output of
+ * the connection drains.
+ */
+static inline void
+iproto_connection_gc_iobuf(struct iproto_connection *con)
+{
+	for (int i = 0; i < 2; i++) {
+		struct iobuf *iobuf = con->iobuf[i];
+		if (iobuf != NULL && iobuf_is_idle(iobuf)) {
+			assert(i != 0 || con->parse_size == 0);
+			con->iobuf[i] = NULL;
+			iobuf_cache_put(iobuf);
+		}
+	}
 }
 
 static inline void
@@ -264,7 +458,18 @@ iproto_connection_stop(struct iproto_connection *con)
 {
 	assert(rlist_empty(&con->in_stop_list));
 	ev_io_stop(con->loop, &con->input);
-	rlist_add_tail(&stopped_connections, &con->in_stop_list);
+	rlist_add_tail(&stopped_connections[con->priority], &con->in_stop_list);
+	iproto_stopped[con->priority]++;
+}
+
+/** Remove the connection from the list of stopped ones, if it's there. */
+static inline void
+iproto_connection_unstop(struct iproto_connection *con)
+{
+	if (rlist_empty(&con->in_stop_list))
+		return;
+	rlist_del(&con->in_stop_list);
+	iproto_stopped[con->priority]--;
 }
 
 static void
@@ -286,8 +491,12 @@ iproto_connection_delete(struct iproto_connection *con)
 	 * The output buffers must have been deleted
 	 * in tx thread.
 	 */
-	iobuf_delete_mt(con->iobuf[0]);
-	iobuf_delete_mt(con->iobuf[1]);
+	for (int i = 0; i < 2; i++) {
+		if (con->iobuf[i] != NULL) {
+			iobuf_delete_mt(con->iobuf[i]);
+			iobuf_used_count--;
+		}
+	}
 	if (con->disconnect)
 		iproto_msg_delete(con->disconnect);
 	mempool_free(&iproto_connection_pool, con);
@@ -332,11 +541,15 @@ tx_process_disconnect(struct cmsg *m)
 		con->session = NULL; /* safety */
 	}
 	/*
-	 * Got to be done in iproto thread since
+	 * Got to be done in tx thread since
 	 * that's where the memory is allocated.
+	 * Buffers which went idle before the connection
+	 * was closed are already back in the iobuf cache.
 	 */
-	obuf_destroy(&con->iobuf[0]->out);
-	obuf_destroy(&con->iobuf[1]->out);
+	if (con->iobuf[0] != NULL)
+		obuf_destroy(&con->iobuf[0]->out);
+	if (con->iobuf[1] != NULL)
+		obuf_destroy(&con->iobuf[1]->out);
 }
 
 /**
@@ -401,11 +614,15 @@ iproto_connection_new(const char *name, int fd)
 	con->loop = loop();
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
-	con->iobuf[0] = iobuf_new_mt(&tx_cord->slabc);
-	con->iobuf[1] = iobuf_new_mt(&tx_cord->slabc);
+	/* The greeting is put into iobuf[0]. */
+	con->iobuf[0] = iobuf_cache_get();
+	con->iobuf[1] = NULL;
 	con->parse_size = 0;
 	con->session = NULL;
 	rlist_create(&con->in_stop_list);
+	con->priority = IPROTO_PRIORITY_BULK;
+	con->n_msgs = 0;
+	con->is_throttled = false;
 	/* It may be very awkward to allocate at close. */
 	con->disconnect = iproto_msg_new(con);
 	cmsg_init(con->disconnect, disconnect_route);
@@ -435,7 +652,8 @@ iproto_connection_close(struct iproto_connection *con)
 		 * parsed data is processed.  It's important this
 		 * is done only once.
 		 */
-		con->iobuf[0]->in.wpos -= con->parse_size;
+		if (con->iobuf[0] != NULL)
+			con->iobuf[0]->in.wpos -= con->parse_size;
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -455,7 +673,7 @@ iproto_connection_close(struct iproto_connection *con)
 		con->disconnect = NULL;
 		cpipe_push(&tx_pipe, msg);
 	}
-	rlist_del(&con->in_stop_list);
+	iproto_connection_unstop(con);
 }
 
 /**
@@ -467,6 +685,8 @@ iproto_connection_close(struct iproto_connection *con)
  *   Therefore, at most 2 iobufs are used in a single connection,
  *   one is "open", receiving input, and the  other is closed,
  *   flushing output.
+ *   The buffers are taken from the iobuf cache on demand, so
+ *   either of them may be missing here.
  * - stop input and wait until the client reads piled up output,
  *   so the input buffer can be reused. This complements
  *   the previous strategy. It is only safe to stop input if it
@@ -484,10 +704,18 @@ iproto_connection_close(struct iproto_connection *con)
 static struct iobuf *
 iproto_connection_input_iobuf(struct iproto_connection *con)
 {
-	struct iobuf *oldbuf = con->iobuf[0];
-
 	size_t to_read = 3; /* Smallest possible valid request. */
 
+	if (con->iobuf[0] == NULL) {
+		/* No unparsed input is left in a released buffer. */
+		assert(con->parse_size == 0);
+		struct iobuf *iobuf = iobuf_cache_get();
+		con->iobuf[0] = iobuf;
+		ibuf_reserve_xc(&iobuf->in, to_read);
+		return iobuf;
+	}
+	struct iobuf *oldbuf = con->iobuf[0];
+
 	/* The type code is checked in iproto_enqueue_batch() */
 	if (con->parse_size) {
 		const char *pos = oldbuf->in.wpos - con->parse_size;
@@ -516,7 +744,9 @@ iproto_connection_input_iobuf(struct iproto_connection *con)
 		return oldbuf;
 	}
 
-	if (! iobuf_is_idle(con->iobuf[1])) {
+	if (con->iobuf[1] == NULL) {
+		con->iobuf[1] = iobuf_cache_get();
+	} else if (! iobuf_is_idle(con->iobuf[1])) {
 		/*
 		 * Wait until the second buffer is flushed
 		 * and becomes available for reuse.
@@ -535,12 +765,6 @@ iproto_connection_input_iobuf(struct iproto_connection *con)
 		/* Move the cached request prefix to the new buffer. */
 		memcpy(newbuf->in.rpos, oldbuf->in.wpos, con->parse_size);
 		newbuf->in.wpos += con->parse_size;
-		/*
-		 * We made ibuf idle. If obuf was already idle it makes the whole
-		 * iobuf idle, time to trim buffers.
-		 */
-		if (iobuf_is_idle(oldbuf))
-			iobuf_reset_mt(oldbuf);
 	}
 	/*
 	 * Rotate buffers. Not strictly necessary, but
@@ -548,6 +772,15 @@ iproto_connection_input_iobuf(struct iproto_connection *con)
 	 */
 	con->iobuf[1] = oldbuf;
 	con->iobuf[0] = newbuf;
+	/*
+	 * We may have made the old ibuf idle. If obuf was
+	 * already idle it makes the whole iobuf idle, time
+	 * to return it to the cache.
+	 */
+	if (iobuf_is_idle(oldbuf)) {
+		con->iobuf[1] = NULL;
+		iobuf_cache_put(oldbuf);
+	}
 	return newbuf;
 }
 
@@ -609,7 +842,13 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	int n_requests = 0;
 	bool stop_input = false;
+	con->is_throttled = false;
 	while (con->parse_size && stop_input == false) {
+		if (iproto_connection_is_full(con)) {
+			/* Wait for replies to the requests in flight. */
+			con->is_throttled = true;
+			break;
+		}
 		const char *reqstart = in->wpos - con->parse_size;
 		const char *pos = reqstart;
 		/* Read request length. */
@@ -631,6 +870,10 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 
 		try {
 			iproto_decode_msg(msg, &pos, reqend, &stop_input);
+			msg->queue = con->priority;
+			msg->priority = con->priority;
+			con->n_msgs++;
+			iproto_queue[msg->queue]++;
 			cpipe_push_input(&tx_pipe, guard.release());
 			n_requests++;
 		} catch (Exception *e) {
@@ -668,6 +911,9 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		ev_io_stop(con->loop, &con->output);
 		ev_io_stop(con->loop, &con->input);
+	} else if (con->is_throttled) {
+		/* Resumed by net_send_msg(). */
+		ev_io_stop(con->loop, &con->input);
 	} else if (n_requests != 1 || con->parse_size != 0) {
 		assert(rlist_empty(&con->in_stop_list));
 		/*
@@ -702,7 +948,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	assert(fd >= 0);
 	if (! rlist_empty(&con->in_stop_list)) {
 		/* Resumed stopped connection. */
-		rlist_del(&con->in_stop_list);
+		iproto_connection_unstop(con);
 		/*
 		 * This connection may have no input, so
 		 * resume one more connection which might have
@@ -717,12 +963,22 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	 * another fiber waiting for write to complete).
 	 * Ignore iproto_connection->disconnect messages.
 	 */
-	if (iproto_stop_input()) {
+	if (iproto_stop_input(con->priority)) {
 		iproto_connection_stop(con);
 		return;
 	}
 
 	try {
+		if (con->is_throttled) {
+			/*
+			 * The connection has some requests read up
+			 * but not enqueued, which the socket won't
+			 * notify us about. Enqueue them first.
+			 */
+			ev_io_start(loop, &con->input);
+			iproto_enqueue_batch(con, &con->iobuf[0]->in);
+			return;
+		}
 		/* Ensure we have sufficient space for the next round.  */
 		struct iobuf *iobuf = iproto_connection_input_iobuf(con);
 		if (iobuf == NULL) {
@@ -734,6 +990,8 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 		/* Read input. */
 		int nrd = sio_read(fd, in->wpos, ibuf_unused(in));
 		if (nrd < 0) {                  /* Socket is not ready. */
+			/* Don't hold a buffer while waiting for input. */
+			iproto_connection_gc_iobuf(con);
 			ev_io_start(loop, &con->input);
 			return;
 		}
@@ -761,17 +1019,19 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 static inline struct iobuf *
 iproto_connection_output_iobuf(struct iproto_connection *con)
 {
-	if (obuf_used(&con->iobuf[1]->out) > 0)
-		return con->iobuf[1];
+	struct iobuf *old = con->iobuf[1];
+	struct iobuf *cur = con->iobuf[0];
+	if (old != NULL && obuf_used(&old->out) > 0)
+		return old;
 	/*
 	 * Don't try to write from a newer buffer if an older one
 	 * exists: in case of a partial write of a newer buffer,
 	 * the client may end up getting a salad of different
 	 * pieces of replies from both buffers.
 	 */
-	if (ibuf_used(&con->iobuf[1]->in) == 0 &&
-	    obuf_used(&con->iobuf[0]->out) > 0)
-		return con->iobuf[0];
+	if ((old == NULL || ibuf_used(&old->in) == 0) &&
+	    cur != NULL && obuf_used(&cur->out) > 0)
+		return cur;
 	return NULL;
 }
 
@@ -842,6 +1102,8 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 				ev_feed_event(loop, &con->input, EV_READ);
 			}
 		}
+		/* All output is sent, release idle buffers. */
+		iproto_connection_gc_iobuf(con);
 		if (ev_is_active(&con->output))
 			ev_io_stop(con->loop, &con->output);
 	} catch (Exception *e) {
@@ -850,6 +1112,18 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 	}
 }
 
+/**
+ * Finish the reply to a request: remember the end of the
+ * output and the priority the session has now, e.g. after
+ * an on_auth trigger or a call has changed it.
+ */
+static inline void
+tx_end_msg(struct iproto_msg *msg, struct obuf *out)
+{
+	msg->write_end = obuf_create_svp(out);
+	msg->priority = msg->connection->session->net_priority;
+}
+
 static int
 tx_check_schema(uint32_t schema_id)
 {
@@ -880,12 +1154,12 @@ tx_process1(struct cmsg *m)
 		goto error;
 	iproto_reply_select(out, &svp, msg->header.sync,
 			    tuple != 0);
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync);
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 }
 
 static void
@@ -914,12 +1188,12 @@ tx_process_select(struct cmsg *m)
 	}
 	port_dump(&port, out);
 	iproto_reply_select(out, &svp, msg->header.sync, port.size);
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync);
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 }
 
 static void
@@ -958,12 +1232,12 @@ tx_process_misc(struct cmsg *m)
 		iproto_reply_error(out, diag_last_error(&fiber()->diag),
 				   msg->header.sync);
 	}
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 	return;
 error:
 	iproto_reply_error(out, diag_last_error(&fiber()->diag),
 			   msg->header.sync);
-	msg->write_end = obuf_create_svp(out);
+	tx_end_msg(msg, out);
 }
 
 static void
@@ -1003,6 +1277,30 @@ tx_process_join_subscribe(struct cmsg *m)
 	}
 }
 
+/**
+ * Account a processed request of the connection and resume
+ * its input if it was throttled.
+ */
+static inline void
+iproto_connection_complete_msg(struct iproto_connection *con,
+			       struct iproto_msg *msg)
+{
+	assert(con->n_msgs > 0);
+	con->n_msgs--;
+	iproto_queue[msg->queue]--;
+	if (! rlist_empty(&con->in_stop_list)) {
+		/* Will be resumed by iproto_resume() of its new class. */
+		iproto_connection_unstop(con);
+		con->priority = msg->priority;
+		iproto_connection_stop(con);
+	} else {
+		con->priority = msg->priority;
+	}
+	if (con->is_throttled && ! iproto_connection_is_full(con) &&
+	    evio_has_fd(&con->input))
+		ev_feed_event(con->loop, &con->input, EV_READ);
+}
+
 static void
 net_send_msg(struct cmsg *m)
 {
@@ -1012,6 +1310,7 @@ net_send_msg(struct cmsg *m)
 	/* Discard request (see iproto_enqueue_batch()) */
 	iobuf->in.rpos += msg->len;
 	iobuf->out.wend = msg->write_end;
+	iproto_connection_complete_msg(con, msg);
 
 	if (evio_has_fd(&con->output)) {
 		if (! ev_is_active(&con->output))
@@ -1030,6 +1329,7 @@ net_end_join_subscribe(struct cmsg *m)
 	struct iobuf *iobuf = msg->iobuf;
 
 	iobuf->in.rpos += msg->len;
+	iproto_connection_complete_msg(con, msg);
 	iproto_msg_delete(msg);
 
 	assert(! ev_is_active(&con->input));
@@ -1066,7 +1366,7 @@ tx_process_connect(struct cmsg *m)
 			if (session_run_on_connect_triggers(con->session) != 0)
 				diag_raise();
 		}
-		msg->write_end = obuf_create_svp(out);
+		tx_end_msg(msg, out);
 	} catch (Exception *e) {
 		iproto_reply_error(out, e, 0 /* zero sync for connect error */);
 		msg->close_connection = true;
@@ -1099,6 +1399,7 @@ net_send_greeting(struct cmsg *m)
 		return;
 	}
 	con->iobuf[0]->out.wend = msg->write_end;
+	con->priority = msg->priority;
 	/*
 	 * Connect is synchronous, so no one could have been
 	 * messing up with the connection while it was in
@@ -1140,6 +1441,7 @@ iproto_on_accept(struct evio_service * /* service */, int fd,
 	cmsg_init(msg, connect_route);
 	msg->iobuf = con->iobuf[0];
 	msg->close_connection = false;
+	msg->priority = IPROTO_PRIORITY_BULK;
 	cpipe_push(&tx_pipe, msg);
 }
 
@@ -1158,6 +1460,8 @@ net_cord_f(va_list /* ap */)
 		       sizeof(struct iproto_msg));
 	mempool_create(&iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
+	for (int i = 0; i < iproto_priority_MAX; i++)
+		rlist_create(&stopped_connections[i]);
 
 	evio_service_init(loop(), &binary, "binary",
 			  iproto_on_accept, NULL);
@@ -30,6 +30,46 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Admission classes of iproto requests. Requests of
+ * high priority connections may use a part of the message
+ * budget reserved for them, and stopped high priority
+ * connections are resumed before the bulk ones.
+ */
+enum iproto_priority {
+	IPROTO_PRIORITY_BULK = 0,
+	IPROTO_PRIORITY_HIGH = 1,
+	iproto_priority_MAX
+};
+
+extern const char *iproto_priority_strs[];
+
+/** The number of requests of the class in flight. */
+size_t
+iproto_queue_size(enum iproto_priority priority);
+
+/** The number of connections of the class waiting for admission. */
+size_t
+iproto_stopped_count(enum iproto_priority priority);
+
+/** The number of iobufs held by connections. */
+size_t
+iproto_iobuf_used();
+
+/** The number of idle iobufs kept in the cache for reuse. */
+size_t
+iproto_iobuf_cached();
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
 void
 iproto_init();
 
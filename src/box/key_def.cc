@@ -39,6 +39,7 @@
 #include "space.h"
 #include "schema.h"
 #include "tuple_compare.h"
+#include "tuple_hash.h"
 
 const char *field_type_strs[] = {
 	/* [FIELD_TYPE_ANY]      = */ "any",
@@ -87,6 +88,12 @@ const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
 
+const char *rtree_index_coord_type_strs[] = { "double", "float" };
+
+const char *vy_compaction_policy_strs[] = {
+	"tiered", "leveled", "time_window"
+};
+
 const char *func_language_strs[] = {"LUA", "C"};
 
 const uint32_t key_mp_type[] = {
@@ -114,11 +121,19 @@ const struct key_opts key_opts_default = {
 	/* .dimension           = */ 2,
 	/* .distancebuf         = */ { '\0' },
 	/* .distance            = */ RTREE_INDEX_DISTANCE_TYPE_EUCLID,
+	/* .coord_typebuf       = */ { '\0' },
+	/* .coord_type          = */ RTREE_INDEX_COORD_TYPE_DOUBLE,
+	/* .hint                = */ false,
 	/* .path                = */ { 0 },
 	/* .range_size          = */ 0,
 	/* .page_size           = */ 0,
 	/* .run_count_per_level = */ 2,
 	/* .run_size_ratio      = */ 3.5,
+	/* .compaction_policybuf = */ { '\0' },
+	/* .compaction_policy   = */ VY_COMPACTION_POLICY_TIERED,
+	/* .cache_size          = */ 0,
+	/* .includebuf          = */ { '\0' },
+	/* .include_mask        = */ 0,
 	/* .lsn                 = */ 0,
 };
 
@@ -126,11 +141,17 @@ const struct opt_def key_opts_reg[] = {
 	OPT_DEF("unique", OPT_BOOL, struct key_opts, is_unique),
 	OPT_DEF("dimension", OPT_INT, struct key_opts, dimension),
 	OPT_DEF("distance", OPT_STR, struct key_opts, distancebuf),
+	OPT_DEF("coord_type", OPT_STR, struct key_opts, coord_typebuf),
+	OPT_DEF("hint", OPT_BOOL, struct key_opts, hint),
 	OPT_DEF("path", OPT_STR, struct key_opts, path),
 	OPT_DEF("range_size", OPT_INT, struct key_opts, range_size),
 	OPT_DEF("page_size", OPT_INT, struct key_opts, page_size),
 	OPT_DEF("run_count_per_level", OPT_INT, struct key_opts, run_count_per_level),
 	OPT_DEF("run_size_ratio", OPT_FLOAT, struct key_opts, run_size_ratio),
+	OPT_DEF("compaction_policy", OPT_STR, struct key_opts,
+		compaction_policybuf),
+	OPT_DEF("cache_size", OPT_INT, struct key_opts, cache_size),
+	OPT_DEF("include", OPT_STR, struct key_opts, includebuf),
 	OPT_DEF("lsn", OPT_INT, struct key_opts, lsn),
 	{ NULL, opt_type_MAX, 0, 0 },
 };
@@ -162,6 +183,7 @@ key_def_set_cmp(struct key_def *def)
 {
 	def->tuple_compare = tuple_compare_create(def);
 	def->tuple_compare_with_key = tuple_compare_with_key_create(def);
+	tuple_hash_func_set(def);
 }
 
 struct key_def *
@@ -415,10 +437,14 @@ key_validate_parts(struct key_def *key_def, const char *key,
 
 const struct space_opts space_opts_default = {
 	/* .temporary = */ false,
+	/* .ttl_field = */ 0,
+	/* .mmap_snapshot = */ false,
 };
 
 const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", OPT_BOOL, struct space_opts, temporary),
+	OPT_DEF("ttl_field", OPT_INT, struct space_opts, ttl_field),
+	OPT_DEF("mmap_snapshot", OPT_BOOL, struct space_opts, mmap_snapshot),
 	{ NULL, opt_type_MAX, 0, 0 }
 };
 
@@ -451,6 +477,24 @@ space_def_check(struct space_def *def, uint32_t namelen, uint32_t engine_namelen
 				  def->name,
 			         "space does not support temporary flag");
 	}
+	if (def->opts.ttl_field < 0 || def->opts.ttl_field > BOX_FIELD_MAX) {
+		tnt_raise(ClientError, errcode, def->name,
+			  "ttl_field is out of range");
+	}
+	if (def->opts.ttl_field > 0) {
+		Engine *engine = engine_find(def->engine_name);
+		if (! engine_can_expire(engine->flags))
+			tnt_raise(ClientError, ER_ALTER_SPACE,
+				  def->name,
+				  "space does not support ttl_field");
+	}
+	if (def->opts.mmap_snapshot) {
+		Engine *engine = engine_find(def->engine_name);
+		if (! engine_can_mmap_snapshot(engine->flags))
+			tnt_raise(ClientError, ER_ALTER_SPACE,
+				  def->name,
+				  "space does not support mmap_snapshot");
+	}
 }
 
 bool
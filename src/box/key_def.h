@@ -162,6 +162,37 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+/** Type of coordinates stored in an RTREE index. */
+enum rtree_index_coord_type {
+	/* Double precision, as they are decoded from tuples */
+	RTREE_INDEX_COORD_TYPE_DOUBLE,
+	/* Single precision, matches are re-checked with tuples */
+	RTREE_INDEX_COORD_TYPE_FLOAT,
+	rtree_index_coord_type_MAX
+};
+extern const char *rtree_index_coord_type_strs[];
+
+/** Vinyl compaction policy, @sa vy_range_update_compact_priority(). */
+enum vy_compaction_policy {
+	/*
+	 * Size-tiered: up to run_count_per_level runs are
+	 * accumulated at each level before they are merged.
+	 */
+	VY_COMPACTION_POLICY_TIERED,
+	/*
+	 * Leveled: a level may contain only one run, a new run
+	 * is merged into the next level as soon as it appears.
+	 */
+	VY_COMPACTION_POLICY_LEVELED,
+	/*
+	 * Time window: only fresh dumps are merged together,
+	 * runs of sealed (old) windows are not rewritten.
+	 */
+	VY_COMPACTION_POLICY_TIME_WINDOW,
+	vy_compaction_policy_MAX
+};
+extern const char *vy_compaction_policy_strs[];
+
 /** Descriptor of a single part in a multipart key. */
 struct key_part {
 	uint32_t fieldno;
@@ -184,6 +215,18 @@ struct key_opts {
 	 */
 	char distancebuf[16];
 	enum rtree_index_distance_type distance;
+	/**
+	 * RTREE coordinate type.
+	 */
+	char coord_typebuf[16];
+	enum rtree_index_coord_type coord_type;
+	/**
+	 * Store a prefix of the first key part along with
+	 * each tuple pointer in a memtx TREE index so as to
+	 * avoid dereferencing tuples on lookups. Doubles the
+	 * size of index elements, so it is off by default.
+	 */
+	bool hint;
 	/**
 	 * Vinyl index options.
 	 */
@@ -201,6 +244,23 @@ struct key_opts {
 	 * previous one.
 	 */
 	double run_size_ratio;
+	/**
+	 * Vinyl compaction policy.
+	 */
+	char compaction_policybuf[16];
+	enum vy_compaction_policy compaction_policy;
+	/**
+	 * Memory limit of the vinyl tuple cache of the index,
+	 * 0 if only the common vinyl_cache limit applies.
+	 */
+	int64_t cache_size;
+	/**
+	 * Fields stored along with the key in a vinyl secondary
+	 * index, as a comma separated list of field numbers, and
+	 * decoded into a column mask, @sa key_def_column_mask().
+	 */
+	char includebuf[256];
+	uint64_t include_mask;
 	/**
 	 * LSN from the time of index creation.
 	 */
@@ -219,6 +279,12 @@ key_opts_cmp(const struct key_opts *o1, const struct key_opts *o2)
 		return o1->dimension < o2->dimension ? -1 : 1;
 	if (o1->distance != o2->distance)
 		return o1->distance < o2->distance ? -1 : 1;
+	if (o1->coord_type != o2->coord_type)
+		return o1->coord_type < o2->coord_type ? -1 : 1;
+	if (o1->hint != o2->hint)
+		return o1->hint < o2->hint ? -1 : 1;
+	if (o1->include_mask != o2->include_mask)
+		return o1->include_mask < o2->include_mask ? -1 : 1;
 	return 0;
 }
 
@@ -232,6 +298,14 @@ typedef int (*tuple_compare_with_key_t)(const struct tuple *tuple_a,
 typedef int (*tuple_compare_t)(const struct tuple *tuple_a,
 			   const struct tuple *tuple_b,
 			   const struct key_def *key_def);
+typedef uint32_t (*tuple_hash_t)(const struct tuple *tuple,
+				 const struct key_def *key_def);
+typedef uint32_t (*key_hash_t)(const char *key,
+			       const struct key_def *key_def);
+typedef uint64_t (*tuple_hash64_t)(const struct tuple *tuple,
+				   const struct key_def *key_def);
+typedef uint64_t (*key_hash64_t)(const char *key,
+				 const struct key_def *key_def);
 
 /* Descriptor of a multipart key. */
 struct key_def {
@@ -250,6 +324,14 @@ struct key_def {
 	tuple_compare_t tuple_compare;
 	/** tuple <-> key comparison function */
 	tuple_compare_with_key_t tuple_compare_with_key;
+	/** tuple hash function, MurmurHash3 compatible */
+	tuple_hash_t tuple_hash;
+	/** key hash function, MurmurHash3 compatible */
+	key_hash_t key_hash;
+	/** 64-bit tuple hash function, wyhash based */
+	tuple_hash64_t tuple_hash64;
+	/** 64-bit key hash function, wyhash based */
+	key_hash64_t key_hash64;
 	/** The size of the 'parts' array. */
 	uint32_t part_count;
 	/** Description of parts of a multipart index. */
@@ -353,6 +435,19 @@ struct space_opts {
 	 * - changes are not part of a snapshot
 	 */
 	bool temporary;
+	/**
+	 * 1-based number of the field storing the time, in
+	 * seconds since the Epoch, when the tuple expires and
+	 * is deleted by the expiration fiber. 0 if tuples of
+	 * the space do not expire.
+	 */
+	int64_t ttl_field;
+	/**
+	 * Checkpoints write a snapshot image of the space,
+	 * which is memory mapped at startup instead of reading
+	 * the space rows from the snapshot. @sa memtx_image.h
+	 */
+	bool mmap_snapshot;
 };
 
 extern const struct space_opts space_opts_default;
@@ -473,6 +568,28 @@ key_def_is_sequential(const struct key_def *key_def)
 	return true;
 }
 
+/**
+ * Return the mask of the fields used by @a key_def, in the format
+ * of the column mask of an UPDATE operation (@sa
+ * tuple_update_execute()): bit (63 - fieldno) is set for each
+ * key part, all bits are set if any key part is in field 64 or
+ * beyond.
+ * @param key_def key_def
+ * @return the column mask of the key
+ */
+static inline uint64_t
+key_def_column_mask(const struct key_def *key_def)
+{
+	uint64_t column_mask = 0;
+	for (uint32_t part_id = 0; part_id < key_def->part_count; part_id++) {
+		uint32_t fieldno = key_def->parts[part_id].fieldno;
+		if (fieldno >= 64)
+			return UINT64_MAX;
+		column_mask |= ((uint64_t)1) << (63 - fieldno);
+	}
+	return column_mask;
+}
+
 /** A helper table for key_mp_type_validate */
 extern const uint32_t key_mp_type[];
 
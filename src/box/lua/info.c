@@ -47,8 +47,10 @@
 #include "box/box.h"
 #include "lua/utils.h"
 #include "fiber.h"
+#include "say.h"
 
 #include "box/vinyl.h"
+#include "box/expiration.h"
 
 static void
 lbox_pushvclock(struct lua_State *L, struct vclock *vclock)
@@ -263,6 +265,73 @@ lbox_info_vinyl(struct lua_State *L)
 	return 1;
 }
 
+static int
+lbox_info_expiration_call(struct lua_State *L)
+{
+	struct expiration_stat stat;
+	expiration_stat(&stat);
+
+	lua_createtable(L, 0, 4);
+	lua_pushliteral(L, "expired");
+	luaL_pushint64(L, stat.expired);
+	lua_settable(L, -3);
+	lua_pushliteral(L, "rps");
+	luaL_pushint64(L, stat.rps);
+	lua_settable(L, -3);
+	lua_pushliteral(L, "backlog");
+	luaL_pushint64(L, stat.backlog);
+	lua_settable(L, -3);
+	lua_pushliteral(L, "rate_limit");
+	lua_pushnumber(L, expiration_rate_limit());
+	lua_settable(L, -3);
+	return 1;
+}
+
+static int
+lbox_info_expiration(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L); /* metatable */
+
+	lua_pushstring(L, "__call");
+	lua_pushcfunction(L, lbox_info_expiration_call);
+	lua_settable(L, -3);
+
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+static int
+lbox_info_log_call(struct lua_State *L)
+{
+	lua_createtable(L, 0, 2);
+	lua_pushliteral(L, "async");
+	lua_pushboolean(L, say_logger_is_async());
+	lua_settable(L, -3);
+	lua_pushliteral(L, "dropped");
+	luaL_pushuint64(L, say_logger_dropped());
+	lua_settable(L, -3);
+	return 1;
+}
+
+static int
+lbox_info_log(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_newtable(L); /* metatable */
+
+	lua_pushstring(L, "__call");
+	lua_pushcfunction(L, lbox_info_log_call);
+	lua_settable(L, -3);
+
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
 static const struct luaL_reg
 lbox_info_dynamic_meta [] =
 {
@@ -274,6 +343,8 @@ lbox_info_dynamic_meta [] =
 	{"pid", lbox_info_pid},
 	{"cluster", lbox_info_cluster},
 	{"vinyl", lbox_info_vinyl},
+	{"expiration", lbox_info_expiration},
+	{"log", lbox_info_log},
 	{NULL, NULL}
 };
 
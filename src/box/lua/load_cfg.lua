@@ -26,12 +26,18 @@ local default_cfg = {
     vinyl_range_size          = 1024 * 1024 * 1024,
     vinyl_page_size           = 8 * 1024,
     vinyl_bloom_fpr           = 0.05,
+    vinyl_io_rate_limit       = nil, -- no limit
+    vinyl_io_free_cache       = false,
+    vinyl_verify_runs         = false,
     log                 = nil,
     log_nonblock        = true,
+    log_async           = false,
     log_level           = 5,
     io_collect_interval = nil,
     readahead           = 16320,
     snap_io_rate_limit  = nil, -- no limit
+    expiration_rate_limit = nil, -- no limit
+    memtx_defrag_threshold = nil, -- no automatic defragmentation
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     rows_per_wal        = 500000,
@@ -72,13 +78,19 @@ local template_cfg = {
     vinyl_range_size          = 'number',
     vinyl_page_size           = 'number',
     vinyl_bloom_fpr           = 'number',
+    vinyl_io_rate_limit       = 'number',
+    vinyl_io_free_cache       = 'boolean',
+    vinyl_verify_runs         = 'boolean',
 
     log              = 'string',
     log_nonblock     = 'boolean',
+    log_async        = 'boolean',
     log_level           = 'number',
     io_collect_interval = 'number',
     readahead           = 'number',
     snap_io_rate_limit  = 'number',
+    expiration_rate_limit = 'number',
+    memtx_defrag_threshold = 'number',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
@@ -138,6 +150,9 @@ local dynamic_cfg = {
     readahead               = private.cfg_set_readahead,
     too_long_threshold      = private.cfg_set_too_long_threshold,
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
+    vinyl_io_rate_limit     = private.cfg_set_vinyl_io_rate_limit,
+    expiration_rate_limit   = private.cfg_set_expiration_rate_limit,
+    memtx_defrag_threshold  = private.cfg_set_memtx_defrag_threshold,
     read_only               = private.cfg_set_read_only,
     -- snapshot_daemon
     checkpoint_interval     = box.internal.snapshot_daemon.set_checkpoint_interval,
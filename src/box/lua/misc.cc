@@ -37,6 +37,7 @@
 
 #include "box/box.h"
 #include "box/port.h"
+#include "box/memtx_read_view.h"
 #include "box/lua/tuple.h"
 
 /** {{{ Miscellaneous utils **/
@@ -113,11 +114,45 @@ lbox_select(lua_State *L)
 
 /* }}} */
 
+/** {{{ index:read_view_select(): memtx scans off the tx thread **/
+
+static int
+lbox_read_view_select(lua_State *L)
+{
+	if (lua_gettop(L) != 6 || !lua_isnumber(L, 1) || !lua_isnumber(L, 2) ||
+		!lua_isnumber(L, 3) || !lua_isnumber(L, 4) || !lua_isnumber(L, 5)) {
+		return luaL_error(L, "Usage index:read_view_select(key, opts)");
+	}
+
+	uint32_t space_id = lua_tointeger(L, 1);
+	uint32_t index_id = lua_tointeger(L, 2);
+	int iterator = lua_tointeger(L, 3);
+	uint32_t offset = lua_tointeger(L, 4);
+	uint32_t limit = lua_tointeger(L, 5);
+
+	size_t key_len;
+	const char *key = lbox_encode_tuple_on_gc(L, 6, &key_len);
+
+	struct port port;
+	port_create(&port);
+	if (box_read_view_select(&port, space_id, index_id, iterator,
+				 offset, limit, key, key + key_len) != 0) {
+		port_destroy(&port);
+		return luaT_error(L);
+	}
+	lbox_port_to_table(L, &port);
+	port_destroy(&port);
+	return 1;
+}
+
+/* }}} */
+
 void
 box_lua_misc_init(struct lua_State *L)
 {
 	static const struct luaL_reg boxlib_internal[] = {
 		{"select", lbox_select},
+		{"read_view_select", lbox_read_view_select},
 		{NULL, NULL}
 	};
 
@@ -30,9 +30,19 @@ ffi.cdef[[
                        const char *key, const char *key_end);
     int
     box_iterator_next(box_iterator_t *itr, box_tuple_t **result);
+    int
+    box_iterator_next_batch(box_iterator_t *itr, box_tuple_t **result,
+                            uint32_t count);
     void
     box_iterator_free(box_iterator_t *itr);
     /** \endcond public */
+
+    struct iterator_batch {
+        box_iterator_t *it;
+        uint32_t pos;
+        uint32_t count;
+        box_tuple_t *tuples[64];
+    };
     /** \cond public */
     ssize_t
     box_index_len(uint32_t space_id, uint32_t index_id);
@@ -241,6 +251,8 @@ box.schema.space.create = function(name, options)
         user = 'string, number',
         format = 'table',
         temporary = 'boolean',
+        ttl_field = 'number',
+        mmap_snapshot = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -282,6 +294,8 @@ box.schema.space.create = function(name, options)
     -- filter out global parameters from the options array
     local space_options = setmetatable({
         temporary = options.temporary and true or nil,
+        ttl_field = options.ttl_field,
+        mmap_snapshot = options.mmap_snapshot and true or nil,
     }, { __serialize = 'map' })
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -378,6 +392,23 @@ local function update_index_parts(parts)
     return new_parts
 end
 
+-- {3, 5} -> "2,4": fields included into a vinyl secondary index
+local function update_index_include(include)
+    if include == nil then
+        return nil
+    end
+    local fields = {}
+    for i, fieldno in ipairs(include) do
+        if type(fieldno) ~= 'number' then
+            box.error(box.error.ILLEGAL_PARAMS,
+                      "options.include: expected field numbers")
+        end
+        -- Lua uses one-based field numbers but _index is zero-based
+        fields[i] = tostring(fieldno - 1)
+    end
+    return table.concat(fields, ',')
+end
+
 box.schema.index.create = function(space_id, name, options)
     check_param(space_id, 'space_id', 'number')
     check_param(name, 'name', 'string')
@@ -389,11 +420,16 @@ box.schema.index.create = function(space_id, name, options)
         if_not_exists = 'boolean',
         dimension = 'number',
         distance = 'string',
+        coord_type = 'string',
+        hint = 'boolean',
         path = 'string',
         page_size = 'number',
         range_size = 'number',
         run_count_per_level = 'number',
         run_size_ratio = 'number',
+        compaction_policy = 'string',
+        cache_size = 'number',
+        include = 'table',
     }
     check_param_table(options, options_template)
     local options_defaults = {
@@ -459,11 +495,16 @@ box.schema.index.create = function(space_id, name, options)
             dimension = options.dimension,
             unique = options.unique,
             distance = options.distance,
+            coord_type = options.coord_type,
+            hint = options.hint,
             path = options.path,
             page_size = options.page_size,
             range_size = options.range_size,
             run_count_per_level = options.run_count_per_level,
             run_size_ratio = options.run_size_ratio,
+            compaction_policy = options.compaction_policy,
+            cache_size = options.cache_size,
+            include = update_index_include(options.include),
             lsn = box.info.cluster.signature,
     }
     local field_type_aliases = {
@@ -481,6 +522,16 @@ box.schema.index.create = function(space_id, name, options)
         end
     end
     _index:insert{space_id, iid, name, options.type, key_opts, parts}
+    if iid == 0 then
+        -- tuples of a space with ttl_field are expired in the
+        -- order of this index, see box.info.expiration()
+        local space_options = box.space._space:get{space_id}[6]
+        if type(space_options) == 'table' and space_options.ttl_field then
+            box.schema.index.create(space_id, 'expire', {type = 'tree',
+                unique = false, parts = {space_options.ttl_field, 'number'},
+                if_not_exists = true})
+        end
+    end
     return box.space[space_id].index[name]
 end
 
@@ -523,6 +574,8 @@ box.schema.index.alter = function(space_id, index_id, options)
         unique = 'boolean',
         dimension = 'number',
         distance = 'string',
+        coord_type = 'string',
+        hint = 'boolean',
     }
     check_param_table(options, options_template)
 
@@ -592,6 +645,12 @@ box.schema.index.alter = function(space_id, index_id, options)
     if options.distance ~= nil then
         key_opts.distance = options.distance
     end
+    if options.coord_type ~= nil then
+        key_opts.coord_type = options.coord_type
+    end
+    if options.hint ~= nil then
+        key_opts.hint = options.hint
+    end
     if options.parts ~= nil then
         check_index_parts(options.parts)
         options.parts = update_index_parts(options.parts)
@@ -623,6 +682,30 @@ ffi.metatype(iterator_t, {
     end;
 })
 
+-- the number of tuples fetched by a single box_iterator_next_batch() call,
+-- must match the size of struct iterator_batch.tuples
+local ITERATOR_BATCH_SIZE = 64
+local iterator_batch_t = ffi.typeof('struct iterator_batch')
+ffi.metatype(iterator_batch_t, {
+    __tostring = function(batch)
+        return "<iterator state>"
+    end;
+})
+
+local const_tuple_ref_t = ffi.typeof('const box_tuple_t&')
+
+local tuple_gc = function(tuple)
+    builtin.box_tuple_unref(tuple)
+end
+
+local iterator_batch_gc = function(batch)
+    -- release tuples fetched but not consumed by the loop
+    for i = batch.pos, batch.count - 1 do
+        builtin.box_tuple_unref(batch.tuples[i])
+    end
+    builtin.box_iterator_free(batch.it)
+end
+
 local iterator_gen = function(param, state)
     --[[
         index:pairs() mostly conforms to the Lua for-in loop conventions and
@@ -657,6 +740,41 @@ local iterator_gen = function(param, state)
     end
 end
 
+local iterator_gen_batch = function(param, state)
+    --[[
+        index:pairs(key, {prefetch = true}) follows the same conventions as
+        iterator_gen() above, but *state* is `struct iterator_batch` cdata:
+        it holds `struct iterator` and a chunk of prefetched tuples.
+
+        Up to ITERATOR_BATCH_SIZE tuples are read from the index at once,
+        so a loop which yields between steps does not see changes made by
+        other fibers to the part of the index already fetched: a tuple
+        deleted or replaced after its chunk has been read is still
+        returned in its old version, and a tuple inserted into that part
+        of the index is skipped.
+    --]]
+    if not ffi.istype(iterator_batch_t, state) then
+        error('usage: next(param, state)')
+    end
+    -- next() modifies state in-place
+    if state.pos == state.count then
+        local count = builtin.box_iterator_next_batch(state.it, state.tuples,
+                                                      ITERATOR_BATCH_SIZE)
+        if count < 0 then
+            return box.error() -- error
+        end
+        state.pos = 0
+        state.count = count
+        if count == 0 then
+            return nil
+        end
+    end
+    local tuple = state.tuples[state.pos]
+    state.pos = state.pos + 1
+    -- the tuple has already been referenced by box_iterator_next_batch()
+    return state, ffi.gc(ffi.cast(const_tuple_ref_t, tuple), tuple_gc)
+end
+
 local iterator_gen_luac = function(param, state)
     local tuple = internal.iterator_next(state)
     if tuple ~= nil then
@@ -824,6 +942,12 @@ function box.schema.space.bless(space)
         if cdata == nil then
             box.error()
         end
+        if type(opts) == "table" and opts.prefetch then
+            local batch = ffi.new(iterator_batch_t)
+            batch.it = cdata
+            return fun.wrap(iterator_gen_batch, keybuf,
+                ffi.gc(batch, iterator_batch_gc))
+        end
         return fun.wrap(iterator_gen, keybuf,
             ffi.gc(cdata, builtin.box_iterator_free))
     end
@@ -920,6 +1044,16 @@ function box.schema.space.bless(space)
             offset, limit, key)
     end
 
+    -- select from a consistent read view of a memtx index, scanned
+    -- in a separate thread: the result may miss the latest changes
+    index_mt.read_view_select = function(index, key, opts)
+        check_index_arg(index, 'read_view_select')
+        local key = keify(key)
+        local iterator, offset, limit = check_select_opts(opts, #key == 0)
+        return internal.read_view_select(index.space_id, index.id,
+            iterator, offset, limit, key)
+    end
+
     index_mt.update = function(index, key, ops)
         check_index_arg(index, 'update')
         return internal.update(index.space_id, index.id, keify(key), ops);
@@ -994,6 +1128,10 @@ function box.schema.space.bless(space)
         check_space_arg(space, 'select')
         return check_primary_index(space):select(key, opts)
     end
+    space_mt.read_view_select = function(space, key, opts)
+        check_space_arg(space, 'read_view_select')
+        return check_primary_index(space):read_view_select(key, opts)
+    end
     space_mt.insert = function(space, tuple)
         check_space_arg(space, 'insert')
         return internal.insert(space.id, tuple);
@@ -40,6 +40,9 @@
 #include "box/box.h"
 #include "box/session.h"
 #include "box/user.h"
+#include "box/iproto.h"
+
+#include <strings.h>
 
 static const char *sessionlib_name = "box.session";
 
@@ -187,6 +190,37 @@ lbox_session_fd(struct lua_State *L)
 }
 
 
+/**
+ * Get or set the iproto admission class of the current
+ * session: 'bulk' (default) or 'high'. Requests of high
+ * priority sessions are not limited per connection and
+ * may use a reserved part of the request queue.
+ * The new class is applied starting from the next request
+ * of the session connection.
+ */
+static int
+lbox_session_priority(struct lua_State *L)
+{
+	if (lua_gettop(L) > 1)
+		luaL_error(L, "session.priority([priority]): bad arguments");
+
+	struct session *session = current_session();
+	if (lua_gettop(L) == 1) {
+		const char *name = luaL_checkstring(L, 1);
+		int i;
+		for (i = 0; i < iproto_priority_MAX; i++) {
+			if (strcasecmp(name, iproto_priority_strs[i]) == 0)
+				break;
+		}
+		if (i == iproto_priority_MAX)
+			luaL_error(L, "session.priority(): unknown priority "
+				   "'%s'", name);
+		session->net_priority = i;
+	}
+	lua_pushstring(L, iproto_priority_strs[session->net_priority]);
+	return 1;
+}
+
 /**
  * Pretty print peer name.
  */
@@ -338,6 +372,7 @@ box_lua_session_init(struct lua_State *L)
 		{"fd", lbox_session_fd},
 		{"exists", lbox_session_exists},
 		{"peer", lbox_session_peer},
+		{"priority", lbox_session_priority},
 		{"on_connect", lbox_session_on_connect},
 		{"on_disconnect", lbox_session_on_disconnect},
 		{"on_auth", lbox_session_on_auth},
@@ -41,6 +41,7 @@
 #include "small/small.h"
 #include "small/quota.h"
 #include "memory.h"
+#include "box/memtx_defrag.h"
 
 extern struct small_alloc memtx_alloc;
 extern struct mempool memtx_index_extent_pool;
@@ -218,6 +219,53 @@ lbox_slab_info(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * Run a pass of defragmentation of tuple slabs and return the
+ * number of tuples moved and bytes of slabs released.
+ */
+static int
+lbox_slab_defrag(struct lua_State *L)
+{
+	uint64_t moved, reclaimed;
+	if (memtx_defrag_run(&moved, &reclaimed) != 0)
+		return luaT_error(L);
+	lua_newtable(L);
+
+	lua_pushstring(L, "moved");
+	luaL_pushuint64(L, moved);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "reclaimed");
+	luaL_pushuint64(L, reclaimed);
+	lua_settable(L, -3);
+	return 1;
+}
+
+static int
+lbox_slab_defrag_info(struct lua_State *L)
+{
+	struct memtx_defrag_stat stat;
+	memtx_defrag_stat(&stat);
+	lua_newtable(L);
+
+	lua_pushstring(L, "running");
+	lua_pushboolean(L, stat.is_running);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "runs");
+	luaL_pushuint64(L, stat.runs);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "moved");
+	luaL_pushuint64(L, stat.moved);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "reclaimed");
+	luaL_pushuint64(L, stat.reclaimed);
+	lua_settable(L, -3);
+	return 1;
+}
+
 static int
 lbox_runtime_info(struct lua_State *L)
 {
@@ -268,6 +316,14 @@ box_lua_slab_init(struct lua_State *L)
 	lua_pushcfunction(L, lbox_slab_check);
 	lua_settable(L, -3);
 
+	lua_pushstring(L, "defrag");
+	lua_pushcfunction(L, lbox_slab_defrag);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "defrag_info");
+	lua_pushcfunction(L, lbox_slab_defrag_info);
+	lua_settable(L, -3);
+
 	lua_settable(L, -3); /* box.slab */
 
 	lua_pushstring(L, "runtime");
@@ -39,6 +39,9 @@
 #include <lualib.h>
 
 #include "lua/utils.h"
+#include "lua/msgpack.h"
+#include "box/iproto.h"
+#include "box/hot_stat.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
@@ -109,10 +112,51 @@ lbox_stat_call(struct lua_State *L)
 	return 1;
 }
 
+/** Push the queue of an iproto admission class, e.g. QUEUE_BULK. */
+static void
+fill_stat_queue(struct lua_State *L, enum iproto_priority priority)
+{
+	lua_newtable(L);
+
+	lua_pushstring(L, "current");
+	lua_pushnumber(L, iproto_queue_size(priority));
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "stopped");
+	lua_pushnumber(L, iproto_stopped_count(priority));
+	lua_settable(L, -3);
+}
+
+/** Push the number of connection buffers in use and cached. */
+static void
+fill_stat_iobuf(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_pushstring(L, "used");
+	lua_pushnumber(L, iproto_iobuf_used());
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "cached");
+	lua_pushnumber(L, iproto_iobuf_cached());
+	lua_settable(L, -3);
+}
+
 static int
 lbox_stat_net_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
+	const char *key = luaL_checkstring(L, -1);
+	if (strcmp(key, "IOBUF") == 0) {
+		fill_stat_iobuf(L);
+		return 1;
+	}
+	for (int i = 0; i < iproto_priority_MAX; i++) {
+		if (strncmp(key, "QUEUE_", 6) == 0 &&
+		    strcmp(key + 6, iproto_priority_strs[i]) == 0) {
+			fill_stat_queue(L, i);
+			return 1;
+		}
+	}
 	return rmean_foreach(rmean_net, seek_stat_item, L);
 }
 
@@ -121,9 +165,129 @@ lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
 	rmean_foreach(rmean_net, set_stat_item, L);
+	for (int i = 0; i < iproto_priority_MAX; i++) {
+		lua_pushfstring(L, "QUEUE_%s", iproto_priority_strs[i]);
+		fill_stat_queue(L, i);
+		lua_settable(L, -3);
+	}
+	lua_pushstring(L, "IOBUF");
+	fill_stat_iobuf(L);
+	lua_settable(L, -3);
+	return 1;
+}
+
+static void
+fill_hot_stat_item(struct lua_State *L, uint64_t count, uint64_t time)
+{
+	lua_pushstring(L, "count");
+	luaL_pushuint64(L, count);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "time");
+	lua_pushnumber(L, time / 1e9);
+	lua_settable(L, -3);
+}
+
+/** spaces[space_id] = {count, time, index = {[index_id] = ...}} */
+static void
+set_hot_stat_object(const struct hot_stat_object *object, void *arg)
+{
+	struct lua_State *L = (struct lua_State *) arg;
+
+	lua_rawgeti(L, -1, object->space_id);
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		fill_hot_stat_item(L, 0, 0);
+		lua_pushstring(L, "index");
+		lua_newtable(L);
+		lua_settable(L, -3);
+		lua_pushvalue(L, -1);
+		lua_rawseti(L, -3, object->space_id);
+	}
+	/* Sum up the indexes of the space. */
+	lua_getfield(L, -1, "count");
+	uint64_t count = luaL_touint64(L, -1) + object->count;
+	lua_getfield(L, -2, "time");
+	double time = lua_tonumber(L, -1) * 1e9 + object->time;
+	lua_pop(L, 2);
+	fill_hot_stat_item(L, count, time);
+
+	lua_getfield(L, -1, "index");
+	lua_newtable(L);
+	fill_hot_stat_item(L, object->count, object->time);
+	lua_rawseti(L, -2, object->index_id);
+	lua_pop(L, 2); /* index, space */
+}
+
+static void
+set_hot_stat_key(const struct hot_stat_item *item, void *arg)
+{
+	struct lua_State *L = (struct lua_State *) arg;
+
+	lua_newtable(L);
+	lua_pushstring(L, "space_id");
+	lua_pushnumber(L, item->space_id);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "index_id");
+	lua_pushnumber(L, item->index_id);
+	lua_settable(L, -3);
+
+	if (item->data != NULL) {
+		lua_pushstring(L, "key");
+		const char *data = item->data;
+		luamp_decode(L, luaL_msgpack_default, &data);
+		lua_settable(L, -3);
+	}
+	fill_hot_stat_item(L, item->count, item->time);
+	lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
+}
+
+static void
+set_hot_stat_func(const struct hot_stat_item *item, void *arg)
+{
+	struct lua_State *L = (struct lua_State *) arg;
+
+	lua_newtable(L);
+	lua_pushstring(L, "name");
+	lua_pushlstring(L, item->data, item->size);
+	lua_settable(L, -3);
+
+	fill_hot_stat_item(L, item->count, item->time);
+	lua_rawseti(L, -2, lua_objlen(L, -2) + 1);
+}
+
+static int
+lbox_stat_hot_call(struct lua_State *L)
+{
+	lua_newtable(L);
+
+	lua_pushstring(L, "spaces");
+	lua_newtable(L);
+	hot_stat_foreach_object(set_hot_stat_object, L);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "keys");
+	lua_newtable(L);
+	hot_stat_foreach_key(set_hot_stat_key, L);
+	lua_settable(L, -3);
+
+	lua_pushstring(L, "functions");
+	lua_newtable(L);
+	hot_stat_foreach_func(set_hot_stat_func, L);
+	lua_settable(L, -3);
 	return 1;
 }
 
+static int
+lbox_stat_hot_reset(struct lua_State *L)
+{
+	(void) L;
+	hot_stat_reset();
+	return 0;
+}
+
 static const struct luaL_reg lbox_stat_meta [] = {
 	{"__index", lbox_stat_index},
 	{"__call",  lbox_stat_call},
@@ -136,6 +300,11 @@ static const struct luaL_reg lbox_stat_net_meta [] = {
 	{NULL, NULL}
 };
 
+static const struct luaL_reg lbox_stat_hot_meta [] = {
+	{"__call",  lbox_stat_hot_call},
+	{NULL, NULL}
+};
+
 /** Initialize box.stat package. */
 void
 box_lua_stat_init(struct lua_State *L)
@@ -158,5 +327,17 @@ box_lua_stat_init(struct lua_State *L)
 	luaL_register(L, NULL, lbox_stat_net_meta);
 	lua_setmetatable(L, -2);
 	lua_pop(L, 1); /* stat net module */
+
+	static const struct luaL_reg hotlib [] = {
+		{"reset", lbox_stat_hot_reset},
+		{NULL, NULL}
+	};
+
+	luaL_register_module(L, "box.stat.hot", hotlib);
+
+	lua_newtable(L);
+	luaL_register(L, NULL, lbox_stat_hot_meta);
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1); /* stat hot module */
 }
 
@@ -0,0 +1,428 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_defrag.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "small/small.h"
+#include "memtx_engine.h"
+#include "memtx_space.h"
+#include "memtx_index.h"
+#include "memtx_tuple.h"
+#include "engine.h"
+#include "space.h"
+#include "schema.h"
+#include "tuple.h"
+#include "fiber.h"
+#include "ipc.h"
+#include "scoped_guard.h"
+#include "clock.h"
+#include "say.h"
+
+extern struct small_alloc memtx_alloc;
+
+enum {
+	/** Max number of tuples examined in one batch. */
+	MEMTX_DEFRAG_BATCH = 1000,
+	/**
+	 * A size class is defragmented if it has at least that
+	 * many slabs worth of free space.
+	 */
+	MEMTX_DEFRAG_MIN_FREE_SLABS = 2,
+};
+
+/** Max share of the tx thread time spent on defragmentation. */
+static const double MEMTX_DEFRAG_CPU_SHARE = 0.1;
+/** Pause between checks of the fragmentation, seconds. */
+static const double MEMTX_DEFRAG_PERIOD = 1.0;
+/** Pause while tuples can't be moved, seconds. */
+static const double MEMTX_DEFRAG_RETRY_DELAY = 0.1;
+
+/** A size class of the tuple allocator. */
+struct memtx_defrag_class {
+	/** Max size of an object in the class. */
+	uint32_t objsize;
+	/** Size of the slabs of the class. */
+	uint32_t slab_size;
+	/** True if the tuples of the class are moved. */
+	bool is_sparse;
+};
+
+static struct fiber *defrag_fiber;
+static double defrag_threshold;
+/** Set by memtx_defrag_run() to start a pass. */
+static bool defrag_is_requested;
+/** Broadcast at the end of each pass. */
+static struct ipc_cond defrag_cond;
+static struct memtx_defrag_stat defrag_stat;
+/** Results of the last pass. */
+static uint64_t defrag_last_moved;
+static uint64_t defrag_last_reclaimed;
+
+/** Size classes, collected for a pass and sorted by size. */
+static struct memtx_defrag_class *defrag_classes;
+static uint32_t defrag_class_count;
+static uint32_t defrag_class_max;
+
+/** Ids of the memtx spaces, collected for a pass. */
+static uint32_t *defrag_spaces;
+static uint32_t defrag_space_count;
+static uint32_t defrag_space_max;
+
+/** Tuples of the current batch. */
+static struct tuple *defrag_batch[MEMTX_DEFRAG_BATCH];
+
+void
+memtx_defrag_set_threshold(double threshold)
+{
+	defrag_threshold = threshold;
+}
+
+static int
+memtx_defrag_add_class(const struct mempool_stats *stats, void *ctx)
+{
+	(void) ctx;
+	if (defrag_class_count == defrag_class_max) {
+		uint32_t max = MAX(defrag_class_max * 2, 32);
+		struct memtx_defrag_class *classes =
+			(struct memtx_defrag_class *)
+			realloc(defrag_classes, max * sizeof(*classes));
+		if (classes == NULL)
+			return 0;
+		defrag_classes = classes;
+		defrag_class_max = max;
+	}
+	struct memtx_defrag_class *c = &defrag_classes[defrag_class_count++];
+	c->objsize = stats->objsize;
+	c->slab_size = stats->slabsize;
+	c->is_sparse = stats->totals.total - stats->totals.used >=
+		       (uint64_t) MEMTX_DEFRAG_MIN_FREE_SLABS * stats->slabsize;
+	return 0;
+}
+
+static int
+memtx_defrag_class_cmp(const void *a, const void *b)
+{
+	const struct memtx_defrag_class *ca =
+		(const struct memtx_defrag_class *) a;
+	const struct memtx_defrag_class *cb =
+		(const struct memtx_defrag_class *) b;
+	return ca->objsize < cb->objsize ? -1 : ca->objsize > cb->objsize;
+}
+
+/** Collect the size classes of the tuple allocator. */
+static void
+memtx_defrag_collect_classes(struct small_stats *totals)
+{
+	defrag_class_count = 0;
+	small_stats(&memtx_alloc, totals, memtx_defrag_add_class, NULL);
+	qsort(defrag_classes, defrag_class_count, sizeof(*defrag_classes),
+	      memtx_defrag_class_cmp);
+}
+
+/** Find the size class of an object, the smallest that fits. */
+static struct memtx_defrag_class *
+memtx_defrag_find_class(size_t size)
+{
+	uint32_t begin = 0, end = defrag_class_count;
+	while (begin < end) {
+		uint32_t mid = begin + (end - begin) / 2;
+		if (defrag_classes[mid].objsize < size)
+			begin = mid + 1;
+		else
+			end = mid;
+	}
+	return begin < defrag_class_count ? &defrag_classes[begin] : NULL;
+}
+
+static void
+memtx_defrag_add_space(struct space *space, void *udata)
+{
+	(void) udata;
+	if (!space_is_memtx(space) || space_is_system(space) ||
+	    space_index(space, 0) == NULL)
+		return;
+	if (defrag_space_count == defrag_space_max) {
+		uint32_t max = MAX(defrag_space_max * 2, 16);
+		uint32_t *spaces = (uint32_t *)
+			realloc(defrag_spaces, max * sizeof(*spaces));
+		if (spaces == NULL)
+			return;
+		defrag_spaces = spaces;
+		defrag_space_max = max;
+	}
+	defrag_spaces[defrag_space_count++] = space_id(space);
+}
+
+/**
+ * Return true if tuples can be moved now: no read view needs
+ * the old tuples and no transaction refers to them.
+ */
+static bool
+memtx_defrag_can_move(void)
+{
+	MemtxEngine *memtx = (MemtxEngine *) engine_find("memtx");
+	return !memtx_tuple_has_read_views() &&
+	       !memtx->hasActiveTransactions();
+}
+
+/**
+ * Collect the next batch of tuples of the primary key, starting
+ * after @a key, or from the beginning if @a key is NULL.
+ */
+static uint32_t
+memtx_defrag_collect_batch(MemtxIndex *pk, const char *key)
+{
+	struct iterator *it = pk->allocIterator();
+	auto guard = make_scoped_guard([=]{ it->free(it); });
+	if (key == NULL) {
+		pk->initIterator(it, ITER_ALL, NULL, 0);
+	} else {
+		pk->initIterator(it, ITER_GT, key,
+				 pk->key_def->part_count);
+	}
+	uint32_t count = 0;
+	struct tuple *tuple;
+	while (count < MEMTX_DEFRAG_BATCH && (tuple = it->next(it)) != NULL)
+		defrag_batch[count++] = tuple;
+	return count;
+}
+
+/** Move a tuple to a lower slab if its size class is sparse. */
+static bool
+memtx_defrag_move(struct space *space, struct tuple *tuple)
+{
+	/* Referenced by a request, a Lua object or a port. */
+	if (tuple->refs != 1)
+		return false;
+	struct memtx_defrag_class *c =
+		memtx_defrag_find_class(memtx_tuple_alloc_size(tuple));
+	if (c == NULL || !c->is_sparse)
+		return false;
+	struct tuple_format *format = tuple_format_by_id(tuple->format_id);
+	struct tuple *copy = memtx_tuple_move(format, tuple, c->slab_size);
+	if (copy == NULL)
+		return false;
+	try {
+		memtx_space_move_tuple(space, tuple, copy);
+	} catch (Exception *e) {
+		memtx_tuple_delete(format, copy);
+		throw;
+	}
+	return true;
+}
+
+/**
+ * Move the tuples of a space batch by batch. The fiber yields
+ * between batches, so the space is looked up again and the scan
+ * is continued from the last key. It is stopped if the schema
+ * changes meanwhile.
+ */
+static void
+memtx_defrag_space(uint32_t id, uint64_t *moved)
+{
+	char *key = NULL;
+	uint32_t key_size = 0;
+	uint32_t scv = sc_version;
+	auto guard = make_scoped_guard([&]{ free(key); });
+	while (!fiber_is_cancelled()) {
+		if (!memtx_defrag_can_move()) {
+			fiber_sleep(MEMTX_DEFRAG_RETRY_DELAY);
+			continue;
+		}
+		struct space *space = space_by_id(id);
+		if (space == NULL || sc_version != scv)
+			break;
+		struct MemtxSpace *handler = (struct MemtxSpace *) space->handler;
+		if (handler->replace != memtx_replace_all_keys)
+			break;
+		MemtxIndex *pk = (MemtxIndex *) space->index[0];
+		double start = clock_monotonic();
+		uint32_t count = memtx_defrag_collect_batch(pk, key);
+		if (count == 0)
+			break;
+		/* The last tuple may be moved, take its key first. */
+		uint32_t size;
+		const char *last = tuple_extract_key(defrag_batch[count - 1],
+						     pk->key_def, &size);
+		if (last == NULL)
+			diag_raise();
+		if (size > key_size) {
+			char *buf = (char *) realloc(key, size);
+			if (buf == NULL) {
+				tnt_raise(OutOfMemory, size, "realloc",
+					  "defrag key");
+			}
+			key = buf;
+			key_size = size;
+		}
+		memcpy(key, last, size);
+		fiber_gc();
+		for (uint32_t i = 0; i < count; i++) {
+			if (memtx_defrag_move(space, defrag_batch[i]))
+				++*moved;
+		}
+		if (count < MEMTX_DEFRAG_BATCH)
+			break;
+		/* Keep within the CPU budget. */
+		double elapsed = clock_monotonic() - start;
+		fiber_sleep(elapsed * (1 - MEMTX_DEFRAG_CPU_SHARE) /
+			    MEMTX_DEFRAG_CPU_SHARE);
+	}
+}
+
+static void
+memtx_defrag_pass(void)
+{
+	defrag_stat.is_running = true;
+	uint64_t moved = 0;
+	struct small_stats totals;
+	memtx_defrag_collect_classes(&totals);
+	uint64_t size_before = totals.total;
+	defrag_space_count = 0;
+	space_foreach(memtx_defrag_add_space, NULL);
+	for (uint32_t i = 0; i < defrag_space_count; i++) {
+		if (fiber_is_cancelled())
+			break;
+		try {
+			memtx_defrag_space(defrag_spaces[i], &moved);
+		} catch (Exception *e) {
+			e->log();
+			break;
+		}
+		fiber_gc();
+		/* The classes have changed meanwhile. */
+		memtx_defrag_collect_classes(&totals);
+	}
+	memtx_defrag_collect_classes(&totals);
+	uint64_t size_after = totals.total;
+	uint64_t reclaimed = size_before > size_after ?
+			     size_before - size_after : 0;
+	if (moved > 0) {
+		say_info("memtx defragmentation moved %llu tuples, "
+			 "reclaimed %llu bytes", (unsigned long long) moved,
+			 (unsigned long long) reclaimed);
+	}
+	defrag_last_moved = moved;
+	defrag_last_reclaimed = reclaimed;
+	defrag_stat.moved += moved;
+	defrag_stat.reclaimed += reclaimed;
+	defrag_stat.runs++;
+	defrag_stat.is_running = false;
+	ipc_cond_broadcast(&defrag_cond);
+}
+
+/**
+ * Return true if the ratio of memory used by tuples to the
+ * size of tuple slabs is below the threshold, and there is
+ * a size class to defragment.
+ */
+static bool
+memtx_defrag_is_needed(void)
+{
+	if (defrag_threshold <= 0)
+		return false;
+	struct small_stats totals;
+	memtx_defrag_collect_classes(&totals);
+	if (totals.total == 0 ||
+	    (double) totals.used / totals.total >= defrag_threshold)
+		return false;
+	for (uint32_t i = 0; i < defrag_class_count; i++) {
+		if (defrag_classes[i].is_sparse)
+			return true;
+	}
+	return false;
+}
+
+static int
+memtx_defrag_f(va_list ap)
+{
+	(void) ap;
+	while (!fiber_is_cancelled()) {
+		if (defrag_is_requested || memtx_defrag_is_needed()) {
+			defrag_is_requested = false;
+			memtx_defrag_pass();
+			/*
+			 * A pass which moved nothing means that the
+			 * fragmentation can't be reduced for now:
+			 * tuples are pinned, or spaces are too small
+			 * to free a slab. Don't retry before the next
+			 * period, and let other fibers run anyway.
+			 */
+			if (defrag_last_moved > 0 || defrag_is_requested) {
+				fiber_sleep(0);
+				continue;
+			}
+		}
+		fiber_sleep(MEMTX_DEFRAG_PERIOD);
+	}
+	return 0;
+}
+
+int
+memtx_defrag_run(uint64_t *moved, uint64_t *reclaimed)
+{
+	*moved = *reclaimed = 0;
+	if (defrag_fiber == NULL)
+		return 0;
+	/* Wait for the end of a pass started after the call. */
+	uint64_t runs = defrag_stat.runs + (defrag_stat.is_running ? 2 : 1);
+	defrag_is_requested = true;
+	if (!defrag_stat.is_running)
+		fiber_wakeup(defrag_fiber);
+	while (defrag_stat.runs < runs) {
+		ipc_cond_wait(&defrag_cond);
+		if (fiber_is_cancelled()) {
+			diag_set(FiberIsCancelled);
+			return -1;
+		}
+	}
+	*moved = defrag_last_moved;
+	*reclaimed = defrag_last_reclaimed;
+	return 0;
+}
+
+void
+memtx_defrag_stat(struct memtx_defrag_stat *stat)
+{
+	*stat = defrag_stat;
+}
+
+void
+memtx_defrag_init(void)
+{
+	ipc_cond_create(&defrag_cond);
+	defrag_fiber = fiber_new("defrag", memtx_defrag_f);
+	if (defrag_fiber == NULL)
+		panic("failed to start defragmentation fiber");
+	fiber_start(defrag_fiber);
+}
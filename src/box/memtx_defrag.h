@@ -0,0 +1,103 @@
+#ifndef INCLUDES_TARANTOOL_BOX_MEMTX_DEFRAG_H
+#define INCLUDES_TARANTOOL_BOX_MEMTX_DEFRAG_H
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Defragmentation of memtx tuple slabs.
+ *
+ * After large deletes or a drift of tuple sizes, many tuple
+ * slabs are nearly empty, but a slab is returned to the arena
+ * only when its last tuple is freed. A built-in fiber looks for
+ * size classes with at least a slab worth of free space and
+ * moves the tuples of those classes to non-full slabs with lower
+ * addresses, swapping the tuple pointers in all indexes. Emptied
+ * slabs with higher addresses are released by the allocator.
+ *
+ * A tuple is moved only if nothing but the indexes references
+ * it. The fiber pauses while a read view (a checkpoint or a read
+ * view scan) is open, since tuples freed then are kept until
+ * it is closed, and while memtx transactions are in progress,
+ * since their rollback refers to the tuples. It works in small
+ * batches, and sleeps after each batch to use at most
+ * MEMTX_DEFRAG_CPU_SHARE of the tx thread time.
+ */
+
+/** Defragmentation statistics, see box.slab.defrag_info(). */
+struct memtx_defrag_stat {
+	/** True if a pass is in progress. */
+	bool is_running;
+	/** Number of passes done. */
+	uint64_t runs;
+	/** Total number of tuples moved. */
+	uint64_t moved;
+	/** Total number of bytes of slabs released by the pass. */
+	uint64_t reclaimed;
+};
+
+/**
+ * Start a pass automatically when the ratio of memory used by
+ * tuples to memory of tuple slabs falls below @a threshold.
+ * 0 disables automatic defragmentation.
+ */
+void
+memtx_defrag_set_threshold(double threshold);
+
+/**
+ * Run a defragmentation pass now and wait for it to end.
+ * @param[out] moved number of tuples moved by the pass
+ * @param[out] reclaimed bytes of slabs released by the pass
+ * @retval 0 success
+ * @retval -1 the fiber was cancelled while waiting, diag is set
+ */
+int
+memtx_defrag_run(uint64_t *moved, uint64_t *reclaimed);
+
+/** Collect defragmentation statistics. */
+void
+memtx_defrag_stat(struct memtx_defrag_stat *stat);
+
+/** Start the defragmentation fiber, called when box is configured. */
+void
+memtx_defrag_init(void);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_MEMTX_DEFRAG_H */
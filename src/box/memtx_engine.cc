@@ -31,6 +31,7 @@
 #include "memtx_engine.h"
 #include "memtx_space.h"
 #include "memtx_tuple.h"
+#include "memtx_image.h"
 
 #include "coeio.h"
 #include "coeio_file.h"
@@ -125,12 +126,17 @@ MemtxEngine::MemtxEngine(const char *snap_dirname, bool force_recovery,
 	m_checkpoint(0),
 	m_state(MEMTX_INITIALIZED),
 	m_snap_io_rate_limit(0),
-	m_force_recovery(force_recovery)
+	m_force_recovery(force_recovery),
+	m_image_signature(-1),
+	m_image_space_id(BOX_ID_NIL),
+	m_image_loaded(false),
+	m_txn_count(0)
 {
 	memtx_tuple_init(tuple_arena_max_size, objsize_min, objsize_max,
 			 alloc_factor);
 
-	flags = ENGINE_CAN_BE_TEMPORARY;
+	flags = ENGINE_CAN_BE_TEMPORARY | ENGINE_CAN_EXPIRE |
+		ENGINE_CAN_MMAP_SNAPSHOT;
 	xdir_create(&m_snap_dir, snap_dirname, SNAP, &INSTANCE_UUID);
 	m_snap_dir.force_recovery = force_recovery;
 	xdir_scan_xc(&m_snap_dir);
@@ -166,8 +172,12 @@ MemtxEngine::recoverSnapshot()
 	struct xlog_cursor cursor;
 	xlog_cursor_open_xc(&cursor, filename);
 	INSTANCE_UUID = cursor.meta.instance_uuid;
+	m_image_signature = signature;
 	auto reader_guard = make_scoped_guard([&]{
 		xlog_cursor_close(&cursor, false);
+		m_image_signature = -1;
+		m_image_space_id = BOX_ID_NIL;
+		m_image_loaded = false;
 	});
 
 	struct xrow_header row;
@@ -212,6 +222,15 @@ MemtxEngine::recoverSnapshotRow(struct xrow_header *row)
 	/* memtx snapshot must contain only memtx spaces */
 	if (space->handler->engine != this)
 		tnt_raise(ClientError, ER_CROSS_ENGINE_TRANSACTION);
+	/* rows of a space are stored together */
+	if (space_id(space) != m_image_space_id) {
+		m_image_space_id = space_id(space);
+		m_image_loaded = recoverSnapshotImage(space);
+	}
+	if (m_image_loaded) {
+		fiber_gc();
+		return;
+	}
 	/* no access checks here - applier always works with admin privs */
 	space->handler->applyInitialJoinRow(space, request);
 	/*
@@ -223,6 +242,70 @@ MemtxEngine::recoverSnapshotRow(struct xrow_header *row)
 
 }
 
+/**
+ * Load the tuples of a space created with mmap_snapshot = true
+ * from its snapshot image, @sa memtx_image.h. Returns false if
+ * there is no usable image and the space must be recovered
+ * from the snapshot rows.
+ */
+bool
+MemtxEngine::recoverSnapshotImage(struct space *space)
+{
+	if (m_image_signature < 0 || !space->def.opts.mmap_snapshot)
+		return false;
+	struct MemtxSpace *handler = (struct MemtxSpace *) space->handler;
+	/*
+	 * In force_recovery mode all keys are enabled to detect
+	 * duplicates, tuples are inserted one by one.
+	 */
+	if (handler->replace != memtx_replace_build_next)
+		return false;
+
+	struct memtx_image image;
+	diag_clear(diag_get());
+	if (memtx_image_open(&image, m_snap_dir.dirname, space_id(space),
+			     m_image_signature) != 0) {
+		if (!diag_is_empty(diag_get())) {
+			error_log(diag_last_error(diag_get()));
+			diag_clear(diag_get());
+		}
+		return false;
+	}
+	say_info("recovering space '%s' from `%s'", space_name(space),
+		 image.filename);
+	/*
+	 * From now on the mapping is never unmapped: the loaded
+	 * tuples are used in place.
+	 */
+	memtx_tuple_add_mapping(image.map, image.map_size);
+	MemtxIndex *pk = (MemtxIndex *) space->index[0];
+	pk->reserve(image.tuple_count);
+	uint64_t tuple_count = 0;
+	char *data;
+	size_t size;
+	while (true) {
+		if (memtx_image_next(&image, &data, &size) != 0)
+			diag_raise();
+		if (data == NULL)
+			break;
+		struct tuple *tuple = memtx_tuple_from_image(space->format,
+							     data, size);
+		if (tuple == NULL)
+			diag_raise();
+		/* Tuples are stored in the primary key order. */
+		pk->buildNext(tuple);
+		space_bsize_update(space, NULL, tuple);
+		if (++tuple_count % 1000000 == 0)
+			say_info("%.1fM tuples loaded",
+				 tuple_count / 1000000.);
+	}
+	if (tuple_count != image.tuple_count) {
+		tnt_raise(ClientError, ER_INVALID_SNAP_IMAGE, image.filename,
+			  "tuple count mismatch");
+	}
+	return true;
+}
+
 /** Called at start to tell memtx to recover to a given LSN. */
 void
 MemtxEngine::beginInitialRecovery(struct vclock *vclock)
@@ -369,6 +452,18 @@ MemtxEngine::buildSecondaryKey(struct space *old_space,
 	IteratorGuard guard(it);
 	pk->initIterator(it, ITER_ALL, NULL, 0);
 
+	/*
+	 * An R-tree has no duplicates to check, so it's bulk
+	 * loaded, which is faster and gives a better tree than
+	 * insertion one by one.
+	 */
+	MemtxIndex *bulk_index = NULL;
+	if (new_key_def->type == RTREE) {
+		bulk_index = (MemtxIndex *) new_index;
+		bulk_index->beginBuild();
+		bulk_index->reserve(pk->size());
+	}
+
 	/*
 	 * The index has to be built tuple by tuple, since
 	 * there is no guarantee that all tuples satisfy
@@ -386,6 +481,10 @@ MemtxEngine::buildSecondaryKey(struct space *old_space,
 		 */
 		if (tuple_validate(format, tuple))
 			diag_raise();
+		if (bulk_index != NULL) {
+			bulk_index->buildNext(tuple);
+			continue;
+		}
 		/*
 		 * @todo: better message if there is a duplicate.
 		 */
@@ -394,11 +493,19 @@ MemtxEngine::buildSecondaryKey(struct space *old_space,
 		assert(old_tuple == NULL); /* Guaranteed by DUP_INSERT. */
 		(void) old_tuple;
 	}
+	if (bulk_index != NULL)
+		bulk_index->endBuild();
 }
 
 void
 MemtxEngine::keydefCheck(struct space *space, struct key_def *key_def)
 {
+	if (key_def->opts.include_mask != 0) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name,
+			  space_name(space),
+			  "memtx index can not include fields");
+	}
 	switch (key_def->type) {
 	case HASH:
 		if (! key_def->opts.is_unique) {
@@ -489,6 +596,7 @@ MemtxEngine::prepare(struct txn *txn)
 void
 MemtxEngine::begin(struct txn *txn)
 {
+	m_txn_count++;
 	/*
 	 * Register a trigger to rollback transaction on yield.
 	 * This must be done in begin(), since it's
@@ -516,6 +624,10 @@ MemtxEngine::rollbackStatement(struct txn *, struct txn_stmt *stmt)
 {
 	if (stmt->old_tuple == NULL && stmt->new_tuple == NULL)
 		return;
+	if (stmt->old_tuple == stmt->new_tuple) {
+		memtx_update_in_place_rollback(stmt);
+		return;
+	}
 	struct space *space = stmt->space;
 	int index_count;
 	struct MemtxSpace *handler = (struct MemtxSpace *) space->handler;
@@ -544,6 +656,8 @@ MemtxEngine::rollbackStatement(struct txn *, struct txn_stmt *stmt)
 void
 MemtxEngine::rollback(struct txn *txn)
 {
+	assert(m_txn_count > 0);
+	m_txn_count--;
 	prepare(txn);
 	struct txn_stmt *stmt;
 	stailq_reverse(&txn->stmts);
@@ -555,6 +669,8 @@ void
 MemtxEngine::commit(struct txn *txn, int64_t signature)
 {
 	(void) signature;
+	assert(m_txn_count > 0);
+	m_txn_count--;
 	struct txn_stmt *stmt;
 	stailq_foreach_entry(stmt, &txn->stmts, next) {
 		if (stmt->old_tuple)
@@ -642,9 +758,24 @@ checkpoint_write_tuple(struct xlog *l, uint32_t n, struct tuple *tuple)
 	checkpoint_write_row(l, &row);
 }
 
+static void
+checkpoint_write_image(struct memtx_image_writer *image, struct tuple *tuple)
+{
+	char head[MEMTX_TUPLE_IMAGE_HEAD_MAX];
+	struct iovec iov[2];
+	memtx_tuple_image(tuple, head, iov);
+	if (memtx_image_writer_add(image, iov, 2) != 0)
+		diag_raise();
+}
+
 struct checkpoint_entry {
 	struct space *space;
 	struct iterator *iterator;
+	/**
+	 * Writer of the snapshot image of a space created
+	 * with mmap_snapshot = true, NULL otherwise.
+	 */
+	struct memtx_image_writer *image;
 	struct rlist link;
 };
 
@@ -709,6 +840,11 @@ checkpoint_add_space(struct space *sp, void *data)
 	rlist_add_tail_entry(&ckpt->entries, entry, link);
 
 	entry->space = sp;
+	entry->image = NULL;
+	if (sp->def.opts.mmap_snapshot) {
+		entry->image = region_alloc_object_xc(&fiber()->gc,
+						      struct memtx_image_writer);
+	}
 	entry->iterator = pk->allocIterator();
 
 	pk->initIterator(entry->iterator, ITER_ALL, NULL, 0);
@@ -730,18 +866,62 @@ checkpoint_f(va_list ap)
 	say_info("saving snapshot `%s'", snap.filename);
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		struct memtx_image_writer *image = entry->image;
+		if (image != NULL &&
+		    memtx_image_writer_create(image, ckpt->dir.dirname,
+					      space_id(entry->space),
+					      vclock_sum(ckpt->vclock)) != 0)
+			diag_raise();
+		auto image_guard = make_scoped_guard([&]{
+			if (image != NULL)
+				memtx_image_writer_close(image);
+		});
 		struct tuple *tuple;
 		struct iterator *it = entry->iterator;
 		for (tuple = it->next(it); tuple; tuple = it->next(it)) {
 			checkpoint_write_tuple(&snap, space_id(entry->space),
 					       tuple);
+			if (image != NULL)
+				checkpoint_write_image(image, tuple);
 		}
+		image_guard.is_active = false;
+		if (image != NULL && memtx_image_writer_close(image) != 0)
+			diag_raise();
 	}
 	xlog_flush(&snap);
 	say_info("done");
 	return 0;
 }
 
+static ssize_t
+checkpoint_finish_image_f(va_list ap)
+{
+	const char *dirname = va_arg(ap, const char *);
+	uint32_t space_id = va_arg(ap, uint32_t);
+	bool commit = va_arg(ap, int);
+	return memtx_image_finish(dirname, space_id, commit);
+}
+
+/**
+ * Rename the snapshot images written by the checkpoint,
+ * or remove them if the checkpoint is aborted.
+ */
+static void
+checkpoint_finish_images(struct checkpoint *ckpt, bool commit)
+{
+	struct checkpoint_entry *entry;
+	rlist_foreach_entry(entry, &ckpt->entries, link) {
+		if (entry->image == NULL)
+			continue;
+		if (coio_call(checkpoint_finish_image_f, ckpt->dir.dirname,
+			      space_id(entry->space), (int) commit) != 0 &&
+		    !diag_is_empty(diag_get())) {
+			/* The space is recovered from the snapshot. */
+			error_log(diag_last_error(diag_get()));
+		}
+	}
+}
+
 int
 MemtxEngine::beginCheckpoint()
 {
@@ -801,6 +981,13 @@ MemtxEngine::commitCheckpoint(struct vclock *vclock)
 	if (rc != 0)
 		panic("can't rename .snap.inprogress");
 
+	/*
+	 * Images are renamed after the snapshot: an image left
+	 * from a previous checkpoint has a different signature
+	 * and is ignored at recovery.
+	 */
+	checkpoint_finish_images(m_checkpoint, true);
+
 	xdir_add_vclock(&m_snap_dir, m_checkpoint->vclock);
 	m_checkpoint->vclock = NULL;
 	checkpoint_destroy(m_checkpoint);
@@ -828,6 +1015,7 @@ MemtxEngine::abortCheckpoint()
 				     vclock_sum(m_checkpoint->vclock),
 				     INPROGRESS);
 	(void) coeio_unlink(filename);
+	checkpoint_finish_images(m_checkpoint, false);
 
 	checkpoint_destroy(m_checkpoint);
 	m_checkpoint = 0;
@@ -838,14 +1026,20 @@ memtx_collect_garbage_f(va_list ap)
 {
 	struct xdir *dir = va_arg(ap, struct xdir *);
 	int64_t lsn = va_arg(ap, int64_t);
+	int64_t last_lsn = va_arg(ap, int64_t);
 	xdir_collect_garbage(dir, lsn);
+	if (last_lsn >= 0)
+		memtx_image_collect_garbage(dir->dirname, last_lsn);
 	return 0;
 }
 
 void
 MemtxEngine::collectGarbage(int64_t lsn)
 {
-	coio_call(memtx_collect_garbage_f, &m_snap_dir, lsn);
+	/* Only the images of the last checkpoint are used. */
+	struct vclock vclock;
+	int64_t last_lsn = lastCheckpoint(&vclock);
+	coio_call(memtx_collect_garbage_f, &m_snap_dir, lsn, last_lsn);
 }
 
 /** Used to pass arguments to memtx_initial_join_f */
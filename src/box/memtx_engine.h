@@ -111,9 +111,20 @@ struct MemtxEngine: public Engine {
 	 */
 	int64_t lastCheckpoint(struct vclock *vclock);
 	void recoverSnapshot();
+	/**
+	 * Return true if there are transactions which changed
+	 * memtx indexes but are not committed or rolled back yet,
+	 * e.g. are waiting for WAL. Their tuples must not be moved.
+	 */
+	bool hasActiveTransactions() const
+	{
+		return m_txn_count > 0;
+	}
 private:
 	void
 	recoverSnapshotRow(struct xrow_header *row);
+	bool
+	recoverSnapshotImage(struct space *space);
 	/** Non-zero if there is a checkpoint (snapshot) in progress. */
 	struct checkpoint *m_checkpoint;
 	enum memtx_recovery_state m_state;
@@ -122,6 +133,21 @@ private:
 	/** Limit disk usage of checkpointing (bytes per second). */
 	uint64_t m_snap_io_rate_limit;
 	bool m_force_recovery;
+	/**
+	 * Signature of the snapshot being recovered, -1 if
+	 * snapshot images must not be used.
+	 */
+	int64_t m_image_signature;
+	/** Id of the space of the last recovered snapshot row. */
+	uint32_t m_image_space_id;
+	/**
+	 * True if the space of the last recovered snapshot row
+	 * has been loaded from its snapshot image, so that its
+	 * rows in the snapshot are skipped.
+	 */
+	bool m_image_loaded;
+	/** Number of transactions in progress. */
+	uint32_t m_txn_count;
 };
 
 enum {
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_image.h"
+
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "fio.h"
+#include "diag.h"
+#include "say.h"
+#include "errcode.h"
+
+static const char MEMTX_IMAGE_MAGIC[8] = "SNAPIMG";
+
+enum {
+	MEMTX_IMAGE_VERSION = 2,
+	/** Size of the writer buffer. */
+	MEMTX_IMAGE_BUF_SIZE = 1024 * 1024,
+	/**
+	 * Size of the prefix holding the size of a tuple image.
+	 * It is padded, so that the tuple is aligned as well.
+	 */
+	MEMTX_IMAGE_PREFIX_SIZE = MEMTX_IMAGE_ALIGN,
+};
+
+/** Size of a tuple image in the file, including its size prefix. */
+static inline size_t
+memtx_image_entry_size(size_t size)
+{
+	size += MEMTX_IMAGE_PREFIX_SIZE;
+	return (size + MEMTX_IMAGE_ALIGN - 1) & ~((size_t) MEMTX_IMAGE_ALIGN - 1);
+}
+
+static void
+memtx_image_filename(char *buf, size_t len, const char *dirname,
+		     uint32_t space_id, const char *suffix)
+{
+	snprintf(buf, len, "%s/%u.snapimg%s", dirname, space_id, suffix);
+}
+
+int
+memtx_image_writer_create(struct memtx_image_writer *writer,
+			  const char *dirname, uint32_t space_id,
+			  int64_t signature)
+{
+	/* Tuple images follow the header and must be aligned. */
+	assert(sizeof(writer->header) % MEMTX_IMAGE_ALIGN == 0);
+	memset(&writer->header, 0, sizeof(writer->header));
+	memcpy(writer->header.magic, MEMTX_IMAGE_MAGIC,
+	       sizeof(writer->header.magic));
+	writer->header.version = MEMTX_IMAGE_VERSION;
+	writer->header.space_id = space_id;
+	writer->header.signature = signature;
+	writer->buf_used = 0;
+	memtx_image_filename(writer->filename, sizeof(writer->filename),
+			     dirname, space_id, ".inprogress");
+	writer->buf = (char *) malloc(MEMTX_IMAGE_BUF_SIZE);
+	if (writer->buf == NULL) {
+		diag_set(OutOfMemory, MEMTX_IMAGE_BUF_SIZE, "malloc",
+			 "struct memtx_image_writer");
+		return -1;
+	}
+	writer->fd = open(writer->filename, O_WRONLY | O_CREAT | O_TRUNC,
+			  0644);
+	if (writer->fd < 0) {
+		diag_set(SystemError, "failed to create file '%s'",
+			 writer->filename);
+		free(writer->buf);
+		return -1;
+	}
+	/* The header is rewritten on close. */
+	if (fio_writen(writer->fd, &writer->header,
+		       sizeof(writer->header)) != 0) {
+		diag_set(SystemError, "failed to write file '%s'",
+			 writer->filename);
+		close(writer->fd);
+		free(writer->buf);
+		return -1;
+	}
+	return 0;
+}
+
+static int
+memtx_image_writer_flush(struct memtx_image_writer *writer)
+{
+	if (writer->buf_used == 0)
+		return 0;
+	if (fio_writen(writer->fd, writer->buf, writer->buf_used) != 0) {
+		diag_set(SystemError, "failed to write file '%s'",
+			 writer->filename);
+		return -1;
+	}
+	writer->buf_used = 0;
+	return 0;
+}
+
+int
+memtx_image_writer_add(struct memtx_image_writer *writer,
+		       const struct iovec *iov, int iovcnt)
+{
+	size_t size = 0;
+	for (int i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	assert(size <= UINT32_MAX);
+	size_t entry_size = memtx_image_entry_size(size);
+	if (writer->buf_used + entry_size > MEMTX_IMAGE_BUF_SIZE &&
+	    memtx_image_writer_flush(writer) != 0)
+		return -1;
+	char prefix[MEMTX_IMAGE_PREFIX_SIZE] = {0};
+	uint32_t size32 = size;
+	memcpy(prefix, &size32, sizeof(size32));
+	size_t pad_size = entry_size - sizeof(prefix) - size;
+	if (entry_size > MEMTX_IMAGE_BUF_SIZE) {
+		/* A huge tuple, bypass the buffer. */
+		static const char pad[MEMTX_IMAGE_ALIGN];
+		if (fio_writen(writer->fd, prefix, sizeof(prefix)) != 0)
+			goto error;
+		for (int i = 0; i < iovcnt; i++) {
+			if (fio_writen(writer->fd, iov[i].iov_base,
+				       iov[i].iov_len) != 0)
+				goto error;
+		}
+		if (fio_writen(writer->fd, pad, pad_size) != 0)
+			goto error;
+	} else {
+		char *pos = writer->buf + writer->buf_used;
+		memcpy(pos, prefix, sizeof(prefix));
+		pos += sizeof(prefix);
+		for (int i = 0; i < iovcnt; i++) {
+			memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+			pos += iov[i].iov_len;
+		}
+		memset(pos, 0, pad_size);
+		writer->buf_used += entry_size;
+	}
+	writer->header.tuple_count++;
+	writer->header.data_size += entry_size;
+	return 0;
+error:
+	diag_set(SystemError, "failed to write file '%s'", writer->filename);
+	return -1;
+}
+
+int
+memtx_image_writer_close(struct memtx_image_writer *writer)
+{
+	int rc = memtx_image_writer_flush(writer);
+	if (rc == 0 && (fio_lseek(writer->fd, 0, SEEK_SET) != 0 ||
+			fio_writen(writer->fd, &writer->header,
+				   sizeof(writer->header)) != 0 ||
+			fdatasync(writer->fd) != 0)) {
+		diag_set(SystemError, "failed to write file '%s'",
+			 writer->filename);
+		rc = -1;
+	}
+	close(writer->fd);
+	free(writer->buf);
+	return rc;
+}
+
+int
+memtx_image_finish(const char *dirname, uint32_t space_id, bool commit)
+{
+	char from[PATH_MAX];
+	memtx_image_filename(from, sizeof(from), dirname, space_id,
+			     ".inprogress");
+	if (!commit) {
+		if (unlink(from) != 0 && errno != ENOENT) {
+			diag_set(SystemError, "failed to unlink file '%s'",
+				 from);
+			return -1;
+		}
+		return 0;
+	}
+	char to[PATH_MAX];
+	memtx_image_filename(to, sizeof(to), dirname, space_id, "");
+	if (rename(from, to) != 0) {
+		diag_set(SystemError, "failed to rename file '%s'", from);
+		return -1;
+	}
+	return 0;
+}
+
+int
+memtx_image_open(struct memtx_image *image, const char *dirname,
+		 uint32_t space_id, int64_t signature)
+{
+	memtx_image_filename(image->filename, sizeof(image->filename),
+			     dirname, space_id, "");
+	int fd = open(image->filename, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			diag_set(SystemError, "failed to open file '%s'",
+				 image->filename);
+		return -1;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		diag_set(SystemError, "failed to stat file '%s'",
+			 image->filename);
+		close(fd);
+		return -1;
+	}
+	struct memtx_image_header header;
+	if ((size_t) st.st_size < sizeof(header)) {
+		diag_set(ClientError, ER_INVALID_SNAP_IMAGE,
+			 image->filename, "file is truncated");
+		close(fd);
+		return -1;
+	}
+	/*
+	 * A private mapping: tuples are changed in place while
+	 * loaded, and their reference counters are updated later,
+	 * none of which must get to the file.
+	 */
+	image->map_size = st.st_size;
+	image->map = (char *) mmap(NULL, image->map_size,
+				   PROT_READ | PROT_WRITE, MAP_PRIVATE,
+				   fd, 0);
+	close(fd);
+	if (image->map == MAP_FAILED) {
+		diag_set(SystemError, "failed to mmap file '%s'",
+			 image->filename);
+		return -1;
+	}
+	memcpy(&header, image->map, sizeof(header));
+	const char *reason = NULL;
+	if (memcmp(header.magic, MEMTX_IMAGE_MAGIC, sizeof(header.magic)) != 0)
+		reason = "bad magic";
+	else if (header.version != MEMTX_IMAGE_VERSION)
+		reason = "unsupported version";
+	else if (header.space_id != space_id)
+		reason = "space id mismatch";
+	else if (header.data_size != image->map_size - sizeof(header))
+		reason = "file is truncated";
+	else if (header.signature != signature)
+		reason = "belongs to another checkpoint";
+	if (reason != NULL) {
+		diag_set(ClientError, ER_INVALID_SNAP_IMAGE,
+			 image->filename, reason);
+		munmap(image->map, image->map_size);
+		return -1;
+	}
+	image->pos = image->map + sizeof(header);
+	image->end = image->pos + header.data_size;
+	image->tuple_count = header.tuple_count;
+	/* Tuples are read once, in order. */
+	madvise(image->map, image->map_size, MADV_SEQUENTIAL);
+	return 0;
+}
+
+int
+memtx_image_next(struct memtx_image *image, char **data, size_t *size)
+{
+	if (image->pos == image->end) {
+		*data = NULL;
+		return 0;
+	}
+	uint32_t size32;
+	if ((size_t) (image->end - image->pos) < MEMTX_IMAGE_PREFIX_SIZE)
+		goto corrupted;
+	memcpy(&size32, image->pos, sizeof(size32));
+	size_t entry_size = memtx_image_entry_size(size32);
+	if ((size_t) (image->end - image->pos) < entry_size)
+		goto corrupted;
+	*data = image->pos + MEMTX_IMAGE_PREFIX_SIZE;
+	*size = size32;
+	image->pos += entry_size;
+	return 0;
+corrupted:
+	diag_set(ClientError, ER_INVALID_SNAP_IMAGE, image->filename,
+		 "tuple is out of file bounds");
+	return -1;
+}
+
+void
+memtx_image_close(struct memtx_image *image)
+{
+	munmap(image->map, image->map_size);
+}
+
+void
+memtx_image_collect_garbage(const char *dirname, int64_t signature)
+{
+	DIR *dh = opendir(dirname);
+	if (dh == NULL) {
+		say_syserror("error reading directory '%s'", dirname);
+		return;
+	}
+	static const char suffix[] = ".snapimg";
+	struct dirent *dent;
+	while ((dent = readdir(dh)) != NULL) {
+		size_t len = strlen(dent->d_name);
+		if (len <= strlen(suffix) ||
+		    strcmp(dent->d_name + len - strlen(suffix), suffix) != 0)
+			continue;
+		char filename[PATH_MAX];
+		snprintf(filename, sizeof(filename), "%s/%s",
+			 dirname, dent->d_name);
+		struct memtx_image_header header;
+		int fd = open(filename, O_RDONLY);
+		if (fd < 0)
+			continue;
+		ssize_t rc = fio_read(fd, &header, sizeof(header));
+		close(fd);
+		/*
+		 * Every checkpoint rewrites the images of the existing
+		 * spaces, so an image of another checkpoint belongs
+		 * to a dropped space or is broken.
+		 */
+		if (rc == (ssize_t) sizeof(header) &&
+		    header.signature == signature)
+			continue;
+		say_info("removing %s", filename);
+		if (unlink(filename) < 0 && errno != ENOENT)
+			say_syserror("error while removing %s", filename);
+	}
+	closedir(dh);
+}
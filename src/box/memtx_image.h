@@ -0,0 +1,185 @@
+#ifndef INCLUDES_TARANTOOL_BOX_MEMTX_IMAGE_H
+#define INCLUDES_TARANTOOL_BOX_MEMTX_IMAGE_H
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <sys/uio.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Snapshot image of a memtx space.
+ *
+ * For spaces created with mmap_snapshot = true, a checkpoint
+ * writes, next to the .snap file, a file with raw images of
+ * the space tuples in the layout used by the memtx allocator,
+ * in the order of the primary key. At startup the file is
+ * mapped with MAP_PRIVATE, tuples are used in place and fed
+ * to the bulk build of the primary key, and the rows of the
+ * space in the .snap file are skipped. A write to a mapped
+ * tuple creates a new tuple in the memtx arena; the mapped
+ * pages are never freed.
+ *
+ * The file is named <space id>.snapimg and is replaced by
+ * every checkpoint. It is used only if its signature matches
+ * the signature of the snapshot being recovered, otherwise
+ * the space is recovered from the .snap file as usual.
+ */
+
+enum {
+	/** Alignment of tuple images in the file. */
+	MEMTX_IMAGE_ALIGN = 8,
+};
+
+/** The header of a snapshot image file. */
+struct memtx_image_header {
+	/** MEMTX_IMAGE_MAGIC. */
+	char magic[8];
+	/** Layout version, MEMTX_IMAGE_VERSION. */
+	uint32_t version;
+	/** Id of the space. */
+	uint32_t space_id;
+	/** Signature of the checkpoint the image belongs to. */
+	int64_t signature;
+	/** Number of tuples in the image. */
+	uint64_t tuple_count;
+	/** Size of the tuple images following the header. */
+	uint64_t data_size;
+};
+
+/** Writer of a snapshot image, used by the checkpoint thread. */
+struct memtx_image_writer {
+	/** Header, written on close. */
+	struct memtx_image_header header;
+	/** File descriptor of the .inprogress file. */
+	int fd;
+	/** Write buffer. */
+	char *buf;
+	/** Number of bytes used in the buffer. */
+	size_t buf_used;
+	/** Name of the .inprogress file. */
+	char filename[PATH_MAX];
+};
+
+/**
+ * Create <dirname>/<space_id>.snapimg.inprogress and prepare
+ * to write tuple images to it.
+ * @retval 0 success
+ * @retval -1 error, diag is set
+ */
+int
+memtx_image_writer_create(struct memtx_image_writer *writer,
+			  const char *dirname, uint32_t space_id,
+			  int64_t signature);
+
+/**
+ * Append the image of a memtx tuple, gathered from @a iov.
+ * Each image is prefixed with its size, the prefix and the
+ * image are padded to MEMTX_IMAGE_ALIGN, so the tuple data
+ * is aligned in the mapping. @sa memtx_tuple_image().
+ */
+int
+memtx_image_writer_add(struct memtx_image_writer *writer,
+		       const struct iovec *iov, int iovcnt);
+
+/**
+ * Flush the buffer, write the header, sync and close the file.
+ * Frees the writer resources even on error.
+ */
+int
+memtx_image_writer_close(struct memtx_image_writer *writer);
+
+/**
+ * Rename <space_id>.snapimg.inprogress to <space_id>.snapimg,
+ * or remove it if @a commit is false.
+ */
+int
+memtx_image_finish(const char *dirname, uint32_t space_id, bool commit);
+
+/** A mapped snapshot image. */
+struct memtx_image {
+	/** Start of the mapping, i.e. of the header. */
+	char *map;
+	/** Size of the mapping. */
+	size_t map_size;
+	/** The next tuple image. */
+	char *pos;
+	/** End of the tuple images. */
+	char *end;
+	/** Number of tuple images. */
+	uint64_t tuple_count;
+	/** Name of the file. */
+	char filename[PATH_MAX];
+};
+
+/**
+ * Map <dirname>/<space_id>.snapimg if it exists and belongs
+ * to the checkpoint with the given signature.
+ * @retval 0 success
+ * @retval -1 there is no usable image; diag is set unless
+ *         the file does not exist
+ */
+int
+memtx_image_open(struct memtx_image *image, const char *dirname,
+		 uint32_t space_id, int64_t signature);
+
+/**
+ * Get the next tuple image and its size, *data is set to NULL
+ * at the end of the file.
+ * @retval 0 success
+ * @retval -1 the file is corrupted, diag is set
+ */
+int
+memtx_image_next(struct memtx_image *image, char **data, size_t *size);
+
+/** Unmap the image. Only if none of its tuples were used. */
+void
+memtx_image_close(struct memtx_image *image);
+
+/**
+ * Remove the images in @a dirname which do not belong to the
+ * checkpoint with the given signature, e.g. images of dropped
+ * spaces.
+ */
+void
+memtx_image_collect_garbage(const char *dirname, int64_t signature);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_MEMTX_IMAGE_H */
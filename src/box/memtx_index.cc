@@ -55,6 +55,12 @@ void
 MemtxIndex::endBuild()
 {}
 
+void
+MemtxIndex::updateInPlace(struct tuple *old_tuple, struct tuple *new_tuple)
+{
+	replace(old_tuple, new_tuple, DUP_INSERT);
+}
+
 struct tuple *
 MemtxIndex::min(const char *key, uint32_t part_count) const
 {
@@ -35,7 +35,9 @@
 class MemtxIndex: public Index {
 public:
 	MemtxIndex(struct key_def *key_def_arg)
-		:Index(key_def_arg), m_position(NULL)
+		:Index(key_def_arg),
+		 column_mask(key_def_column_mask(key_def_arg)),
+		 m_position(NULL)
 	{}
 	virtual ~MemtxIndex() override {
 		if (m_position != NULL)
@@ -67,6 +69,23 @@ public:
 	virtual void reserve(uint32_t /* size_hint */);
 	virtual void buildNext(struct tuple *tuple);
 	virtual void endBuild();
+
+	/**
+	 * Replace old_tuple with new_tuple, which has exactly the
+	 * same key in this index. Used by UPDATE for secondary
+	 * indexes, none of which key parts was changed (@sa
+	 * column_mask), so the index may just swap the tuple
+	 * pointers instead of a delete and an insert.
+	 */
+	virtual void updateInPlace(struct tuple *old_tuple,
+				   struct tuple *new_tuple);
+
+	/**
+	 * Bitmask of the fields used in this index, @sa
+	 * key_def_column_mask(). An UPDATE which column mask
+	 * doesn't intersect with it doesn't change the key.
+	 */
+	uint64_t column_mask;
 protected:
 	/*
 	 * Pre-allocated iterator to speed up the main case of
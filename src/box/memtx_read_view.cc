@@ -0,0 +1,215 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_read_view.h"
+
+#include "memtx_tuple.h"
+#include "tuple.h"
+#include "index.h"
+#include "space.h"
+#include "schema.h"
+#include "port.h"
+#include "fiber.h"
+#include "scoped_guard.h"
+
+/** Arguments of the scan thread. */
+struct read_view_scan {
+	/** An iterator over the read view of the index. */
+	struct iterator *it;
+	box_read_view_cb cb;
+	void *arg;
+};
+
+static int
+read_view_scan_f(va_list ap)
+{
+	struct read_view_scan *scan = va_arg(ap, struct read_view_scan *);
+	struct iterator *it = scan->it;
+	struct tuple *tuple;
+	while ((tuple = it->next(it)) != NULL) {
+		uint32_t bsize;
+		const char *data = tuple_data_range(tuple, &bsize);
+		if (scan->cb(data, data + bsize, scan->arg) != 0)
+			break;
+	}
+	return 0;
+}
+
+int
+box_read_view_scan(uint32_t space_id, uint32_t index_id, int type,
+		   const char *key, const char *key_end,
+		   box_read_view_cb cb, void *arg)
+{
+	assert(key != NULL && key_end != NULL);
+	enum iterator_type itype = (enum iterator_type) type;
+	/*
+	 * The scan thread walks the index and the tuples of the
+	 * space, so the space and its indexes must not be altered
+	 * or dropped until it's over. DDL takes the same lock, as
+	 * it does for a checkpoint.
+	 */
+	latch_lock(&schema_lock);
+	auto lock_guard = make_scoped_guard([&]{ latch_unlock(&schema_lock); });
+	try {
+		struct space *space = space_cache_find(space_id);
+		access_check_space(space, PRIV_R);
+		Index *index = index_find_xc(space, index_id);
+		if (! space_is_memtx(space)) {
+			tnt_raise(ClientError, ER_UNSUPPORTED,
+				  space->handler->engine->name, "read view");
+		}
+		/*
+		 * Key comparisons need the tuple format, which may
+		 * be gone by the time the scan thread reads a
+		 * deleted tuple, so only the iterators positioned
+		 * once, in this thread, are allowed.
+		 */
+		switch (itype) {
+		case ITER_ALL:
+		case ITER_GE:
+		case ITER_GT:
+		case ITER_LE:
+		case ITER_LT:
+			break;
+		default:
+			tnt_raise(ClientError, ER_UNSUPPORTED, "read view",
+				  (unsigned) type < iterator_type_MAX ?
+				  iterator_type_strs[type] : "this iterator");
+		}
+		uint32_t part_count = mp_decode_array(&key);
+		if (key_validate(index->key_def, itype, key, part_count))
+			diag_raise();
+
+		struct iterator *it = index->allocIterator();
+		auto it_guard = make_scoped_guard([=]{ it->free(it); });
+		index->initIterator(it, itype, key, part_count);
+		index->createReadViewForIterator(it);
+		memtx_tuple_begin_snapshot();
+		auto read_view_guard = make_scoped_guard([=]{
+			memtx_tuple_end_snapshot();
+			index->destroyReadViewForIterator(it);
+		});
+
+		struct read_view_scan scan = { it, cb, arg };
+		struct cord cord;
+		if (cord_costart(&cord, "read_view", read_view_scan_f,
+				 &scan) != 0)
+			diag_raise();
+		if (cord_cojoin(&cord) != 0)
+			diag_raise();
+		return 0;
+	} catch (Exception *) {
+		return -1;
+	}
+}
+
+/** State of box_read_view_select(), filled by the scan thread. */
+struct read_view_select {
+	uint32_t offset;
+	uint32_t limit;
+	/** Number of tuples in the buffer. */
+	uint32_t count;
+	/** Tuple data, one MsgPack array after another. */
+	char *buf;
+	size_t used;
+	size_t size;
+	/** Set if the buffer could not be grown. */
+	bool is_oom;
+};
+
+static int
+read_view_select_cb(const char *data, const char *data_end, void *arg)
+{
+	struct read_view_select *select = (struct read_view_select *) arg;
+	if (select->offset > 0) {
+		select->offset--;
+		return 0;
+	}
+	if (select->count >= select->limit)
+		return 1;
+	size_t len = data_end - data;
+	if (select->used + len > select->size) {
+		size_t size = MAX(select->size * 2, select->used + len);
+		char *buf = (char *) realloc(select->buf, size);
+		if (buf == NULL) {
+			select->is_oom = true;
+			select->size = size;
+			return 1;
+		}
+		select->buf = buf;
+		select->size = size;
+	}
+	memcpy(select->buf + select->used, data, len);
+	select->used += len;
+	return ++select->count >= select->limit;
+}
+
+int
+box_read_view_select(struct port *port, uint32_t space_id,
+		     uint32_t index_id, int iterator, uint32_t offset,
+		     uint32_t limit, const char *key, const char *key_end)
+{
+	struct read_view_select select;
+	memset(&select, 0, sizeof(select));
+	select.offset = offset;
+	select.limit = limit;
+	auto buf_guard = make_scoped_guard([&]{ free(select.buf); });
+
+	if (box_read_view_scan(space_id, index_id, iterator, key, key_end,
+			       read_view_select_cb, &select) != 0)
+		return -1;
+	if (select.is_oom) {
+		diag_set(OutOfMemory, select.size, "realloc",
+			 "read view select");
+		return -1;
+	}
+	try {
+		const char *data = select.buf;
+		for (uint32_t i = 0; i < select.count; i++) {
+			const char *data_end = data;
+			mp_next(&data_end);
+			struct tuple *tuple =
+				memtx_tuple_new(tuple_format_default, data,
+						data_end);
+			if (tuple == NULL)
+				diag_raise();
+			try {
+				port_add_tuple(port, tuple);
+			} catch (Exception *) {
+				tuple_delete(tuple);
+				throw;
+			}
+			data = data_end;
+		}
+	} catch (Exception *) {
+		return -1;
+	}
+	return 0;
+}
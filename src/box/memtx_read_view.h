@@ -0,0 +1,104 @@
+#ifndef INCLUDES_TARANTOOL_BOX_MEMTX_READ_VIEW_H
+#define INCLUDES_TARANTOOL_BOX_MEMTX_READ_VIEW_H
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include "trivia/util.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct port;
+
+/** \cond public */
+
+/**
+ * A callback of box_read_view_scan(), invoked for every tuple
+ * of the read view in the scan thread.
+ *
+ * \param data tuple data in MsgPack Array format
+ * \param data_end the end of \a data
+ * \param arg the argument passed to box_read_view_scan()
+ * \retval 0 to continue the scan
+ * \retval non-zero to stop it
+ */
+typedef int
+(*box_read_view_cb)(const char *data, const char *data_end, void *arg);
+
+/**
+ * Scan an index of a memtx space in a separate thread, over a
+ * consistent read view of the space taken at the moment of the
+ * call. Writes to the space proceed while the scan is running and
+ * are not visible to it. The calling fiber yields until the scan
+ * is over. Schema changes wait until the scan is over, as well
+ * as other read view scans and checkpoints.
+ *
+ * \a cb is invoked in the scan thread, so it must not use fibers,
+ * Lua or box API, or the tuple data after it returns.
+ *
+ * Only iterators which need no key comparisons after the initial
+ * positioning are supported: ALL, GE, GT, LE and LT.
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param type iterator type, enum \link iterator_type \endlink
+ * \param key encoded key in MsgPack Array format ([part1, part2, ...])
+ * \param key_end the end of encoded \a key
+ * \param cb the callback invoked for each tuple
+ * \param arg the argument of \a cb
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ */
+API_EXPORT int
+box_read_view_scan(uint32_t space_id, uint32_t index_id, int type,
+		   const char *key, const char *key_end,
+		   box_read_view_cb cb, void *arg);
+
+/** \endcond public */
+
+/**
+ * Select tuples from a read view of a memtx space, like
+ * box_select() does from the space itself. The index is
+ * scanned by box_read_view_scan(); the result tuples are copies
+ * in the default tuple format.
+ */
+int
+box_read_view_select(struct port *port, uint32_t space_id,
+		     uint32_t index_id, int iterator, uint32_t offset,
+		     uint32_t limit, const char *key, const char *key_end);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_MEMTX_READ_VIEW_H */
@@ -126,6 +126,18 @@ extract_rectangle(struct rtree_rect *rect, const struct tuple *tuple,
 			  "Field", dimension, dimension * 2);
 	}
 }
+
+/**
+ * Exact rectangle of a tuple in an index with float coordinates.
+ * The tuple has been checked on insertion, so it doesn't throw.
+ */
+static void
+index_rtree_record_rect(void *ctx, record_t record, struct rtree_rect *rect)
+{
+	MemtxRTree *index = (MemtxRTree *)ctx;
+	extract_rectangle(rect, (struct tuple *)record, index->key_def);
+}
+
 /* {{{ MemtxRTree Iterators ****************************************/
 
 struct index_rtree_iterator {
@@ -186,6 +198,13 @@ MemtxRTree::MemtxRTree(struct key_def *key_def_arg)
 	rtree_init(&m_tree, m_dimension, MEMTX_EXTENT_SIZE,
 		   memtx_index_extent_alloc, memtx_index_extent_free, NULL,
 		   distance_type);
+	if (key_def->opts.coord_type == RTREE_INDEX_COORD_TYPE_FLOAT &&
+	    rtree_set_coord_type(&m_tree, RTREE_COORD_FLOAT,
+				 index_rtree_record_rect, this) != 0) {
+		rtree_destroy(&m_tree);
+		tnt_raise(OutOfMemory, sizeof(struct rtree_rect),
+			  "MemtxRTree", "coordinates");
+	}
 }
 
 size_t
@@ -306,3 +325,29 @@ MemtxRTree::beginBuild()
 	rtree_purge(&m_tree);
 }
 
+void
+MemtxRTree::reserve(uint32_t size_hint)
+{
+	if (rtree_build_reserve(&m_tree, size_hint) != 0) {
+		tnt_raise(OutOfMemory, size_hint * m_tree.page_branch_size,
+			  "MemtxRTree", "build");
+	}
+}
+
+void
+MemtxRTree::buildNext(struct tuple *tuple)
+{
+	struct rtree_rect rect;
+	extract_rectangle(&rect, tuple, key_def);
+	if (rtree_build_add(&m_tree, &rect, tuple) != 0) {
+		tnt_raise(OutOfMemory, m_tree.page_branch_size,
+			  "MemtxRTree", "build");
+	}
+}
+
+void
+MemtxRTree::endBuild()
+{
+	rtree_build(&m_tree);
+}
+
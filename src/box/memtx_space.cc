@@ -40,6 +40,7 @@
 #include "memtx_bitset.h"
 #include "port.h"
 #include "memtx_tuple.h"
+#include "tuple_update.h"
 
 /**
  * A version of space_replace for a space which has
@@ -233,6 +234,80 @@ memtx_replace_all_keys(struct txn_stmt *stmt, struct space *space,
 	space_bsize_update(space, old_tuple, new_tuple);
 }
 
+/**
+ * A version of memtx_replace_all_keys() for UPDATE of a space
+ * with all keys built.
+ *
+ * An UPDATE never changes the primary key, and usually leaves
+ * most of the secondary keys intact as well. A secondary index,
+ * none of which key parts is in @a column_mask (the mask of the
+ * fields changed by the update, @sa tuple_update_execute()),
+ * still has to reference the new tuple, but its key is the
+ * same, so the index swaps the tuple pointers in place instead
+ * of a delete and an insert, @sa MemtxIndex::updateInPlace().
+ *
+ * Statement rollback is the same as for memtx_replace_all_keys().
+ */
+static void
+memtx_update_all_keys(struct txn_stmt *stmt, struct space *space,
+		      uint64_t column_mask)
+{
+	struct tuple *old_tuple = stmt->old_tuple;
+	struct tuple *new_tuple = stmt->new_tuple;
+	assert(old_tuple != NULL && new_tuple != NULL);
+	memtx_index_extent_reserve(RESERVE_EXTENTS_BEFORE_REPLACE);
+	uint32_t i = 0;
+	try {
+		/* Update the primary key */
+		Index *pk = index_find_xc(space, 0);
+		assert(pk->key_def->opts.is_unique);
+		old_tuple = pk->replace(old_tuple, new_tuple, DUP_REPLACE);
+
+		/* Update secondary keys. */
+		for (i++; i < space->index_count; i++) {
+			MemtxIndex *index = (MemtxIndex *) space->index[i];
+			if ((column_mask & index->column_mask) == 0)
+				index->updateInPlace(old_tuple, new_tuple);
+			else
+				index->replace(old_tuple, new_tuple,
+					       DUP_INSERT);
+		}
+	} catch (Exception *e) {
+		/* Rollback all changes */
+		for (; i > 0; i--) {
+			Index *index = space->index[i-1];
+			index->replace(new_tuple, old_tuple, DUP_INSERT);
+		}
+		throw;
+	}
+	stmt->old_tuple = old_tuple;
+	stmt->engine_savepoint = stmt;
+	space_bsize_update(space, old_tuple, new_tuple);
+}
+
+void
+memtx_space_move_tuple(struct space *space, struct tuple *old_tuple,
+		       struct tuple *new_tuple)
+{
+	memtx_index_extent_reserve(RESERVE_EXTENTS_BEFORE_REPLACE);
+	uint32_t i = 0;
+	try {
+		/* The keys are the same, swap the pointers. */
+		for (; i < space->index_count; i++) {
+			MemtxIndex *index = (MemtxIndex *) space->index[i];
+			index->updateInPlace(old_tuple, new_tuple);
+		}
+	} catch (Exception *e) {
+		/* Rollback all changes */
+		for (; i > 0; i--) {
+			Index *index = space->index[i-1];
+			index->replace(new_tuple, old_tuple, DUP_INSERT);
+		}
+		throw;
+	}
+	tuple_ref_xc(new_tuple);
+	tuple_unref(old_tuple);
+}
 
 MemtxSpace::MemtxSpace(Engine *e)
 	: Handler(e)
@@ -290,9 +365,116 @@ MemtxSpace::prepareDelete(struct txn_stmt *stmt, struct space *space,
 	stmt->old_tuple = pk->findByKey(key, part_count);
 }
 
+/**
+ * Undo record of an UPDATE applied in place, stored in
+ * txn_stmt::engine_savepoint, @sa memtx_update_in_place().
+ */
+struct memtx_update_undo {
+	/** Old contents of the changed fields. */
+	struct tuple_update_patch *patches;
+	uint32_t patch_count;
+};
+
+/**
+ * Try to apply an UPDATE to the old tuple in place instead of
+ * building a new tuple, which copies the whole tuple to change
+ * a few bytes. This is possible if:
+ *
+ * - the tuple is referenced only by the space, so nobody (a Lua
+ *   object, a port, an earlier statement of this transaction)
+ *   can see it change;
+ * - the tuple isn't in the read view of a checkpoint in progress;
+ * - the tuple isn't loaded from a snapshot image: its pages
+ *   are shared with the file until written, and an update
+ *   would make a private copy of them;
+ * - the space has no on_replace triggers, which expect the old
+ *   and the new tuple to differ;
+ * - the update changes no key part of any index and keeps the
+ *   MsgPack size of every field it changes, so neither indexes
+ *   nor the field map need to be updated,
+ *   @sa tuple_update_execute_patch().
+ *
+ * On success, both stmt->old_tuple and stmt->new_tuple point
+ * to the updated tuple, and the old contents of the changed
+ * fields are saved on the region for statement rollback,
+ * @sa memtx_update_in_place_rollback().
+ *
+ * @retval true  the update was applied in place.
+ * @retval false the update must be done by creating a new tuple.
+ */
+static bool
+memtx_update_in_place(struct txn_stmt *stmt, struct space *space,
+		      struct request *request)
+{
+	struct tuple *tuple = stmt->old_tuple;
+	if (tuple->refs != 1 || memtx_tuple_is_in_read_view(tuple) ||
+	    memtx_tuple_is_from_image(tuple) ||
+	    !rlist_empty(&space->on_replace))
+		return false;
+
+	uint64_t key_mask = 0;
+	for (uint32_t i = 0; i < space->index_count; i++)
+		key_mask |= ((MemtxIndex *) space->index[i])->column_mask;
+
+	uint32_t bsize;
+	char *data = (char *) tuple_data_range(tuple, &bsize);
+	struct region *region = &fiber()->gc;
+	struct tuple_update_patch *patches;
+	uint32_t patch_count;
+	int rc = tuple_update_execute_patch(region_aligned_alloc_cb, region,
+					    request->tuple,
+					    request->tuple_end,
+					    data, data + bsize,
+					    request->index_base, key_mask,
+					    &patches, &patch_count);
+	if (rc < 0)
+		diag_raise();
+	if (rc > 0)
+		return false;
+
+	uint32_t undo_size = 0;
+	for (uint32_t i = 0; i < patch_count; i++)
+		undo_size += patches[i].size;
+	struct memtx_update_undo *undo =
+		region_alloc_object_xc(region, struct memtx_update_undo);
+	char *old_data = (char *) region_alloc_xc(region, undo_size);
+	/* Nothing can fail from now on. */
+	for (uint32_t i = 0; i < patch_count; i++) {
+		struct tuple_update_patch *patch = &patches[i];
+		memcpy(old_data, data + patch->offset, patch->size);
+		memcpy(data + patch->offset, patch->data, patch->size);
+		patch->data = old_data;
+		old_data += patch->size;
+	}
+	undo->patches = patches;
+	undo->patch_count = patch_count;
+	/* The reference of the new tuple, dropped on commit. */
+	tuple_ref(tuple);
+	stmt->new_tuple = tuple;
+	stmt->engine_savepoint = undo;
+	return true;
+}
+
+void
+memtx_update_in_place_rollback(struct txn_stmt *stmt)
+{
+	assert(stmt->old_tuple == stmt->new_tuple);
+	struct tuple *tuple = stmt->new_tuple;
+	struct memtx_update_undo *undo =
+		(struct memtx_update_undo *) stmt->engine_savepoint;
+	char *data = (char *) tuple_data(tuple);
+	for (uint32_t i = 0; i < undo->patch_count; i++) {
+		struct tuple_update_patch *patch = &undo->patches[i];
+		memcpy(data + patch->offset, patch->data, patch->size);
+	}
+	tuple_unref(tuple);
+	stmt->old_tuple = NULL;
+	stmt->new_tuple = NULL;
+}
+
 void
 MemtxSpace::prepareUpdate(struct txn_stmt *stmt, struct space *space,
-			  struct request *request)
+			  struct request *request, uint64_t *column_mask)
 {
 	/* Try to find the tuple by unique key. */
 	Index *pk = index_find_unique(space, request->index_id);
@@ -305,6 +487,9 @@ MemtxSpace::prepareUpdate(struct txn_stmt *stmt, struct space *space,
 	if (stmt->old_tuple == NULL)
 		return;
 
+	if (memtx_update_in_place(stmt, space, request))
+		return;
+
 	/* Update the tuple; legacy, request ops are in request->tuple */
 	uint32_t new_size = 0, bsize;
 	const char *old_data = tuple_data_range(stmt->old_tuple, &bsize);
@@ -312,7 +497,8 @@ MemtxSpace::prepareUpdate(struct txn_stmt *stmt, struct space *space,
 		tuple_update_execute(region_aligned_alloc_cb, &fiber()->gc,
 				     request->tuple, request->tuple_end,
 				     old_data, old_data + bsize,
-				     &new_size, request->index_base, NULL);
+				     &new_size, request->index_base,
+				     column_mask);
 	if (new_data == NULL)
 		diag_raise();
 
@@ -438,8 +624,15 @@ MemtxSpace::executeUpdate(struct txn *txn, struct space *space,
 			  struct request *request)
 {
 	struct txn_stmt *stmt = txn_current_stmt(txn);
-	prepareUpdate(stmt, space, request);
-	if (stmt->old_tuple)
+	uint64_t column_mask = UINT64_MAX;
+	prepareUpdate(stmt, space, request, &column_mask);
+	if (stmt->old_tuple == NULL)
+		return NULL;
+	if (stmt->new_tuple == stmt->old_tuple)
+		return stmt->new_tuple; /* updated in place */
+	if (this->replace == memtx_replace_all_keys)
+		memtx_update_all_keys(stmt, space, column_mask);
+	else
 		this->replace(stmt, space, DUP_REPLACE);
 	return stmt->new_tuple;
 }
@@ -469,6 +662,8 @@ MemtxSpace::createIndex(struct space *space, struct key_def *key_def_arg)
 	case HASH:
 		return new MemtxHash(key_def_arg);
 	case TREE:
+		if (memtx_tree_is_hinted(key_def_arg))
+			return new MemtxHintTree(key_def_arg);
 		return new MemtxTree(key_def_arg);
 	case RTREE:
 		return new MemtxRTree(key_def_arg);
@@ -48,6 +48,23 @@ void
 memtx_replace_all_keys(struct txn_stmt *, struct space *space,
 		       enum dup_replace_mode /* mode */);
 
+/**
+ * Roll back an UPDATE statement which was applied to the
+ * tuple in place, i.e. stmt->old_tuple == stmt->new_tuple.
+ */
+void
+memtx_update_in_place_rollback(struct txn_stmt *stmt);
+
+/**
+ * Make all indexes of the space reference @a new_tuple, a copy
+ * of @a old_tuple, instead of @a old_tuple, and release the old
+ * tuple. Used to move tuples between slabs, @sa memtx_defrag.h.
+ * All-or-nothing: on error no index is changed.
+ */
+void
+memtx_space_move_tuple(struct space *space, struct tuple *old_tuple,
+		       struct tuple *new_tuple);
+
 struct MemtxSpace: public Handler {
 	MemtxSpace(Engine *e);
 	virtual ~MemtxSpace()
@@ -97,7 +114,7 @@ private:
 		      struct request *request);
 	void
 	prepareUpdate(struct txn_stmt *stmt, struct space *space,
-		      struct request *request);
+		      struct request *request, uint64_t *column_mask);
 	void
 	prepareUpsert(struct txn_stmt *stmt, struct space *space,
 		      struct request *request);
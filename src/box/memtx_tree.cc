@@ -39,12 +39,6 @@
 
 /* {{{ Utilities. *************************************************/
 
-struct key_data
-{
-	const char *key;
-	uint32_t part_count;
-};
-
 int
 memtx_tree_compare(const tuple *a, const tuple *b, struct key_def *key_def)
 {
@@ -62,32 +56,278 @@ memtx_tree_compare_key(const tuple *a, const struct key_data *key_data,
 				      key_data->part_count, key_def);
 }
 
-int
+bool
+memtx_tree_is_hinted(struct key_def *key_def)
+{
+	if (!key_def->opts.hint)
+		return false;
+	switch (key_def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+	case FIELD_TYPE_INTEGER:
+	case FIELD_TYPE_STRING:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Compute the hint of a msgpack field of the first key part.
+ *
+ * A hint must be order preserving, i.e. if a < b then
+ * hint(a) <= hint(b), so two elements with different hints
+ * can be ordered without comparing the tuples.
+ *
+ * - UNSIGNED: the value itself.
+ * - INTEGER: the value shifted to the unsigned range, values
+ *   greater than INT64_MAX are all mapped to UINT64_MAX.
+ * - STRING: the first 8 bytes of the string in big-endian
+ *   order, padded with zeros.
+ *
+ * Indexes with other first part types are not hinted,
+ * @sa memtx_tree_is_hinted().
+ */
+static uint64_t
+memtx_tree_hint(const char *field, struct key_def *key_def)
+{
+	switch (key_def->parts[0].type) {
+	case FIELD_TYPE_UNSIGNED:
+		assert(mp_typeof(*field) == MP_UINT);
+		return mp_decode_uint(&field);
+	case FIELD_TYPE_INTEGER:
+		if (mp_typeof(*field) == MP_UINT) {
+			uint64_t val = mp_decode_uint(&field);
+			if (val > INT64_MAX)
+				return UINT64_MAX;
+			return val + (1ULL << 63);
+		} else {
+			assert(mp_typeof(*field) == MP_INT);
+			int64_t val = mp_decode_int(&field);
+			return (uint64_t)val ^ (1ULL << 63);
+		}
+	case FIELD_TYPE_STRING: {
+		assert(mp_typeof(*field) == MP_STR);
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		uint64_t hint = 0;
+		for (uint32_t i = 0; i < sizeof(hint); i++) {
+			hint <<= 8;
+			if (i < len)
+				hint |= (unsigned char)str[i];
+		}
+		return hint;
+	}
+	default:
+		unreachable();
+		return 0;
+	}
+}
+
+/* {{{ Elements of trees with and without hints. */
+
+static inline struct tuple *
+memtx_tree_elem_tuple(struct tuple *elem)
+{
+	return elem;
+}
+
+static inline struct tuple *
+memtx_tree_elem_tuple(const struct memtx_tree_data &elem)
+{
+	return elem.tuple;
+}
+
+template <bool HINT>
+static inline typename memtx_tree_type<HINT>::elem
+memtx_tree_elem(struct tuple *tuple, struct key_def *key_def);
+
+template <>
+inline struct tuple *
+memtx_tree_elem<false>(struct tuple *tuple, struct key_def *key_def)
+{
+	(void) key_def;
+	return tuple;
+}
+
+template <>
+inline struct memtx_tree_data
+memtx_tree_elem<true>(struct tuple *tuple, struct key_def *key_def)
+{
+	struct memtx_tree_data data;
+	data.tuple = tuple;
+	const char *field = tuple_field(tuple, key_def->parts[0].fieldno);
+	data.hint = memtx_tree_hint(field, key_def);
+	return data;
+}
+
+template <bool HINT>
+static inline void
+memtx_tree_key_data_create(struct key_data *key_data, const char *key,
+			   uint32_t part_count, struct key_def *key_def)
+{
+	key_data->key = key;
+	key_data->part_count = part_count;
+	key_data->hint = HINT && key != NULL && part_count > 0 ?
+			 memtx_tree_hint(key, key_def) : 0;
+}
+
+static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
 	return memtx_tree_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
+				  *(struct tuple **)b, (struct key_def *)c);
 }
 
+static int
+memtx_hint_tree_qcompare(const void* a, const void *b, void *c)
+{
+	const struct memtx_tree_data *data_a =
+		(const struct memtx_tree_data *)a;
+	const struct memtx_tree_data *data_b =
+		(const struct memtx_tree_data *)b;
+	if (data_a->hint != data_b->hint)
+		return memtx_tree_hint_compare(data_a->hint, data_b->hint);
+	return memtx_tree_compare(data_a->tuple, data_b->tuple,
+				  (struct key_def *)c);
+}
+
+/*
+ * The bps_tree API of both trees overloaded on the tree type,
+ * so that MemtxTreeT<> calls it by the same name.
+ */
+#define MEMTX_TREE_API(name, elem)					\
+static inline void							\
+tree_create(struct name *tree, struct key_def *key_def)		\
+{									\
+	name##_create(tree, key_def, memtx_index_extent_alloc,		\
+		      memtx_index_extent_free, NULL);			\
+}									\
+static inline void							\
+tree_destroy(struct name *tree)					\
+{									\
+	name##_destroy(tree);						\
+}									\
+static inline size_t							\
+tree_size(const struct name *tree)					\
+{									\
+	return name##_size(tree);					\
+}									\
+static inline size_t							\
+tree_mem_used(const struct name *tree)					\
+{									\
+	return name##_mem_used(tree);					\
+}									\
+static inline elem *							\
+tree_random(const struct name *tree, size_t rnd)			\
+{									\
+	return name##_random(tree, rnd);				\
+}									\
+static inline elem *							\
+tree_find(const struct name *tree, struct key_data *key)		\
+{									\
+	return name##_find(tree, key);					\
+}									\
+static inline int							\
+tree_insert(struct name *tree, elem new_elem, elem *replaced)		\
+{									\
+	return name##_insert(tree, new_elem, replaced);		\
+}									\
+static inline int							\
+tree_delete(struct name *tree, elem old_elem)				\
+{									\
+	return name##_delete(tree, old_elem);				\
+}									\
+static inline int							\
+tree_update(struct name *tree, elem old_elem, elem new_elem)		\
+{									\
+	return name##_update(tree, old_elem, new_elem);		\
+}									\
+static inline int							\
+tree_build(struct name *tree, elem *sorted_array, size_t count)	\
+{									\
+	return name##_build(tree, sorted_array, count);		\
+}									\
+static inline struct name##_iterator					\
+tree_invalid_iterator(const struct name *)				\
+{									\
+	return name##_invalid_iterator();				\
+}									\
+static inline struct name##_iterator					\
+tree_iterator_first(const struct name *tree)				\
+{									\
+	return name##_iterator_first(tree);				\
+}									\
+static inline struct name##_iterator					\
+tree_lower_bound(const struct name *tree, struct key_data *key,	\
+		 bool *exact)						\
+{									\
+	return name##_lower_bound(tree, key, exact);			\
+}									\
+static inline struct name##_iterator					\
+tree_upper_bound(const struct name *tree, struct key_data *key,	\
+		 bool *exact)						\
+{									\
+	return name##_upper_bound(tree, key, exact);			\
+}									\
+static inline elem *							\
+tree_iterator_get_elem(const struct name *tree,			\
+		       struct name##_iterator *itr)			\
+{									\
+	return name##_iterator_get_elem(tree, itr);			\
+}									\
+static inline bool							\
+tree_iterator_next(const struct name *tree,				\
+		   struct name##_iterator *itr)				\
+{									\
+	return name##_iterator_next(tree, itr);			\
+}									\
+static inline bool							\
+tree_iterator_prev(const struct name *tree,				\
+		   struct name##_iterator *itr)				\
+{									\
+	return name##_iterator_prev(tree, itr);			\
+}									\
+static inline void							\
+tree_iterator_freeze(struct name *tree, struct name##_iterator *itr)	\
+{									\
+	name##_iterator_freeze(tree, itr);				\
+}									\
+static inline void							\
+tree_iterator_destroy(struct name *tree, struct name##_iterator *itr)	\
+{									\
+	name##_iterator_destroy(tree, itr);				\
+}
+
+MEMTX_TREE_API(memtx_tree, struct tuple *)
+MEMTX_TREE_API(memtx_hint_tree, struct memtx_tree_data)
+
+#undef MEMTX_TREE_API
+
+/* }}} */
+
 /* {{{ MemtxTree Iterators ****************************************/
+template <bool HINT>
 struct tree_iterator {
 	struct iterator base;
-	const struct memtx_tree *tree;
+	const typename memtx_tree_type<HINT>::tree *tree;
 	struct key_def *key_def;
-	struct memtx_tree_iterator tree_iterator;
+	typename memtx_tree_type<HINT>::iterator tree_iterator;
 	struct key_data key_data;
 };
 
+template <bool HINT>
 static void
 tree_iterator_free(struct iterator *iterator);
 
-static inline struct tree_iterator *
-tree_iterator(struct iterator *it)
+template <bool HINT>
+static inline struct tree_iterator<HINT> *
+tree_iterator_cast(struct iterator *it)
 {
-	assert(it->free == tree_iterator_free);
-	return (struct tree_iterator *) it;
+	assert(it->free == tree_iterator_free<HINT>);
+	return (struct tree_iterator<HINT> *) it;
 }
 
+template <bool HINT>
 static void
 tree_iterator_free(struct iterator *iterator)
 {
@@ -101,161 +341,181 @@ tree_iterator_dummie(struct iterator *iterator)
 	return 0;
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_fwd(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	typename memtx_tree_type<HINT>::elem *res =
+		tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return *res;
+	tree_iterator_next(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_bwd(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	typename memtx_tree_type<HINT>::elem *res =
+		tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	return *res;
+	tree_iterator_prev(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_fwd_check_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	typename memtx_tree_type<HINT>::elem *res =
+		tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	if (memtx_tree_compare_key(*res, &it->key_data, it->key_def) != 0) {
-		it->tree_iterator = memtx_tree_invalid_iterator();
+	if (memtx_tree_compare_key(memtx_tree_elem_tuple(*res),
+				   &it->key_data, it->key_def) != 0) {
+		it->tree_iterator = tree_invalid_iterator(it->tree);
 		return 0;
 	}
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return *res;
+	tree_iterator_next(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_fwd_check_next_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	typename memtx_tree_type<HINT>::elem *res =
+		tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_fwd_check_equality;
-	return *res;
+	tree_iterator_next(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_fwd_check_equality<HINT>;
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_bwd_skip_one(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_bwd;
-	return tree_iterator_bwd(iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	tree_iterator_prev(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_bwd<HINT>;
+	return tree_iterator_bwd<HINT>(iterator);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_bwd_check_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	typename memtx_tree_type<HINT>::elem *res =
+		tree_iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	if (memtx_tree_compare_key(*res, &it->key_data, it->key_def) != 0) {
-		it->tree_iterator = memtx_tree_invalid_iterator();
+	if (memtx_tree_compare_key(memtx_tree_elem_tuple(*res),
+				   &it->key_data, it->key_def) != 0) {
+		it->tree_iterator = tree_invalid_iterator(it->tree);
 		return 0;
 	}
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	return *res;
+	tree_iterator_prev(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <bool HINT>
 static struct tuple *
 tree_iterator_bwd_skip_one_check_next_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_bwd_check_equality;
-	return tree_iterator_bwd_check_equality(iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	tree_iterator_prev(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_bwd_check_equality<HINT>;
+	return tree_iterator_bwd_check_equality<HINT>(iterator);
 }
 /* }}} */
 
 /* {{{ MemtxTree  **********************************************************/
 
-MemtxTree::MemtxTree(struct key_def *key_def_arg)
+template <bool HINT>
+MemtxTreeT<HINT>::MemtxTreeT(struct key_def *key_def_arg)
 	: MemtxIndex(key_def_arg), build_array(0), build_array_size(0),
 	  build_array_alloc_size(0)
 {
+	assert(HINT == memtx_tree_is_hinted(key_def));
 	memtx_index_arena_init();
-	memtx_tree_create(&tree, key_def,
-			      memtx_index_extent_alloc,
-			      memtx_index_extent_free, NULL);
+	tree_create(&tree, key_def);
 }
 
-MemtxTree::~MemtxTree()
+template <bool HINT>
+MemtxTreeT<HINT>::~MemtxTreeT()
 {
-	memtx_tree_destroy(&tree);
+	tree_destroy(&tree);
 	free(build_array);
 }
 
+template <bool HINT>
 size_t
-MemtxTree::size() const
+MemtxTreeT<HINT>::size() const
 {
-	return memtx_tree_size(&tree);
+	return tree_size(&tree);
 }
 
+template <bool HINT>
 size_t
-MemtxTree::bsize() const
+MemtxTreeT<HINT>::bsize() const
 {
-	return memtx_tree_mem_used(&tree);
+	return tree_mem_used(&tree);
 }
 
+template <bool HINT>
 struct tuple *
-MemtxTree::random(uint32_t rnd) const
+MemtxTreeT<HINT>::random(uint32_t rnd) const
 {
-	struct tuple **res = memtx_tree_random(&tree, rnd);
-	return res ? *res : 0;
+	elem_t *res = tree_random(&tree, rnd);
+	return res ? memtx_tree_elem_tuple(*res) : 0;
 }
 
+template <bool HINT>
 struct tuple *
-MemtxTree::findByKey(const char *key, uint32_t part_count) const
+MemtxTreeT<HINT>::findByKey(const char *key, uint32_t part_count) const
 {
 	assert(key_def->opts.is_unique && part_count == key_def->part_count);
 
 	struct key_data key_data;
-	key_data.key = key;
-	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&tree, &key_data);
-	return res ? *res : 0;
+	memtx_tree_key_data_create<HINT>(&key_data, key, part_count, key_def);
+	elem_t *res = tree_find(&tree, &key_data);
+	return res ? memtx_tree_elem_tuple(*res) : 0;
 }
 
+template <bool HINT>
 struct tuple *
-MemtxTree::replace(struct tuple *old_tuple, struct tuple *new_tuple,
-		   enum dup_replace_mode mode)
+MemtxTreeT<HINT>::replace(struct tuple *old_tuple, struct tuple *new_tuple,
+			  enum dup_replace_mode mode)
 {
 	uint32_t errcode;
 
 	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
+		elem_t new_data = memtx_tree_elem<HINT>(new_tuple, key_def);
+		elem_t dup_data = elem_t();
 
 		/* Try to optimistically replace the new_tuple. */
-		int tree_res =
-		memtx_tree_insert(&tree, new_tuple, &dup_tuple);
+		int tree_res = tree_insert(&tree, new_data, &dup_data);
 		if (tree_res) {
-			tnt_raise(OutOfMemory, BPS_TREE_EXTENT_SIZE,
+			tnt_raise(OutOfMemory, MEMTX_EXTENT_SIZE,
 				  "MemtxTree", "replace");
 		}
 
+		struct tuple *dup_tuple = memtx_tree_elem_tuple(dup_data);
 		errcode = replace_check_dup(old_tuple, dup_tuple, mode);
 
 		if (errcode) {
-			memtx_tree_delete(&tree, new_tuple);
+			tree_delete(&tree, new_data);
 			if (dup_tuple)
-				memtx_tree_insert(&tree, dup_tuple, 0);
+				tree_insert(&tree, dup_data, (elem_t *)NULL);
 			struct space *sp = space_cache_find(key_def->space_id);
 			tnt_raise(ClientError, errcode, index_name(this),
 				  space_name(sp));
@@ -264,34 +524,55 @@ MemtxTree::replace(struct tuple *old_tuple, struct tuple *new_tuple,
 			return dup_tuple;
 	}
 	if (old_tuple) {
-		memtx_tree_delete(&tree, old_tuple);
+		tree_delete(&tree, memtx_tree_elem<HINT>(old_tuple, key_def));
 	}
 	return old_tuple;
 }
 
+template <bool HINT>
+void
+MemtxTreeT<HINT>::updateInPlace(struct tuple *old_tuple,
+				struct tuple *new_tuple)
+{
+	/* The key is the same, and so is the hint. */
+	elem_t old_data = memtx_tree_elem<HINT>(old_tuple, key_def);
+	elem_t new_data = memtx_tree_elem<HINT>(new_tuple, key_def);
+	/*
+	 * Duplicates of a non-unique index are ordered by the
+	 * tuple pointer, so the new tuple keeps the position of
+	 * the old one only if no other duplicate is between them.
+	 * Otherwise fall back on delete and insert.
+	 */
+	if (tree_update(&tree, old_data, new_data) != 0)
+		replace(old_tuple, new_tuple, DUP_INSERT);
+}
+
+template <bool HINT>
 struct iterator *
-MemtxTree::allocIterator() const
+MemtxTreeT<HINT>::allocIterator() const
 {
-	struct tree_iterator *it = (struct tree_iterator *)
+	struct tree_iterator<HINT> *it = (struct tree_iterator<HINT> *)
 			calloc(1, sizeof(*it));
 	if (it == NULL) {
-		tnt_raise(OutOfMemory, sizeof(struct tree_iterator),
+		tnt_raise(OutOfMemory, sizeof(struct tree_iterator<HINT>),
 			  "MemtxTree", "iterator");
 	}
 
 	it->key_def = key_def;
 	it->tree = &tree;
-	it->base.free = tree_iterator_free;
-	it->tree_iterator = memtx_tree_invalid_iterator();
+	it->base.free = tree_iterator_free<HINT>;
+	it->tree_iterator = tree_invalid_iterator(&tree);
 	return (struct iterator *) it;
 }
 
+template <bool HINT>
 void
-MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
-			const char *key, uint32_t part_count) const
+MemtxTreeT<HINT>::initIterator(struct iterator *iterator,
+			       enum iterator_type type,
+			       const char *key, uint32_t part_count) const
 {
 	assert(part_count == 0 || key != NULL);
-	struct tree_iterator *it = tree_iterator(iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
 
 	if (part_count == 0) {
 		/*
@@ -305,24 +586,24 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
 		key = 0;
 	}
-	it->key_data.key = key;
-	it->key_data.part_count = part_count;
+	memtx_tree_key_data_create<HINT>(&it->key_data, key, part_count,
+					 key_def);
 
 	bool exact = false;
 	if (key == 0) {
 		if (iterator_type_is_reverse(type))
-			it->tree_iterator = memtx_tree_invalid_iterator();
+			it->tree_iterator = tree_invalid_iterator(&tree);
 		else
-			it->tree_iterator = memtx_tree_iterator_first(&tree);
+			it->tree_iterator = tree_iterator_first(&tree);
 	} else {
 		if (type == ITER_ALL || type == ITER_EQ || type == ITER_GE || type == ITER_LT) {
-			it->tree_iterator = memtx_tree_lower_bound(&tree, &it->key_data, &exact);
+			it->tree_iterator = tree_lower_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_EQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
 			}
 		} else { // ITER_GT, ITER_REQ, ITER_LE
-			it->tree_iterator = memtx_tree_upper_bound(&tree, &it->key_data, &exact);
+			it->tree_iterator = tree_upper_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_REQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
@@ -332,70 +613,78 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 
 	switch (type) {
 	case ITER_EQ:
-		it->base.next = tree_iterator_fwd_check_next_equality;
+		it->base.next = tree_iterator_fwd_check_next_equality<HINT>;
 		break;
 	case ITER_REQ:
-		it->base.next = tree_iterator_bwd_skip_one_check_next_equality;
+		it->base.next =
+			tree_iterator_bwd_skip_one_check_next_equality<HINT>;
 		break;
 	case ITER_ALL:
 	case ITER_GE:
-		it->base.next = tree_iterator_fwd;
+		it->base.next = tree_iterator_fwd<HINT>;
 		break;
 	case ITER_GT:
-		it->base.next = tree_iterator_fwd;
+		it->base.next = tree_iterator_fwd<HINT>;
 		break;
 	case ITER_LE:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = tree_iterator_bwd_skip_one<HINT>;
 		break;
 	case ITER_LT:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = tree_iterator_bwd_skip_one<HINT>;
 		break;
 	default:
 		return Index::initIterator(iterator, type, key, part_count);
 	}
 }
 
+template <bool HINT>
 void
-MemtxTree::beginBuild()
+MemtxTreeT<HINT>::beginBuild()
 {
-	assert(memtx_tree_size(&tree) == 0);
+	assert(tree_size(&tree) == 0);
 }
 
+template <bool HINT>
 void
-MemtxTree::reserve(uint32_t size_hint)
+MemtxTreeT<HINT>::reserve(uint32_t size_hint)
 {
 	if (size_hint < build_array_alloc_size)
 		return;
-	build_array = (struct tuple**)
-		realloc(build_array, size_hint * sizeof(struct tuple *));
+	build_array = (elem_t *)
+		realloc(build_array, size_hint * sizeof(*build_array));
 	build_array_alloc_size = size_hint;
 }
 
+template <bool HINT>
 void
-MemtxTree::buildNext(struct tuple *tuple)
+MemtxTreeT<HINT>::buildNext(struct tuple *tuple)
 {
 	if (!build_array) {
-		build_array = (struct tuple**)malloc(BPS_TREE_EXTENT_SIZE);
+		build_array = (elem_t *) malloc(MEMTX_EXTENT_SIZE);
 		build_array_alloc_size =
-			BPS_TREE_EXTENT_SIZE / sizeof(struct tuple*);
+			MEMTX_EXTENT_SIZE / sizeof(*build_array);
 	}
 	assert(build_array_size <= build_array_alloc_size);
 	if (build_array_size == build_array_alloc_size) {
 		build_array_alloc_size = build_array_alloc_size +
 					 build_array_alloc_size / 2;
-		build_array = (struct tuple**)
+		build_array = (elem_t *)
 			realloc(build_array,
 				build_array_alloc_size *
-				sizeof(struct tuple *));
+				sizeof(*build_array));
 	}
-	build_array[build_array_size++] = tuple;
+	build_array[build_array_size++] =
+		memtx_tree_elem<HINT>(tuple, key_def);
 }
 
+template <bool HINT>
 void
-MemtxTree::endBuild()
+MemtxTreeT<HINT>::endBuild()
 {
-	qsort_arg(build_array, build_array_size, sizeof(struct tuple *), memtx_tree_qcompare, key_def);
-	memtx_tree_build(&tree, build_array, build_array_size);
+	qsort_arg(build_array, build_array_size, sizeof(*build_array),
+		  HINT ? memtx_hint_tree_qcompare : memtx_tree_qcompare,
+		  key_def);
+	tree_build(&tree, build_array, build_array_size);
 
 	free(build_array);
 	build_array = 0;
@@ -407,22 +696,29 @@ MemtxTree::endBuild()
  * Create a read view for iterator so further index modifications
  * will not affect the iterator iteration.
  */
+template <bool HINT>
 void
-MemtxTree::createReadViewForIterator(struct iterator *iterator)
+MemtxTreeT<HINT>::createReadViewForIterator(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
-	memtx_tree_iterator_freeze(tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	tree_t *tree = (tree_t *)it->tree;
+	tree_iterator_freeze(tree, &it->tree_iterator);
 }
 
 /**
  * Destroy a read view of an iterator. Must be called for iterators,
  * for which createReadViewForIterator was called.
  */
+template <bool HINT>
 void
-MemtxTree::destroyReadViewForIterator(struct iterator *iterator)
+MemtxTreeT<HINT>::destroyReadViewForIterator(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
-	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	struct tree_iterator<HINT> *it = tree_iterator_cast<HINT>(iterator);
+	tree_t *tree = (tree_t *)it->tree;
+	tree_iterator_destroy(tree, &it->tree_iterator);
 }
+
+template class MemtxTreeT<false>;
+template class MemtxTreeT<true>;
+
+/* }}} */
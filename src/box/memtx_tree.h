@@ -35,7 +35,34 @@
 #include "memtx_engine.h"
 
 struct tuple;
-struct key_data;
+
+/**
+ * An element of a TREE index with key prefix hints.
+ *
+ * Along with the tuple pointer, it stores a hint - an order
+ * preserving 64-bit image of the first key part of the tuple
+ * (@sa memtx_tree_hint()). If the hints of two elements differ,
+ * they define the order of the elements, so most comparisons
+ * made during a tree descent are answered without dereferencing
+ * the tuple and decoding its msgpack.
+ *
+ * Hints double the size of an element, so they are used only
+ * by indexes created with the 'hint' option, and only if the
+ * first key part has a hintable type. Other TREE indexes store
+ * bare tuple pointers.
+ */
+struct memtx_tree_data {
+	struct tuple *tuple;
+	uint64_t hint;
+};
+
+/** A key to search in a TREE index. */
+struct key_data {
+	const char *key;
+	uint32_t part_count;
+	/** Hint of the key, used only by hinted trees. */
+	uint64_t hint;
+};
 
 int
 memtx_tree_compare(const struct tuple *a, const struct tuple *b, struct key_def *key_def);
@@ -43,6 +70,10 @@ memtx_tree_compare(const struct tuple *a, const struct tuple *b, struct key_def
 int
 memtx_tree_compare_key(const tuple *a, const key_data *b, struct key_def *key_def);
 
+/** True if a TREE index with this definition stores hints. */
+bool
+memtx_tree_is_hinted(struct key_def *key_def);
+
 #define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
@@ -54,10 +85,66 @@ memtx_tree_compare_key(const tuple *a, const key_data *b, struct key_def *key_de
 
 #include "salad/bps_tree.h"
 
-class MemtxTree: public MemtxIndex {
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+#define memtx_tree_hint_compare(a, b) ((a) < (b) ? -1 : 1)
+
+#define BPS_TREE_NAME memtx_hint_tree
+#define BPS_TREE_BLOCK_SIZE (512)
+#define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
+#define BPS_TREE_COMPARE(a, b, arg)\
+	((a).hint != (b).hint ? memtx_tree_hint_compare((a).hint, (b).hint) :\
+	 memtx_tree_compare((a).tuple, (b).tuple, arg))
+#define BPS_TREE_COMPARE_KEY(a, b, arg)\
+	((a).hint != (b)->hint ? memtx_tree_hint_compare((a).hint, (b)->hint) :\
+	 memtx_tree_compare_key((a).tuple, b, arg))
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).tuple == (b).tuple)
+#define bps_tree_elem_t struct memtx_tree_data
+#define bps_tree_key_t struct key_data *
+#define bps_tree_arg_t struct key_def *
+
+#include "salad/bps_tree.h"
+
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+/** Types of a TREE index with or without hints. */
+template <bool HINT> struct memtx_tree_type;
+
+template <> struct memtx_tree_type<false> {
+	typedef struct memtx_tree tree;
+	typedef struct memtx_tree_iterator iterator;
+	typedef struct tuple *elem;
+};
+
+template <> struct memtx_tree_type<true> {
+	typedef struct memtx_hint_tree tree;
+	typedef struct memtx_hint_tree_iterator iterator;
+	typedef struct memtx_tree_data elem;
+};
+
+template <bool HINT>
+class MemtxTreeT: public MemtxIndex {
 public:
-	MemtxTree(struct key_def *key_def);
-	virtual ~MemtxTree() override;
+	typedef typename memtx_tree_type<HINT>::tree tree_t;
+	typedef typename memtx_tree_type<HINT>::elem elem_t;
+
+	MemtxTreeT(struct key_def *key_def);
+	virtual ~MemtxTreeT() override;
 
 	virtual void beginBuild() override;
 	virtual void reserve(uint32_t size_hint) override;
@@ -70,6 +157,8 @@ public:
 	virtual struct tuple *replace(struct tuple *old_tuple,
 				      struct tuple *new_tuple,
 				      enum dup_replace_mode mode) override;
+	virtual void updateInPlace(struct tuple *old_tuple,
+				   struct tuple *new_tuple) override;
 
 	virtual size_t bsize() const override;
 	virtual struct iterator *allocIterator() const override;
@@ -90,9 +179,14 @@ public:
 	virtual void destroyReadViewForIterator(struct iterator *iterator) override;
 
 // protected:
-	struct memtx_tree tree;
-	struct tuple **build_array;
+	tree_t tree;
+	elem_t *build_array;
 	size_t build_array_size, build_array_alloc_size;
 };
 
+/** A TREE index of tuple pointers. */
+typedef MemtxTreeT<false> MemtxTree;
+/** A TREE index of tuple pointers with key prefix hints. */
+typedef MemtxTreeT<true> MemtxHintTree;
+
 #endif /* TARANTOOL_BOX_MEMTX_TREE_H_INCLUDED */
@@ -59,6 +59,18 @@ static struct quota memtx_quota;
 struct small_alloc memtx_alloc; /* used box box.slab.info() */
 
 uint32_t snapshot_version;
+/** Number of open read views, @sa memtx_tuple_begin_snapshot(). */
+static uint32_t snapshot_count;
+
+/** A memory mapped snapshot image, @sa memtx_image.h. */
+struct memtx_mapping {
+	char *addr;
+	size_t size;
+};
+
+/** Snapshot images tuples of which are used in place. */
+static struct memtx_mapping *memtx_mappings;
+static uint32_t memtx_mapping_count;
 
 enum {
 	/** Lowest allowed slab_alloc_minimal */
@@ -177,6 +189,19 @@ memtx_tuple_new(struct tuple_format *format, const char *data, const char *end)
 	return tuple;
 }
 
+/** Return true if the tuple lives in a snapshot image mapping. */
+static inline bool
+memtx_tuple_is_mapped(struct memtx_tuple *memtx_tuple)
+{
+	const char *addr = (const char *) memtx_tuple;
+	for (uint32_t i = 0; i < memtx_mapping_count; i++) {
+		if (addr >= memtx_mappings[i].addr &&
+		    addr < memtx_mappings[i].addr + memtx_mappings[i].size)
+			return true;
+	}
+	return false;
+}
+
 void
 memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 {
@@ -187,6 +212,8 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple)
 	tuple_format_ref(format, -1);
 	struct memtx_tuple *memtx_tuple =
 		container_of(tuple, struct memtx_tuple, base);
+	if (memtx_mapping_count > 0 && memtx_tuple_is_mapped(memtx_tuple))
+		return;
 	if (!memtx_alloc.is_delayed_free_mode ||
 	    memtx_tuple->version == snapshot_version)
 		smfree(&memtx_alloc, memtx_tuple, total);
@@ -198,13 +225,174 @@ void
 memtx_tuple_begin_snapshot()
 {
 	snapshot_version++;
-	small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, true);
+	if (snapshot_count++ == 0)
+		small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, true);
 }
 
 void
 memtx_tuple_end_snapshot()
 {
-	small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, false);
+	assert(snapshot_count > 0);
+	if (--snapshot_count == 0)
+		small_alloc_setopt(&memtx_alloc, SMALL_DELAYED_FREE_MODE, false);
+}
+
+bool
+memtx_tuple_is_in_read_view(struct tuple *tuple)
+{
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	return memtx_alloc.is_delayed_free_mode &&
+	       memtx_tuple->version != snapshot_version;
+}
+
+bool
+memtx_tuple_is_from_image(struct tuple *tuple)
+{
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	return memtx_mapping_count > 0 && memtx_tuple_is_mapped(memtx_tuple);
+}
+
+size_t
+memtx_tuple_image(struct tuple *tuple, char *head, struct iovec *iov)
+{
+	static_assert(sizeof(struct memtx_tuple) <= MEMTX_TUPLE_IMAGE_HEAD_MAX,
+		      "MEMTX_TUPLE_IMAGE_HEAD_MAX is too small");
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	struct memtx_tuple *image = (struct memtx_tuple *) head;
+	memcpy(image, memtx_tuple, sizeof(*image));
+	image->version = 0;
+	image->base.refs = 1;
+	iov[0].iov_base = head;
+	iov[0].iov_len = sizeof(*image);
+	iov[1].iov_base = (char *) tuple + sizeof(struct tuple);
+	iov[1].iov_len = tuple_size(tuple) - sizeof(struct tuple);
+	return iov[0].iov_len + iov[1].iov_len;
+}
+
+struct tuple *
+memtx_tuple_from_image(struct tuple_format *format, char *data, size_t size)
+{
+	struct memtx_tuple *memtx_tuple = (struct memtx_tuple *) data;
+	struct tuple *tuple = &memtx_tuple->base;
+	if (size < sizeof(struct memtx_tuple) ||
+	    tuple->data_offset < sizeof(struct tuple) ||
+	    size != sizeof(struct memtx_tuple) - sizeof(struct tuple) +
+		    tuple_size(tuple)) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "tuple image size");
+		return NULL;
+	}
+	char *raw = (char *) tuple + tuple->data_offset;
+	const char *end = raw + tuple->bsize;
+	const char *pos = raw;
+	if (tuple->bsize == 0 || mp_typeof(*raw) != MP_ARRAY ||
+	    mp_check(&pos, end) != 0 || pos != end) {
+		diag_set(ClientError, ER_INVALID_MSGPACK, "tuple image data");
+		return NULL;
+	}
+	size_t meta_size = tuple_format_meta_size(format);
+	if (tuple->data_offset != sizeof(struct tuple) + meta_size) {
+		/*
+		 * The field map of the space has changed since
+		 * the checkpoint, the tuple doesn't fit in place.
+		 */
+		struct tuple *copy = memtx_tuple_new(format, raw, end);
+		if (copy != NULL)
+			tuple_ref(copy);
+		return copy;
+	}
+	/*
+	 * Check the field map and fix it if the format offsets
+	 * have changed. Don't write to the page unless necessary.
+	 */
+	size_t field_map_size = format->field_map_size;
+	if (field_map_size > 0) {
+		struct region *region = &fiber()->gc;
+		size_t used = region_used(region);
+		char *buf = (char *) region_alloc(region, field_map_size);
+		if (buf == NULL) {
+			diag_set(OutOfMemory, field_map_size, "region",
+				 "field map");
+			return NULL;
+		}
+		memset(buf, 0, field_map_size);
+		if (tuple_init_field_map(format,
+					 (uint32_t *) (buf + field_map_size),
+					 raw) != 0) {
+			region_truncate(region, used);
+			return NULL;
+		}
+		if (memcmp(raw - field_map_size, buf, field_map_size) != 0)
+			memcpy(raw - field_map_size, buf, field_map_size);
+		region_truncate(region, used);
+	}
+	if (tuple->format_id != tuple_format_id(format))
+		tuple->format_id = tuple_format_id(format);
+	if (memtx_tuple->version != snapshot_version)
+		memtx_tuple->version = snapshot_version;
+	if (tuple->refs != 1)
+		tuple->refs = 1;
+	tuple_format_ref(format, 1);
+	return tuple;
+}
+
+void
+memtx_tuple_add_mapping(char *addr, size_t size)
+{
+	struct memtx_mapping *mappings = (struct memtx_mapping *)
+		realloc(memtx_mappings,
+			(memtx_mapping_count + 1) * sizeof(*mappings));
+	if (mappings == NULL)
+		panic("failed to allocate a memtx mapping");
+	memtx_mappings = mappings;
+	memtx_mappings[memtx_mapping_count].addr = addr;
+	memtx_mappings[memtx_mapping_count].size = size;
+	memtx_mapping_count++;
+}
+
+bool
+memtx_tuple_has_read_views(void)
+{
+	return snapshot_count > 0;
+}
+
+size_t
+memtx_tuple_alloc_size(struct tuple *tuple)
+{
+	return sizeof(struct memtx_tuple) - sizeof(struct tuple) +
+	       tuple_size(tuple);
+}
+
+struct tuple *
+memtx_tuple_move(struct tuple_format *format, struct tuple *tuple,
+		 size_t slab_size)
+{
+	struct memtx_tuple *memtx_tuple =
+		container_of(tuple, struct memtx_tuple, base);
+	if (memtx_mapping_count > 0 && memtx_tuple_is_mapped(memtx_tuple))
+		return NULL;
+	size_t total = memtx_tuple_alloc_size(tuple);
+	if (total > memtx_alloc.objsize_max)
+		return NULL;
+	struct memtx_tuple *copy =
+		(struct memtx_tuple *) smalloc(&memtx_alloc, total);
+	if (copy == NULL)
+		return NULL;
+	uintptr_t slab_mask = ~((uintptr_t) slab_size - 1);
+	if (((uintptr_t) copy & slab_mask) >=
+	    ((uintptr_t) memtx_tuple & slab_mask)) {
+		/* No free space in lower slabs. */
+		smfree(&memtx_alloc, copy, total);
+		return NULL;
+	}
+	memcpy(copy, memtx_tuple, total);
+	copy->version = snapshot_version;
+	copy->base.refs = 0;
+	tuple_format_ref(format, 1);
+	say_debug("%s(%p) = %p", __func__, memtx_tuple, copy);
+	return &copy->base;
 }
 
 box_tuple_t *
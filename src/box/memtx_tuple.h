@@ -31,6 +31,8 @@
  * SUCH DAMAGE.
  */
 
+#include <sys/uio.h>
+
 #include "diag.h"
 #include "tuple_format.h"
 #include "tuple.h"
@@ -66,12 +68,98 @@ memtx_tuple_delete(struct tuple_format *format, struct tuple *tuple);
 /** tuple format vtab for memtx engine. */
 extern struct tuple_format_vtab memtx_tuple_format_vtab;
 
+/**
+ * Open a consistent read view of memtx tuples: until the
+ * matching memtx_tuple_end_snapshot(), tuples allocated before
+ * this call are not freed, only put into the delayed free list.
+ * Used by checkpoints and read view scans, which may overlap,
+ * so the calls nest.
+ */
 void
 memtx_tuple_begin_snapshot();
 
+/**
+ * Return true if the tuple may be read by a checkpoint or a
+ * read view scan in progress, i.e. it was allocated before the
+ * last read view was opened. Such a tuple must not be changed
+ * in place.
+ */
+bool
+memtx_tuple_is_in_read_view(struct tuple *tuple);
+
+/** Return true if there is an open read view of memtx tuples. */
+bool
+memtx_tuple_has_read_views(void);
+
 void
 memtx_tuple_end_snapshot();
 
+enum {
+	/** Max size of the header of a tuple image. */
+	MEMTX_TUPLE_IMAGE_HEAD_MAX = 32,
+};
+
+/**
+ * Describe the image of a tuple for a snapshot image file,
+ * @sa memtx_image.h. The image has the layout of the tuple in
+ * the memtx arena. Its header is written to @a head, with the
+ * snapshot version and the reference counter reset to the
+ * values the tuple has after recovery, when it is referenced
+ * by the primary key only. @a iov[0] points to the header and
+ * @a iov[1] to the rest of the tuple.
+ *
+ * @return the size of the image
+ */
+size_t
+memtx_tuple_image(struct tuple *tuple, char *head, struct iovec *iov);
+
+/**
+ * Make the tuple image in a memory mapped snapshot image file
+ * a tuple of the given format, referenced once. The image is
+ * changed only if its format id or field map do not match the
+ * format, so most pages of the mapping stay clean. If the size
+ * of the field map has changed since the checkpoint, the tuple
+ * is copied to the memtx arena instead.
+ *
+ * @retval NULL the image is corrupted, diag is set
+ */
+struct tuple *
+memtx_tuple_from_image(struct tuple_format *format, char *data, size_t size);
+
+/**
+ * Register a memory mapped snapshot image. Tuples inside it are
+ * never freed, the mapping lives until the process exits.
+ */
+void
+memtx_tuple_add_mapping(char *addr, size_t size);
+
+/**
+ * Return true if the tuple lives in a memory mapped snapshot
+ * image. Such a tuple is never changed in place, a write to it
+ * creates a new tuple in the memtx arena.
+ */
+bool
+memtx_tuple_is_from_image(struct tuple *tuple);
+
+/** Size of the memory allocated for a memtx tuple. */
+size_t
+memtx_tuple_alloc_size(struct tuple *tuple);
+
+/**
+ * Copy a tuple to a slab with a lower address than the slab of
+ * the tuple, if the allocator has free space in one. The
+ * allocator takes objects from the non-full slab with the
+ * lowest address first, so moving tuples this way empties the
+ * slabs with higher addresses. @a slab_size is the size of the
+ * slabs of the tuple size class, slabs are aligned to it.
+ *
+ * @return the copy, not referenced, or NULL if the tuple can't
+ *         be moved
+ */
+struct tuple *
+memtx_tuple_move(struct tuple_format *format, struct tuple *tuple,
+		 size_t slab_size);
+
 /** \cond public */
 
 /**
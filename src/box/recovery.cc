@@ -39,6 +39,8 @@
 #include "replication.h"
 #include "session.h"
 #include "coeio_file.h"
+#include "cbus.h"
+#include "clock.h"
 
 /*
  * Recovery subsystem
@@ -174,6 +176,42 @@ recovery_exit(struct recovery *r)
 	recovery_delete(r);
 }
 
+/**
+ * Apply a row read from an xlog, unless it has been applied
+ * already. Return true if the row was applied.
+ */
+static bool
+recover_row(struct recovery *r, struct xstream *stream,
+	    struct xrow_header *row)
+{
+	int64_t current_lsn = vclock_get(&r->vclock, row->replica_id);
+	if (row->lsn <= current_lsn)
+		return false; /* already applied, skip */
+
+	try {
+		/*
+		 * All rows in xlog files have an assigned
+		 * replica id.
+		 */
+		assert(row->replica_id != 0);
+		/*
+		 * We can promote the vclock either before
+		 * or after xstream_write(): it only makes
+		 * any impact in case of forced recovery,
+		 * when we skip the failed row anyway.
+		 */
+		vclock_follow(&r->vclock,  row->replica_id, row->lsn);
+		xstream_write_xc(stream, row);
+		return true;
+	} catch (ClientError *e) {
+		say_error("can't apply row: ");
+		e->log();
+		if (!r->wal_dir.force_recovery)
+			throw;
+	}
+	return false;
+}
+
 /**
  * Read all rows in a file starting from the last position.
  * Advance the position. If end of file is reached,
@@ -200,37 +238,304 @@ recover_xlog(struct recovery *r, struct xstream *stream,
 		if (stop_vclock != NULL &&
 		    r->vclock.signature >= stop_vclock->signature)
 			return;
-		int64_t current_lsn = vclock_get(&r->vclock, row.replica_id);
-		if (row.lsn <= current_lsn)
-			continue; /* already applied, skip */
+		if (recover_row(r, stream, &row) &&
+		    ++row_count % 100000 == 0)
+			say_info("%.1fM rows processed",
+				 row_count / 1000000.);
+	}
+}
+
+/* {{{ Pipelined WAL reader */
+
+/*
+ * During initial recovery, reading, decompressing and decoding
+ * of rows is done by a separate thread, so that tx thread only
+ * has to apply them. The reader opens its own cursor, so it is
+ * only used for complete WALs, which recovery doesn't keep
+ * open. Decoded rows are sent to tx in batches, there are
+ * WAL_READER_BATCH_COUNT batches in flight: while tx applies
+ * one, the reader fills the other.
+ */
+
+enum {
+	/** Max number of rows in a batch. */
+	WAL_READER_BATCH_ROWS = 4096,
+	/** Max size of row bodies in a batch. */
+	WAL_READER_BATCH_SIZE = 4 * 1024 * 1024,
+	/** Number of batches cycling between the reader and tx. */
+	WAL_READER_BATCH_COUNT = 2,
+};
+
+struct wal_reader;
+
+/** A batch of decoded rows, filled by the reader thread. */
+struct wal_reader_batch {
+	struct cmsg base;
+	struct wal_reader *reader;
+	struct xrow_header rows[WAL_READER_BATCH_ROWS];
+	int row_count;
+	/** Copy of row bodies, the rows point into it. */
+	char *data;
+	size_t data_size;
+	size_t data_capacity;
+	/** True if this is the last batch of the file. */
+	bool is_last;
+	/** True if the batch is back in tx thread. */
+	bool is_ready;
+	/** The read error, if any. */
+	struct diag diag;
+};
+
+struct wal_reader {
+	struct cord cord;
+	/** The WAL to read. */
+	struct xdir *dir;
+	int64_t signature;
+	/** The cursor, accessed only in the reader thread. */
+	struct xlog_cursor cursor;
+	bool is_open;
+	bool is_done;
+	/** Pipe to the reader thread. */
+	struct cpipe reader_pipe;
+	/** Pipe from the reader thread to tx. */
+	struct cpipe tx_pipe;
+	struct cmsg_hop route[2];
+	/** The tx fiber waiting for a batch. */
+	struct fiber *waiter;
+	/** Rows read and time spent reading them, in the reader. */
+	int64_t read_rows;
+	double read_time;
+};
+
+/** Copy row bodies into the batch, storing offsets in the row. */
+static int
+wal_reader_batch_copy_row(struct wal_reader_batch *batch,
+			  struct xrow_header *row)
+{
+	for (int i = 0; i < row->bodycnt; i++) {
+		size_t len = row->body[i].iov_len;
+		if (batch->data_size + len > batch->data_capacity) {
+			size_t capacity = MAX(batch->data_capacity * 2,
+					      batch->data_size + len);
+			char *data = (char *) realloc(batch->data, capacity);
+			if (data == NULL) {
+				diag_set(OutOfMemory, capacity, "realloc",
+					 "wal reader batch");
+				return -1;
+			}
+			batch->data = data;
+			batch->data_capacity = capacity;
+		}
+		memcpy(batch->data + batch->data_size,
+		       row->body[i].iov_base, len);
+		row->body[i].iov_base = (void *) (uintptr_t) batch->data_size;
+		batch->data_size += len;
+	}
+	return 0;
+}
+
+/** Fill a batch with decoded rows. Invoked in the reader thread. */
+static void
+wal_reader_read_f(struct cmsg *m)
+{
+	struct wal_reader_batch *batch = (struct wal_reader_batch *) m;
+	struct wal_reader *reader = batch->reader;
+	struct xlog_cursor *cursor = &reader->cursor;
+	batch->row_count = 0;
+	batch->data_size = 0;
+	batch->is_last = reader->is_done;
+	if (reader->is_done)
+		return;
 
+	double start = clock_monotonic();
+	if (! reader->is_open) {
+		if (xdir_open_cursor(reader->dir, reader->signature,
+				     cursor) != 0)
+			goto error;
+		reader->is_open = true;
+	}
+	while (batch->row_count < WAL_READER_BATCH_ROWS &&
+	       batch->data_size < WAL_READER_BATCH_SIZE) {
+		struct xrow_header *row = &batch->rows[batch->row_count];
+		int rc = xlog_cursor_next(cursor, row,
+					  reader->dir->force_recovery);
+		if (rc < 0)
+			goto error;
+		if (rc > 0) {
+			if (cursor->state == XLOG_CURSOR_EOF) {
+				say_info("done `%s'", cursor->name);
+			} else {
+				say_warn("file `%s` wasn't correctly closed",
+					 cursor->name);
+			}
+			xlog_cursor_close(cursor, false);
+			reader->is_open = false;
+			reader->is_done = batch->is_last = true;
+			break;
+		}
+		if (wal_reader_batch_copy_row(batch, row) != 0)
+			goto error;
+		batch->row_count++;
+	}
+	/* The data buffer may have been moved, fix the rows. */
+	for (int i = 0; i < batch->row_count; i++) {
+		struct xrow_header *row = &batch->rows[i];
+		for (int j = 0; j < row->bodycnt; j++) {
+			row->body[j].iov_base = batch->data +
+				(uintptr_t) row->body[j].iov_base;
+		}
+	}
+	reader->read_rows += batch->row_count;
+	reader->read_time += clock_monotonic() - start;
+	return;
+error:
+	diag_move(diag_get(), &batch->diag);
+	reader->is_done = batch->is_last = true;
+}
+
+/** A batch is back in tx, wake up the waiter. */
+static void
+wal_reader_ready_f(struct cmsg *m)
+{
+	struct wal_reader_batch *batch = (struct wal_reader_batch *) m;
+	batch->is_ready = true;
+	if (batch->reader->waiter != NULL)
+		fiber_wakeup(batch->reader->waiter);
+}
+
+static int
+wal_reader_f(va_list ap)
+{
+	struct wal_reader *reader = va_arg(ap, struct wal_reader *);
+	struct cbus_endpoint endpoint;
+	cbus_endpoint_create(&endpoint, "wal_reader", fiber_schedule_cb,
+			     fiber());
+	/*
+	 * Use the high priority endpoint, the tx fiber pool
+	 * is not used during recovery.
+	 */
+	cpipe_create(&reader->tx_pipe, "tx_prio");
+	cbus_loop(&endpoint);
+	if (reader->is_open)
+		xlog_cursor_close(&reader->cursor, false);
+	cpipe_destroy(&reader->tx_pipe);
+	cbus_endpoint_destroy(&endpoint, cbus_process);
+	return 0;
+}
+
+/** Send a batch to the reader thread to be filled. */
+static void
+wal_reader_push(struct wal_reader *reader, struct wal_reader_batch *batch)
+{
+	batch->is_ready = false;
+	cmsg_init(&batch->base, reader->route);
+	cpipe_push(&reader->reader_pipe, &batch->base);
+}
+
+/** Wait until a batch is back from the reader thread. */
+static void
+wal_reader_wait(struct wal_reader *reader, struct wal_reader_batch *batch)
+{
+	reader->waiter = fiber();
+	while (! batch->is_ready)
+		fiber_yield();
+	reader->waiter = NULL;
+}
+
+/**
+ * Apply all rows of a complete WAL, decoded in a reader
+ * thread. Rows/s of each stage are logged at the end.
+ */
+static void
+recover_xlog_pipelined(struct recovery *r, struct xstream *stream,
+		       int64_t signature)
+{
+	struct wal_reader reader;
+	memset(&reader, 0, sizeof(reader));
+	reader.dir = &r->wal_dir;
+	reader.signature = signature;
+	reader.route[0] = { wal_reader_read_f, &reader.tx_pipe };
+	reader.route[1] = { wal_reader_ready_f, NULL };
+
+	struct wal_reader_batch *batches[WAL_READER_BATCH_COUNT];
+	for (int i = 0; i < WAL_READER_BATCH_COUNT; i++) {
+		batches[i] = (struct wal_reader_batch *)
+			calloc(1, sizeof(*batches[i]));
+		if (batches[i] == NULL) {
+			for (int j = 0; j < i; j++)
+				free(batches[j]);
+			tnt_raise(OutOfMemory, sizeof(*batches[i]), "calloc",
+				  "wal reader batch");
+		}
+		batches[i]->reader = &reader;
+		diag_create(&batches[i]->diag);
+	}
+	if (cord_costart(&reader.cord, "wal_reader", wal_reader_f,
+			 &reader) != 0) {
+		for (int i = 0; i < WAL_READER_BATCH_COUNT; i++)
+			free(batches[i]);
+		diag_raise();
+	}
+	cpipe_create(&reader.reader_pipe, "wal_reader");
+	for (int i = 0; i < WAL_READER_BATCH_COUNT; i++)
+		wal_reader_push(&reader, batches[i]);
+
+	uint64_t row_count = 0;
+	double apply_time = 0, wait_time = 0;
+	bool is_error = false;
+	for (int i = 0; ; i = (i + 1) % WAL_READER_BATCH_COUNT) {
+		struct wal_reader_batch *batch = batches[i];
+		double start = clock_monotonic();
+		wal_reader_wait(&reader, batch);
+		wait_time += clock_monotonic() - start;
+		if (! diag_is_empty(&batch->diag)) {
+			diag_move(&batch->diag, diag_get());
+			is_error = true;
+			break;
+		}
+		start = clock_monotonic();
 		try {
-			/*
-			 * All rows in xlog files have an assigned
-			 * replica id.
-			 */
-			assert(row.replica_id != 0);
-			/*
-			 * We can promote the vclock either before
-			 * or after xstream_write(): it only makes
-			 * any impact in case of forced recovery,
-			 * when we skip the failed row anyway.
-			 */
-			vclock_follow(&r->vclock,  row.replica_id, row.lsn);
-			xstream_write_xc(stream, &row);
-			++row_count;
-			if (row_count % 100000 == 0)
-				say_info("%.1fM rows processed",
-					 row_count / 1000000.);
-		} catch (ClientError *e) {
-			say_error("can't apply row: ");
-			e->log();
-			if (!r->wal_dir.force_recovery)
-				throw;
+			for (int j = 0; j < batch->row_count; j++) {
+				if (recover_row(r, stream, &batch->rows[j]) &&
+				    ++row_count % 100000 == 0)
+					say_info("%.1fM rows processed",
+						 row_count / 1000000.);
+			}
+			/* The rows are about to be overwritten. */
+			xstream_flush_xc(stream);
+		} catch (Exception *) {
+			/* Stop the reader outside of the catch block. */
+			is_error = true;
 		}
+		apply_time += clock_monotonic() - start;
+		if (is_error || batch->is_last)
+			break;
+		wal_reader_push(&reader, batch);
+	}
+	/* Wait for the batches still being filled. */
+	for (int i = 0; i < WAL_READER_BATCH_COUNT; i++)
+		wal_reader_wait(&reader, batches[i]);
+	cbus_stop_loop(&reader.reader_pipe);
+	cpipe_destroy(&reader.reader_pipe);
+	int rc = cord_cojoin(&reader.cord);
+	for (int i = 0; i < WAL_READER_BATCH_COUNT; i++) {
+		diag_destroy(&batches[i]->diag);
+		free(batches[i]->data);
+		free(batches[i]);
 	}
+	if (is_error || rc != 0)
+		diag_raise();
+
+	say_info("%lld rows read and decoded at %.0f rows/s, "
+		 "applied at %.0f rows/s, %.2f s waiting for the reader",
+		 (long long) reader.read_rows,
+		 reader.read_time > 0 ? reader.read_rows / reader.read_time : 0,
+		 apply_time > 0 ? reader.read_rows / apply_time : 0,
+		 wait_time);
 }
 
+/* }}} */
+
 /**
  * Find out if there are new .xlog files since the current
  * LSN, and read them all up.
@@ -306,6 +611,19 @@ recover_remaining_wals(struct recovery *r, struct xstream *stream,
 		}
 		recovery_close_log(r);
 
+		if (r->use_reader && stop_vclock == NULL &&
+		    vclockset_next(&r->wal_dir.index, clock) != NULL) {
+			/*
+			 * Not the last WAL, so it is not kept open
+			 * and can be read up by the reader thread.
+			 */
+			say_info("recover from `%s'",
+				 xdir_format_filename(&r->wal_dir,
+						      vclock_sum(clock), NONE));
+			recover_xlog_pipelined(r, stream, vclock_sum(clock));
+			continue;
+		}
+
 		xdir_open_cursor_xc(&r->wal_dir, vclock_sum(clock), &r->cursor);
 
 		say_info("recover from `%s'", r->cursor.name);
@@ -321,6 +639,9 @@ recover_current_wal:
 		 */
 	}
 
+	/* Push out rows buffered by the stream, if any. */
+	xstream_flush_xc(stream);
+
 	if (stop_vclock != NULL && vclock_compare(&r->vclock, stop_vclock) != 0)
 		tnt_raise(XlogGapError, &r->vclock, stop_vclock);
 
@@ -539,7 +860,11 @@ recovery_follow_local(struct recovery *r, struct xstream *stream,
 	 * Blocks until finished.
 	 */
 	xdir_scan_xc(&r->wal_dir);
+	r->use_reader = true;
+	auto reader_guard = make_scoped_guard([=]{ r->use_reader = false; });
 	recover_remaining_wals(r, stream, NULL);
+	reader_guard.is_active = false;
+	r->use_reader = false;
 	/*
 	 * Start 'hot_standby' background fiber to follow xlog changes.
 	 * It will pick up from the position of the currently open
@@ -54,6 +54,11 @@ struct recovery {
 	 * locally or send to the replica.
 	 */
 	struct fiber *watcher;
+	/**
+	 * Read and decode complete WALs in a separate thread.
+	 * Only set for the initial recovery of existing WALs.
+	 */
+	bool use_reader;
 };
 
 struct recovery *
@@ -32,6 +32,7 @@
  */
 #include "evio.h"
 #include "fiber.h"
+#include "small/ibuf.h"
 #include "vclock.h"
 #include "xstream.h"
 
@@ -48,6 +49,13 @@ struct relay {
 	uint64_t sync;
 	struct recovery *r;
 	struct xstream stream;
+	/**
+	 * Rows are encoded into this buffer and sent to the
+	 * replica in large batches rather than one by one, @sa
+	 * relay_send(). Lives in the relay's cord. Not used by
+	 * the initial join, which writes rows one by one.
+	 */
+	struct ibuf send_buf;
 	struct vclock stop_vclock;
 	ev_tstamp wal_dir_rescan_delay;
 	uint32_t replica_id;
@@ -77,6 +77,11 @@ struct session {
 	char salt[SESSION_SEED_SIZE];
 	/** Cached user id and global grants */
 	struct credentials credentials;
+	/**
+	 * Admission class of the session requests in iproto,
+	 * enum iproto_priority.
+	 */
+	uint8_t net_priority;
 	/** Trigger for fiber on_stop to cleanup created on-demand session */
 	struct trigger fiber_on_stop;
 };
@@ -0,0 +1,357 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "tuple_hash.h"
+#include "tuple.h"
+#include "third_party/PMurHash.h"
+#include "salad/wyhash.h"
+#include "trivia/util.h" /* likely, lengthof */
+
+enum {
+	HASH_SEED = 13U
+};
+
+/* {{{ Field hashers */
+
+/**
+ * Hash a field into the incremental MurmurHash3 state.
+ * Return the number of bytes hashed.
+ */
+template <int TYPE>
+static inline uint32_t
+field_hash(uint32_t *ph1, uint32_t *pcarry, const char **field)
+{
+	/*
+	 * (!) All fields but strings are hashed **including**
+	 * MsgPack format identifier (e.g. 0xcc). This was done
+	 * **intentionally** for performance reasons. Please
+	 * follow MsgPack specification and pack all your numbers
+	 * to the most compact representation. If you still want
+	 * to add support for broken MsgPack, please don't forget
+	 * to patch tuple_compare_field().
+	 */
+	const char *f = *field;
+	mp_next(field);
+	uint32_t size = *field - f;
+	assert(size < INT32_MAX);
+	PMurHash32_Process(ph1, pcarry, f, size);
+	return size;
+}
+
+template <>
+inline uint32_t
+field_hash<FIELD_TYPE_STRING>(uint32_t *ph1, uint32_t *pcarry,
+			      const char **field)
+{
+	/*
+	 * (!) MP_STR fields hashed **excluding** MsgPack format
+	 * indentifier. We have to do that to keep compatibility
+	 * with old third-party MsgPack (spec-old.md)
+	 * implementations.
+	 * \sa https://github.com/tarantool/tarantool/issues/522
+	 */
+	uint32_t size;
+	const char *f = mp_decode_str(field, &size);
+	assert(size < INT32_MAX);
+	PMurHash32_Process(ph1, pcarry, f, size);
+	return size;
+}
+
+static inline uint32_t
+field_hash_slowpath(uint32_t *ph1, uint32_t *pcarry, const char **field,
+		    enum field_type type)
+{
+	if (type == FIELD_TYPE_STRING)
+		return field_hash<FIELD_TYPE_STRING>(ph1, pcarry, field);
+	return field_hash<FIELD_TYPE_ANY>(ph1, pcarry, field);
+}
+
+/** Chain a field into a 64-bit wyhash value. */
+template <int TYPE>
+static inline uint64_t
+field_hash64(uint64_t h, const char **field)
+{
+	const char *f = *field;
+	mp_next(field);
+	return wyhash(f, *field - f, h);
+}
+
+template <>
+inline uint64_t
+field_hash64<FIELD_TYPE_UNSIGNED>(uint64_t h, const char **field)
+{
+	return wyhash_u64(mp_decode_uint(field), h);
+}
+
+template <>
+inline uint64_t
+field_hash64<FIELD_TYPE_STRING>(uint64_t h, const char **field)
+{
+	uint32_t size;
+	const char *f = mp_decode_str(field, &size);
+	return wyhash(f, size, h);
+}
+
+static inline uint64_t
+field_hash64_slowpath(uint64_t h, const char **field, enum field_type type)
+{
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+		return field_hash64<FIELD_TYPE_UNSIGNED>(h, field);
+	case FIELD_TYPE_STRING:
+		return field_hash64<FIELD_TYPE_STRING>(h, field);
+	default:
+		return field_hash64<FIELD_TYPE_ANY>(h, field);
+	}
+}
+
+/* }}} Field hashers */
+
+/* {{{ Generic hash functions */
+
+static uint32_t
+tuple_hash_slowpath(const struct tuple *tuple, const struct key_def *key_def)
+{
+	uint32_t h = HASH_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+
+	for (const struct key_part *part = key_def->parts;
+	     part < key_def->parts + key_def->part_count; part++) {
+		const char *field = tuple_field(tuple, part->fieldno);
+		total_size += field_hash_slowpath(&h, &carry, &field,
+						  part->type);
+	}
+
+	return PMurHash32_Result(h, carry, total_size);
+}
+
+static uint32_t
+key_hash_slowpath(const char *key, const struct key_def *key_def)
+{
+	uint32_t h = HASH_SEED;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+
+	for (const struct key_part *part = key_def->parts;
+	     part < key_def->parts + key_def->part_count; part++) {
+		total_size += field_hash_slowpath(&h, &carry, &key,
+						  part->type);
+	}
+
+	return PMurHash32_Result(h, carry, total_size);
+}
+
+static uint64_t
+tuple_hash64_slowpath(const struct tuple *tuple,
+		      const struct key_def *key_def)
+{
+	uint64_t h = HASH_SEED;
+	for (const struct key_part *part = key_def->parts;
+	     part < key_def->parts + key_def->part_count; part++) {
+		const char *field = tuple_field(tuple, part->fieldno);
+		h = field_hash64_slowpath(h, &field, part->type);
+	}
+	return h;
+}
+
+static uint64_t
+key_hash64_slowpath(const char *key, const struct key_def *key_def)
+{
+	uint64_t h = HASH_SEED;
+	for (const struct key_part *part = key_def->parts;
+	     part < key_def->parts + key_def->part_count; part++)
+		h = field_hash64_slowpath(h, &key, part->type);
+	return h;
+}
+
+static inline uint32_t
+hash_uint(uint64_t val)
+{
+	if (likely(val <= UINT32_MAX))
+		return val;
+	return ((uint32_t)((val)>>33^(val)^(val)<<11));
+}
+
+/**
+ * Speed up the simplest case when we have a single-part
+ * hash_table over an integer field.
+ */
+static uint32_t
+tuple_hash_uint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	const char *field = tuple_field(tuple, key_def->parts[0].fieldno);
+	return hash_uint(mp_decode_uint(&field));
+}
+
+static uint32_t
+key_hash_uint(const char *key, const struct key_def *)
+{
+	return hash_uint(mp_decode_uint(&key));
+}
+
+/* }}} Generic hash functions */
+
+/* {{{ Specialized hash functions */
+
+namespace {
+
+/**
+ * Hash a sequence of fields of the given types.
+ */
+template <int TYPE, int ...MORE_TYPES>
+struct KeyHash {
+	static uint32_t hash(uint32_t *ph1, uint32_t *pcarry,
+			     const char **key)
+	{
+		uint32_t size = field_hash<TYPE>(ph1, pcarry, key);
+		return size + KeyHash<MORE_TYPES...>::hash(ph1, pcarry, key);
+	}
+	static uint64_t hash64(uint64_t h, const char **key)
+	{
+		h = field_hash64<TYPE>(h, key);
+		return KeyHash<MORE_TYPES...>::hash64(h, key);
+	}
+};
+
+template <int TYPE>
+struct KeyHash<TYPE> {
+	static uint32_t hash(uint32_t *ph1, uint32_t *pcarry,
+			     const char **key)
+	{
+		return field_hash<TYPE>(ph1, pcarry, key);
+	}
+	static uint64_t hash64(uint64_t h, const char **key)
+	{
+		return field_hash64<TYPE>(h, key);
+	}
+};
+
+/**
+ * Hash functions for a key over the leading fields of a tuple,
+ * which can be read one by one with no field map lookups.
+ */
+template <int ...TYPES>
+struct TupleHash {
+	static uint32_t tuple_hash(const struct tuple *tuple,
+				   const struct key_def *)
+	{
+		const char *field = tuple_data(tuple);
+		mp_decode_array(&field);
+		return key_hash(field, NULL);
+	}
+	static uint32_t key_hash(const char *key, const struct key_def *)
+	{
+		uint32_t h = HASH_SEED;
+		uint32_t carry = 0;
+		uint32_t total_size = KeyHash<TYPES...>::hash(&h, &carry,
+							      &key);
+		return PMurHash32_Result(h, carry, total_size);
+	}
+	static uint64_t tuple_hash64(const struct tuple *tuple,
+				     const struct key_def *)
+	{
+		const char *field = tuple_data(tuple);
+		mp_decode_array(&field);
+		return key_hash64(field, NULL);
+	}
+	static uint64_t key_hash64(const char *key, const struct key_def *)
+	{
+		return KeyHash<TYPES...>::hash64(HASH_SEED, &key);
+	}
+};
+
+} /* end of anonymous namespace */
+
+struct hasher_signature {
+	tuple_hash_t tuple_hash;
+	key_hash_t key_hash;
+	tuple_hash64_t tuple_hash64;
+	key_hash64_t key_hash64;
+	uint32_t p[8];
+};
+#define HASHER(...) \
+	{ TupleHash<__VA_ARGS__>::tuple_hash, TupleHash<__VA_ARGS__>::key_hash, \
+	  TupleHash<__VA_ARGS__>::tuple_hash64, \
+	  TupleHash<__VA_ARGS__>::key_hash64, { __VA_ARGS__, UINT32_MAX } },
+
+/**
+ * field1 type, field2 type, ... for keys over fields 1, 2, ...
+ */
+static const hasher_signature hash_arr[] = {
+	HASHER(FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_UNSIGNED, FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
+	HASHER(FIELD_TYPE_STRING  , FIELD_TYPE_STRING  , FIELD_TYPE_STRING)
+};
+
+#undef HASHER
+
+void
+tuple_hash_func_set(struct key_def *def)
+{
+	def->tuple_hash = tuple_hash_slowpath;
+	def->key_hash = key_hash_slowpath;
+	def->tuple_hash64 = tuple_hash64_slowpath;
+	def->key_hash64 = key_hash64_slowpath;
+	if (key_def_is_sequential(def)) {
+		for (uint32_t k = 0; k < lengthof(hash_arr); k++) {
+			uint32_t i = 0;
+			for (; i < def->part_count; i++)
+				if (def->parts[i].type != hash_arr[k].p[i])
+					break;
+			if (i == def->part_count &&
+			    hash_arr[k].p[i] == UINT32_MAX) {
+				def->tuple_hash = hash_arr[k].tuple_hash;
+				def->key_hash = hash_arr[k].key_hash;
+				def->tuple_hash64 = hash_arr[k].tuple_hash64;
+				def->key_hash64 = hash_arr[k].key_hash64;
+				break;
+			}
+		}
+	}
+	if (def->part_count == 1 &&
+	    def->parts[0].type == FIELD_TYPE_UNSIGNED) {
+		def->tuple_hash = tuple_hash_uint;
+		def->key_hash = key_hash_uint;
+	}
+}
+
+/* }}} Specialized hash functions */
@@ -0,0 +1,126 @@
+#ifndef TARANTOOL_BOX_TUPLE_HASH_H_INCLUDED
+#define TARANTOOL_BOX_TUPLE_HASH_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "key_def.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct tuple;
+
+/**
+ * Initialize the hash functions of the key_def. Keys of the
+ * common shapes, (unsigned), (string) and their combinations
+ * over the leading fields, get specialized functions which
+ * don't look up the field types and offsets at run time.
+ *
+ * @param key_def key definition
+ */
+void
+tuple_hash_func_set(struct key_def *key_def);
+
+/**
+ * Calculate a common hash value for a tuple.
+ *
+ * The value is MurmurHash3 (PMurHash32) over the key parts:
+ * strings are hashed without the MsgPack header, all other
+ * types with it. A single unsigned part is hashed to itself.
+ * memtx HASH indexes depend on it, so the value must not
+ * change.
+ *
+ * @param tuple - a tuple
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint32_t
+tuple_hash(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return key_def->tuple_hash(tuple, key_def);
+}
+
+/**
+ * Calculate a common hash value for a full key.
+ * @sa tuple_hash()
+ *
+ * @param key - full key (msgpack fields w/o array marker)
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint32_t
+key_hash(const char *key, const struct key_def *key_def)
+{
+	return key_def->key_hash(key, key_def);
+}
+
+/**
+ * Calculate a 64-bit hash value for a tuple.
+ *
+ * The value is a chain of wyhash over the key parts: unsigned
+ * parts are hashed by value, strings without the MsgPack
+ * header, all other types with it. Unlike tuple_hash() the
+ * bits are well mixed even for sequential integer keys, which
+ * matters for bloom filters. The value is stored on disk in
+ * vinyl run bloom filters and must not change.
+ *
+ * @param tuple - a tuple
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint64_t
+tuple_hash64(const struct tuple *tuple, const struct key_def *key_def)
+{
+	return key_def->tuple_hash64(tuple, key_def);
+}
+
+/**
+ * Calculate a 64-bit hash value for a full key.
+ * @sa tuple_hash64()
+ *
+ * @param key - full key (msgpack fields w/o array marker)
+ * @param key_def - key_def for field description
+ * @return - hash value
+ */
+static inline uint64_t
+key_hash64(const char *key, const struct key_def *key_def)
+{
+	return key_def->key_hash64(key, key_def);
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_BOX_TUPLE_HASH_H_INCLUDED */
@@ -1004,9 +1004,12 @@ update_read_ops(struct tuple_update *update, const char *expr,
 		if (column_mask != UINT64_MAX) {
 			/*
 			 * The optimization is only used if update
-			 * doesn't touch outside range [0..63]
+			 * doesn't touch outside range [0..63].
+			 * A negative field number is counted from
+			 * the end of the tuple, so it may refer to
+			 * any field.
 			 */
-			if (op->field_no > 63) {
+			if (op->field_no < 0 || op->field_no > 63) {
 				column_mask = UINT64_MAX;
 			} else {
 				/*
@@ -1144,6 +1147,87 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 	return update_finish(&update, p_tuple_len);
 }
 
+int
+tuple_update_execute_patch(tuple_update_alloc_func alloc, void *alloc_ctx,
+			   const char *expr, const char *expr_end,
+			   const char *old_data, const char *old_data_end,
+			   int index_base, uint64_t key_mask,
+			   struct tuple_update_patch **p_patches,
+			   uint32_t *p_patch_count)
+{
+	struct tuple_update update;
+	update_init(&update, alloc, alloc_ctx, index_base);
+
+	if (update_read_ops(&update, expr, expr_end))
+		return -1;
+	/* Reject what obviously can't be done in place early. */
+	if ((update.column_mask & key_mask) != 0)
+		return 1;
+	struct update_op *op = update.ops;
+	struct update_op *ops_end = op + update.op_count;
+	for (; op < ops_end; op++) {
+		if (op->meta != &op_set && op->meta != &op_arith &&
+		    op->meta != &op_bit)
+			return 1;
+	}
+	if (update.op_count == 0) {
+		*p_patches = NULL;
+		*p_patch_count = 0;
+		return 0;
+	}
+	const char *data = old_data;
+	uint32_t field_count = mp_decode_array(&data);
+	if (update_do_ops(&update, old_data, old_data_end))
+		return -1;
+	/* '=' on the field next to the last one is an insert. */
+	if (rope_size(update.rope) != field_count)
+		return 1;
+
+	struct tuple_update_patch *patches = (struct tuple_update_patch *)
+		update.alloc(update.alloc_ctx,
+			     update.op_count * sizeof(*patches));
+	if (patches == NULL)
+		return -1;
+	uint32_t patch_count = 0;
+	uint32_t field_no = 0;
+	struct rope_iter it;
+	struct rope_node *node;
+	rope_iter_create(&it, update.rope);
+	for (node = rope_iter_start(&it); node; node = rope_iter_next(&it)) {
+		struct update_field *field = (struct update_field *)
+				rope_leaf_data(node);
+		op = field->op;
+		if (op != NULL) {
+			uint32_t size = field->tail - field->old;
+			if (op->new_field_len != size)
+				return 1;
+			/*
+			 * The column mask of the ops may be inexact,
+			 * check the actual field number.
+			 */
+			uint64_t field_mask = field_no < 64 ?
+				((uint64_t) 1) << (63 - field_no) :
+				UINT64_MAX;
+			if ((key_mask & field_mask) != 0)
+				return 1;
+			char *buf = (char *) update.alloc(update.alloc_ctx,
+							  size);
+			if (buf == NULL)
+				return -1;
+			op->meta->store(&op->arg, field->old, buf);
+			struct tuple_update_patch *patch =
+				&patches[patch_count++];
+			patch->offset = field->old - old_data;
+			patch->size = size;
+			patch->data = buf;
+		}
+		field_no += rope_leaf_size(node);
+	}
+	*p_patches = patches;
+	*p_patch_count = patch_count;
+	return 0;
+}
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr,const char *expr_end,
@@ -32,6 +32,7 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "trivia/util.h"
 
@@ -57,6 +58,39 @@ tuple_update_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     uint32_t *p_new_size, int index_base,
 		     uint64_t *column_mask);
 
+/** A change of a single field of a tuple updated in place. */
+struct tuple_update_patch {
+	/** Offset of the field in the tuple data. */
+	uint32_t offset;
+	/** Size of the field, the same before and after the update. */
+	uint32_t size;
+	/** New field data. */
+	const char *data;
+};
+
+/**
+ * Check if an update can be applied to a tuple in place and
+ * encode the changed fields if so. An update can be applied in
+ * place if it neither inserts nor deletes fields, doesn't splice
+ * strings, doesn't change the MsgPack size of any field and
+ * doesn't touch any column in @a key_mask (@sa column_mask of
+ * tuple_update_execute()).
+ *
+ * @retval  0 success, *p_patches is set to an array of
+ *            *p_patch_count changed fields, which can be
+ *            written over the old data.
+ * @retval  1 the update can't be applied in place, use
+ *            tuple_update_execute().
+ * @retval -1 the update is invalid, check diag.
+ */
+int
+tuple_update_execute_patch(tuple_update_alloc_func alloc, void *alloc_ctx,
+			   const char *expr, const char *expr_end,
+			   const char *old_data, const char *old_data_end,
+			   int index_base, uint64_t key_mask,
+			   struct tuple_update_patch **p_patches,
+			   uint32_t *p_patch_count);
+
 const char *
 tuple_upsert_execute(tuple_update_alloc_func alloc, void *alloc_ctx,
 		     const char *expr, const char *expr_end,
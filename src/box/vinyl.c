@@ -35,8 +35,10 @@
 #include "vy_stmt_iterator.h"
 #include "vy_mem.h"
 #include "vy_cache.h"
+#include "vy_io_limit.h"
 
 #include <dirent.h>
+#include <fcntl.h>
 
 #include <bit/bit.h>
 #include <small/rlist.h>
@@ -66,6 +68,7 @@
 #include "errcode.h"
 #include "key_def.h"
 #include "tuple.h"
+#include "tuple_hash.h"
 #include "tuple_update.h"
 #include "txn.h" /* box_txn_alloc() */
 #include "iproto_constants.h"
@@ -115,6 +118,25 @@ struct vy_conf {
 	uint64_t cache;
 	/* bloom filter false positive rate */
 	double bloom_fpr;
+	/* drop page cache used by dumps and compaction */
+	bool io_free_cache;
+	/* number of threads loading run indexes at startup */
+	int load_threads;
+	/* check checksums of all run pages at startup */
+	bool verify_runs;
+};
+
+/** Statistics of loading runs at startup. */
+struct vy_load_stat {
+	/** Number of indexes which had runs to load. */
+	uint32_t index_count;
+	/** Number of loaded runs and their pages. */
+	uint32_t run_count;
+	uint64_t page_count;
+	/** Time spent loading runs, wall clock. */
+	double load_time;
+	/** Time spent verifying page checksums, sum over threads. */
+	double verify_time;
 };
 
 struct vy_env {
@@ -146,8 +168,12 @@ struct vy_env {
 	struct vy_quota     quota;
 	/** Timer for updating quota watermark. */
 	ev_timer            quota_timer;
+	/** Bandwidth limit and stats of dump and compaction I/O. */
+	struct vy_io_limit  io_limit;
 	/** Enviroment for cache subsystem */
 	struct vy_cache_env cache_env;
+	/** Run loading statistics, reported at the end of recovery. */
+	struct vy_load_stat load_stat;
 };
 
 #define vy_crcs(p, size, crc) \
@@ -178,6 +204,8 @@ path_exists(const char *path)
 
 enum vy_stat_name {
 	VY_STAT_GET,
+	/* How many gets took the point lookup path */
+	VY_STAT_LOOKUP,
 	VY_STAT_TX,
 	VY_STAT_TX_OPS,
 	VY_STAT_TX_WRITE,
@@ -192,6 +220,7 @@ enum vy_stat_name {
 
 static const char *vy_stat_strings[] = {
 	"get",
+	"lookup",
 	"tx",
 	"tx_ops",
 	"tx_write",
@@ -215,6 +244,8 @@ struct vy_stat {
 	uint64_t tx_rlb;
 	uint64_t tx_conflict;
 	struct vy_latency get_latency;
+	/** Latency of gets done by vy_point_lookup(). */
+	struct vy_latency lookup_latency;
 	struct vy_latency tx_latency;
 	struct vy_latency cursor_latency;
 	/**
@@ -297,6 +328,14 @@ vy_stat_get(struct vy_stat *s, ev_tstamp start)
 	vy_latency_update(&s->get_latency, diff);
 }
 
+static void
+vy_stat_lookup(struct vy_stat *s, ev_tstamp start)
+{
+	ev_tstamp diff = ev_now(loop()) - start;
+	rmean_collect(s->rmean, VY_STAT_LOOKUP, 1);
+	vy_latency_update(&s->lookup_latency, diff);
+}
+
 static void
 vy_stat_tx(struct vy_stat *s, ev_tstamp start,
 	   int ops, int write_count, size_t write_size)
@@ -385,10 +424,48 @@ struct vy_run_info {
 	/** Bloom filter of all tuples in run */
 	bool has_bloom;
 	struct bloom bloom;
+	/** Bloom filter format version, defines the hash function. */
+	uint32_t bloom_version;
 	/** Pages meta. */
 	struct vy_page_info *page_infos;
 };
 
+enum {
+	/** 32-bit MurmurHash3 of the key, tuple_hash(). */
+	VY_BLOOM_VERSION_MURMUR = 0,
+	/** 64-bit wyhash of the key folded in half, tuple_hash64(). */
+	VY_BLOOM_VERSION_WYHASH = 1,
+	/** The bloom filter version of new runs. */
+	VY_BLOOM_VERSION = VY_BLOOM_VERSION_WYHASH,
+};
+
+/**
+ * Hash a statement for a bloom filter of the given version.
+ */
+static inline bloom_hash_t
+vy_bloom_tuple_hash(uint32_t version, const struct tuple *stmt,
+		    const struct key_def *key_def)
+{
+	if (version == VY_BLOOM_VERSION_MURMUR)
+		return tuple_hash(stmt, key_def);
+	uint64_t hash = tuple_hash64(stmt, key_def);
+	return hash ^ (hash >> 32);
+}
+
+/**
+ * Hash a full key (msgpack fields w/o array marker) for a
+ * bloom filter of the given version.
+ */
+static inline bloom_hash_t
+vy_bloom_key_hash(uint32_t version, const char *key,
+		  const struct key_def *key_def)
+{
+	if (version == VY_BLOOM_VERSION_MURMUR)
+		return key_hash(key, key_def);
+	uint64_t hash = key_hash64(key, key_def);
+	return hash ^ (hash >> 32);
+}
+
 struct vy_page_info {
 	/* count of statements in the page */
 	uint32_t count;
@@ -610,6 +687,10 @@ struct vy_index {
 	uint64_t used;
 	/** Histogram of number of runs in range. */
 	struct histogram *run_hist;
+	/** Number of bytes written to disk by dumps. */
+	uint64_t dump_bytes;
+	/** Number of bytes written to disk by compaction and split. */
+	uint64_t compact_bytes;
 	/**
 	 * Reference counter. Used to postpone index drop
 	 * until all pending operations have completed.
@@ -675,7 +756,8 @@ struct vy_index {
 	 * column_mask is the bitmask in that bit 'n' is set if
 	 * user_key_def parts contains a part with fieldno equal
 	 * to 'n'. This mask is used for update optimization
-	 * (@sa vy_update).
+	 * (@sa vy_update). Fields included into a secondary
+	 * index are set in the mask as well.
 	 */
 	uint64_t column_mask;
 };
@@ -959,6 +1041,11 @@ vy_read_iterator_next(struct vy_read_iterator *itr, struct tuple **result);
 static void
 vy_read_iterator_close(struct vy_read_iterator *itr);
 
+static NODISCARD int
+vy_point_lookup(struct vy_index *index, struct vy_tx *tx,
+		const int64_t *vlsn, const struct tuple *key,
+		struct tuple **result);
+
 /** Cursor. */
 struct vy_cursor {
 	/**
@@ -2129,7 +2216,8 @@ vy_run_write_page(struct vy_run_info *run_info, struct xlog *data_xlog,
 		struct tuple *stmt = *curr_stmt;
 		if (vy_run_dump_stmt(stmt, data_xlog, page, key_def) != 0)
 			goto error_rollback;
-		bloom_spectrum_add(bs, tuple_hash(stmt, user_key_def));
+		bloom_spectrum_add(bs, vy_bloom_tuple_hash(VY_BLOOM_VERSION,
+							   stmt, user_key_def));
 
 		if (vy_write_iterator_next(wi, curr_stmt))
 			goto error_rollback;
@@ -2187,8 +2275,48 @@ error_row_index:
 	return -1;
 }
 
+/**
+ * Account @size bytes of disk I/O done by a dump or compaction
+ * task and put the calling worker to sleep if the background
+ * I/O bandwidth limit is exceeded, @sa vy_io_limit_consume().
+ */
+static void
+vy_io_limit_throttle(struct vy_io_limit *io_limit, size_t size,
+		     bool is_write)
+{
+	double delay = vy_io_limit_consume(io_limit, size, is_write,
+					   clock_monotonic());
+	if (delay > 0)
+		fiber_sleep(delay);
+}
+
+/**
+ * Advise the kernel to drop the page cache backing a region
+ * of a run file which a background task is done with, so that
+ * dumps and compaction don't evict the pages that foreground
+ * reads depend on. The start of the region is rounded down to
+ * a page boundary while the end is not rounded, because the
+ * last partial page is likely to be accessed next.
+ */
+static void
+vy_run_free_cache(int fd, off_t offset, off_t len)
+{
+#ifdef HAVE_POSIX_FADVISE
+	off_t start = offset & ~(off_t)(4096 - 1);
+	(void) posix_fadvise(fd, start, len + offset - start,
+			     POSIX_FADV_DONTNEED);
+#else
+	(void) fd;
+	(void) offset;
+	(void) len;
+#endif /* HAVE_POSIX_FADVISE */
+}
+
 /**
  * Write statements from the iterator to a new run file.
+ * The I/O is accounted and throttled by @io_limit. If
+ * @free_cache is set, the page cache of the new file is
+ * dropped as soon as it's written.
  *
  *  @retval 0, curr_stmt != NULL: all is ok, the iterator is not finished
  *  @retval 0, curr_stmt == NULL: all is ok, the iterator finished
@@ -2199,7 +2327,8 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 		  struct vy_write_iterator *wi, struct tuple **curr_stmt,
 		  const char *end_key, struct bloom_spectrum *bs,
 		  const struct key_def *key_def,
-		  const struct key_def *user_key_def)
+		  const struct key_def *user_key_def,
+		  struct vy_io_limit *io_limit, bool free_cache)
 {
 	assert(curr_stmt != NULL);
 	assert(*curr_stmt != NULL);
@@ -2216,6 +2345,7 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	};
 	if (xlog_create(&data_xlog, path, &meta) < 0)
 		return -1;
+	data_xlog.free_cache = free_cache;
 
 	/*
 	 * Read from the iterator until it's exhausted or
@@ -2226,11 +2356,14 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	uint32_t page_infos_capacity = 0;
 	int rc;
 	do {
+		off_t offset = data_xlog.offset;
 		rc = vy_run_write_page(run_info, &data_xlog, wi,
 				       end_key, &page_infos_capacity, bs,
 				       curr_stmt, key_def, user_key_def);
 		if (rc < 0)
 			goto err;
+		vy_io_limit_throttle(io_limit, data_xlog.offset - offset,
+				     true);
 		fiber_gc();
 	} while (rc == 0);
 
@@ -2238,6 +2371,12 @@ vy_run_write_data(struct vy_run *run, const char *dirpath,
 	if (xlog_sync(&data_xlog) < 0 ||
 	    xlog_rename(&data_xlog) < 0)
 		goto err;
+	/*
+	 * The xlog only drops the cache of what it syncs
+	 * in the middle of writing, take care of the tail.
+	 */
+	if (free_cache)
+		vy_run_free_cache(data_xlog.fd, 0, data_xlog.offset);
 
 	run->fd = data_xlog.fd;
 	xlog_close(&data_xlog, true);
@@ -2435,13 +2574,11 @@ const uint64_t vy_run_info_key_map = (1 << VY_RUN_MIN_LSN) |
 				     (1 << VY_RUN_MAX_LSN) |
 				     (1 << VY_RUN_PAGE_COUNT);
 
-enum { VY_BLOOM_VERSION = 0 };
-
 static size_t
-vy_run_bloom_encode_size(const struct bloom *bloom)
+vy_run_bloom_encode_size(const struct bloom *bloom, uint32_t version)
 {
 	size_t size = mp_sizeof_array(4);
-	size += mp_sizeof_uint(VY_BLOOM_VERSION); /* version */
+	size += mp_sizeof_uint(version);
 	size += mp_sizeof_uint(bloom->table_size);
 	size += mp_sizeof_uint(bloom->hash_count);
 	size += mp_sizeof_bin(bloom_store_size(bloom));
@@ -2449,11 +2586,12 @@ vy_run_bloom_encode_size(const struct bloom *bloom)
 }
 
 char *
-vy_run_bloom_encode(char *buffer, const struct bloom *bloom)
+vy_run_bloom_encode(char *buffer, const struct bloom *bloom,
+		    uint32_t version)
 {
 	char *pos = buffer;
 	pos = mp_encode_array(pos, 4);
-	pos = mp_encode_uint(pos, VY_BLOOM_VERSION);
+	pos = mp_encode_uint(pos, version);
 	pos = mp_encode_uint(pos, bloom->table_size);
 	pos = mp_encode_uint(pos, bloom->hash_count);
 	pos = mp_encode_binl(pos, bloom_store_size(bloom));
@@ -2462,7 +2600,8 @@ vy_run_bloom_encode(char *buffer, const struct bloom *bloom)
 }
 
 int
-vy_run_bloom_decode(const char **buffer, struct bloom *bloom)
+vy_run_bloom_decode(const char **buffer, struct bloom *bloom,
+		    uint32_t *version)
 {
 	const char **pos = buffer;
 	memset(bloom, 0, sizeof(*bloom));
@@ -2472,12 +2611,13 @@ vy_run_bloom_decode(const char **buffer, struct bloom *bloom)
 			"wrong size of an array");
 		return -1;
 	}
-	uint64_t version = mp_decode_uint(pos);
-	if (version != VY_BLOOM_VERSION) {
+	uint64_t bloom_version = mp_decode_uint(pos);
+	if (bloom_version > VY_BLOOM_VERSION) {
 		diag_set(ClientError, ER_VINYL, "Can't decode bloom meta: "
 			"wrong version");
 		return -1;
 	}
+	*version = bloom_version;
 	bloom->table_size = mp_decode_uint(pos);
 	bloom->hash_count = mp_decode_uint(pos);
 	size_t table_size = mp_decode_binl(pos);
@@ -2522,7 +2662,8 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	size += mp_sizeof_uint(VY_RUN_PAGE_COUNT) +
 		mp_sizeof_uint(run_info->count);
 	size += mp_sizeof_uint(VY_RUN_BLOOM) +
-		vy_run_bloom_encode_size(&run_info->bloom);
+		vy_run_bloom_encode_size(&run_info->bloom,
+					 run_info->bloom_version);
 
 	char *tuple = region_alloc(&fiber()->gc, size);
 	if (tuple == NULL) {
@@ -2540,7 +2681,8 @@ vy_run_info_encode(const struct vy_run_info *run_info,
 	pos = mp_encode_uint(pos, VY_RUN_PAGE_COUNT);
 	pos = mp_encode_uint(pos, run_info->count);
 	pos = mp_encode_uint(pos, VY_RUN_BLOOM);
-	pos = vy_run_bloom_encode(pos, &run_info->bloom);
+	pos = vy_run_bloom_encode(pos, &run_info->bloom,
+				  run_info->bloom_version);
 
 	/* put tuple in a replace request to run's space */
 	struct request request;
@@ -2602,7 +2744,8 @@ vy_run_info_decode(struct vy_run_info *run_info,
 			run_info->count = mp_decode_uint(&pos);
 			break;
 		case VY_RUN_BLOOM:
-			if (vy_run_bloom_decode(&pos, &run_info->bloom) == 0)
+			if (vy_run_bloom_decode(&pos, &run_info->bloom,
+						&run_info->bloom_version) == 0)
 				run_info->has_bloom = true;
 			else
 				return -1;
@@ -3016,12 +3159,15 @@ vy_range_write_run(struct vy_range *range, struct vy_write_iterator *wi,
 	struct bloom_spectrum bs;
 	bloom_spectrum_create(&bs, max_output_count, bloom_fpr, runtime.quota);
 
+	struct vy_env *env = index->env;
 	if (vy_run_write_data(run, index->path, wi, stmt, range->end, &bs,
-			      key_def, user_key_def) != 0)
+			      key_def, user_key_def, &env->io_limit,
+			      env->conf->io_free_cache) != 0)
 		return -1;
 
 	bloom_spectrum_choose(&bs, &run->info.bloom);
 	run->info.has_bloom = true;
+	run->info.bloom_version = VY_BLOOM_VERSION;
 	bloom_spectrum_destroy(&bs, runtime.quota);
 
 	if (vy_run_write_index(run, index->path) != 0)
@@ -3091,11 +3237,23 @@ vy_range_needs_split(struct vy_range *range, const char **p_split_key)
  * where L_N is the total number of runs, N is the total number of
  * levels, older runs have greater numbers. Runs at each subsequent
  * are run_size_ratio times larger than on the previous one. When
- * the number of runs at a level exceeds run_count_per_level, we
- * compact all its runs along with all runs from the upper levels
- * and in-memory indexes.  Including  previous levels into
- * compaction is relatively cheap, because of the level size
- * ratio.
+ * the number of runs at a level exceeds the limit set by the
+ * compaction policy, we compact all its runs along with all runs
+ * from the upper levels and in-memory indexes.  Including  previous
+ * levels into compaction is relatively cheap, because of the level
+ * size ratio.
+ *
+ * The level run limit depends on the index compaction policy:
+ *
+ * - tiered: run_count_per_level runs per level. Favors writes.
+ * - leveled: a single run per level, i.e. runs never overlap
+ *   within a level. Favors reads and space.
+ * - time_window: fresh dumps are merged tiered-style into a run
+ *   of the second level (a "window"), which is then sealed and
+ *   never rewritten. Suits append-mostly data that is deleted in
+ *   the same order it was inserted. To keep read amplification
+ *   bounded, the whole range is compacted once the number of
+ *   sealed windows exceeds run_count_per_level * run_size_ratio.
  *
  * Given a range, this function computes the maximal level that needs
  * to be compacted and sets @compact_priority to the number of runs in
@@ -3112,6 +3270,10 @@ vy_range_update_compact_priority(struct vy_range *range)
 
 	range->compact_priority = 0;
 
+	uint32_t max_level_run_count = opts->run_count_per_level;
+	if (opts->compaction_policy == VY_COMPACTION_POLICY_LEVELED)
+		max_level_run_count = 1;
+
 	/* Total number of checked runs. */
 	uint32_t total_run_count = 0;
 	/* The total size of runs checked so far. */
@@ -3120,6 +3282,8 @@ vy_range_update_compact_priority(struct vy_range *range)
 	uint64_t est_new_run_size = 0;
 	/* The number of runs at the current level. */
 	uint32_t level_run_count = 0;
+	/* The number of the current level, starting from 1. */
+	uint32_t level = 1;
 	/*
 	 * The target (perfect) size of a run at the current level.
 	 * For the first level, it's the maximal size of a dump.
@@ -3143,6 +3307,7 @@ vy_range_update_compact_priority(struct vy_range *range)
 			 * count.
 			 */
 			level_run_count = 1;
+			level++;
 			/*
 			 * If we have already scheduled
 			 * a compaction of an upper level, and
@@ -3163,7 +3328,15 @@ vy_range_update_compact_priority(struct vy_range *range)
 			 * we find an appropriate level for it.
 			 */
 		}
-		if (level_run_count > opts->run_count_per_level) {
+		if (opts->compaction_policy ==
+		    VY_COMPACTION_POLICY_TIME_WINDOW && level > 1) {
+			/*
+			 * Windows are sealed, all the remaining
+			 * runs are windows as well.
+			 */
+			break;
+		}
+		if (level_run_count > max_level_run_count) {
 			/*
 			 * The number of runs at the current level
 			 * exceeds the configured maximum. Arrange
@@ -3174,6 +3347,14 @@ vy_range_update_compact_priority(struct vy_range *range)
 			est_new_run_size = total_size;
 		}
 	}
+	if (opts->compaction_policy == VY_COMPACTION_POLICY_TIME_WINDOW) {
+		uint32_t window_count = range->run_count - total_run_count;
+		if (level > 1)
+			window_count++;
+		if (window_count > opts->run_count_per_level *
+				   opts->run_size_ratio)
+			range->compact_priority = range->run_count;
+	}
 }
 
 /**
@@ -3409,14 +3590,155 @@ vy_index_create(struct vy_index *index)
  * in vinyl.meta file.
  */
 
+/** A run waiting to be loaded, see vy_run_loader. */
+struct vy_run_load_entry {
+	struct vy_run *run;
+	/** Range to add the run to once it is loaded. */
+	struct vy_range *range;
+};
+
 /** vy_index_recovery_cb() argument. */
 struct vy_index_recovery_cb_arg {
 	/** Index being recovered. */
 	struct vy_index *index;
 	/** Last recovered range. */
 	struct vy_range *range;
+	/** Runs of the index, in the order of the log. */
+	struct vy_run_load_entry *runs;
+	uint32_t run_count;
+	uint32_t run_capacity;
+};
+
+static int
+vy_run_verify(struct vy_run *run, struct vy_env *env);
+
+/**
+ * Loading run index files takes most of vinyl startup when
+ * there are many runs: every file has to be read and its page
+ * index and bloom filter decoded. The runs of an index are
+ * loaded by a few threads, each taking the next run from a
+ * shared array until all runs are loaded or one of them fails.
+ * The tx thread waits for them, it has nothing else to do
+ * during recovery.
+ */
+struct vy_run_loader {
+	struct vy_env *env;
+	/** Index directory. */
+	const char *dir;
+	struct vy_run_load_entry *runs;
+	uint32_t run_count;
+	/** Protects the members below. */
+	pthread_mutex_t mutex;
+	/** The next run to load. */
+	uint32_t next;
+	/** Set if any run failed to load. */
+	bool is_failed;
+	/** The error of the run which failed first. */
+	struct diag diag;
+	/** See vy_load_stat. */
+	double verify_time;
 };
 
+/** Thread function of vy_run_loader. */
+static void *
+vy_run_loader_f(void *arg)
+{
+	struct vy_run_loader *loader = arg;
+	double verify_time = 0;
+	while (true) {
+		tt_pthread_mutex_lock(&loader->mutex);
+		uint32_t i = loader->next++;
+		bool is_done = loader->is_failed || i >= loader->run_count;
+		tt_pthread_mutex_unlock(&loader->mutex);
+		if (is_done)
+			break;
+		struct vy_run *run = loader->runs[i].run;
+		int rc = vy_run_recover(run, loader->dir);
+		if (rc == 0 && loader->env->conf->verify_runs) {
+			double start = clock_monotonic();
+			rc = vy_run_verify(run, loader->env);
+			verify_time += clock_monotonic() - start;
+		}
+		if (rc != 0) {
+			tt_pthread_mutex_lock(&loader->mutex);
+			if (!loader->is_failed) {
+				loader->is_failed = true;
+				diag_move(diag_get(), &loader->diag);
+			}
+			tt_pthread_mutex_unlock(&loader->mutex);
+			break;
+		}
+	}
+	tt_pthread_mutex_lock(&loader->mutex);
+	loader->verify_time += verify_time;
+	tt_pthread_mutex_unlock(&loader->mutex);
+	return NULL;
+}
+
+/**
+ * Load the runs of an index found in the metadata log. Use
+ * a pool of threads if there are enough runs to make it pay.
+ */
+static int
+vy_index_load_runs(struct vy_index *index, struct vy_run_load_entry *runs,
+		   uint32_t run_count)
+{
+	struct vy_env *env = index->env;
+	struct vy_load_stat *stat = &env->load_stat;
+	double start = clock_monotonic();
+	struct vy_run_loader loader = {
+		.env = env,
+		.dir = index->path,
+		.runs = runs,
+		.run_count = run_count,
+	};
+	tt_pthread_mutex_init(&loader.mutex, NULL);
+	diag_create(&loader.diag);
+
+	enum { RUNS_PER_THREAD_MIN = 4 };
+	int thread_count = MIN(env->conf->load_threads,
+			       (int)(run_count / RUNS_PER_THREAD_MIN));
+	struct cord *threads = NULL;
+	if (thread_count > 1) {
+		threads = calloc(thread_count, sizeof(*threads));
+		if (threads == NULL)
+			thread_count = 0;
+	} else {
+		thread_count = 0;
+	}
+	int started = 0;
+	for (; started < thread_count; started++) {
+		char name[FIBER_NAME_MAX];
+		snprintf(name, sizeof(name), "vinyl.load.%d", started);
+		if (cord_start(&threads[started], name, vy_run_loader_f,
+			       &loader) != 0)
+			break;
+	}
+	if (started == 0) {
+		/* Too few runs or no threads, load them in place. */
+		vy_run_loader_f(&loader);
+	}
+	for (int i = 0; i < started; i++)
+		cord_join(&threads[i]);
+	free(threads);
+
+	int rc = 0;
+	if (loader.is_failed) {
+		diag_move(&loader.diag, diag_get());
+		rc = -1;
+	} else {
+		stat->index_count++;
+		stat->run_count += run_count;
+		for (uint32_t i = 0; i < run_count; i++)
+			stat->page_count += runs[i].run->info.count;
+	}
+	stat->verify_time += loader.verify_time;
+	stat->load_time += clock_monotonic() - start;
+	diag_destroy(&loader.diag);
+	tt_pthread_mutex_destroy(&loader.mutex);
+	return rc;
+}
+
 /** Index recovery callback, passed to xctl_recover_index(). */
 static int
 vy_index_recovery_cb(const struct xctl_record *record, void *cb_arg)
@@ -3451,14 +3773,25 @@ vy_index_recovery_cb(const struct xctl_record *record, void *cb_arg)
 	case XCTL_INSERT_VY_RUN:
 		assert(range != NULL);
 		assert(range->id == record->vy_range_id);
+		if (arg->run_count == arg->run_capacity) {
+			uint32_t capacity = MAX(arg->run_capacity * 2, 16);
+			struct vy_run_load_entry *runs =
+				realloc(arg->runs, capacity * sizeof(*runs));
+			if (runs == NULL) {
+				diag_set(OutOfMemory, capacity * sizeof(*runs),
+					 "realloc", "struct vy_run_load_entry");
+				return -1;
+			}
+			arg->runs = runs;
+			arg->run_capacity = capacity;
+		}
 		run = vy_run_new(record->vy_run_id);
 		if (run == NULL)
 			return -1;
-		if (vy_run_recover(run, index->path) != 0) {
-			vy_run_delete(run);
-			return -1;
-		}
-		vy_range_add_run(range, run);
+		/* The run is loaded by vy_index_load_runs(). */
+		arg->runs[arg->run_count].run = run;
+		arg->runs[arg->run_count].range = range;
+		arg->run_count++;
 		break;
 	default:
 		unreachable();
@@ -3472,8 +3805,18 @@ vy_index_open_ex(struct vy_index *index)
 	struct vy_env *env = index->env;
 
 	struct vy_index_recovery_cb_arg arg = { .index = index };
-	if (xctl_recover_vy_index(index->key_def->opts.lsn,
-				  vy_index_recovery_cb, &arg) != 0)
+	int rc = xctl_recover_vy_index(index->key_def->opts.lsn,
+				       vy_index_recovery_cb, &arg);
+	if (rc == 0 && arg.run_count > 0)
+		rc = vy_index_load_runs(index, arg.runs, arg.run_count);
+	for (uint32_t i = 0; i < arg.run_count; i++) {
+		if (rc == 0)
+			vy_range_add_run(arg.runs[i].range, arg.runs[i].run);
+		else
+			vy_run_delete(arg.runs[i].run);
+	}
+	free(arg.runs);
+	if (rc != 0)
 		return -1;
 
 	/*
@@ -3900,6 +4243,7 @@ vy_task_dump_complete(struct vy_task *task)
 
 	vy_index_unacct_range(index, range);
 	vy_range_dump_mems(range, scheduler, task->dump_lsn);
+	index->dump_bytes += task->dump_size;
 	if (range->new_run != NULL) {
 		range->max_dump_size = MAX(range->max_dump_size,
 					   vy_run_size(range->new_run));
@@ -4079,6 +4423,7 @@ vy_task_split_complete(struct vy_task *task)
 	 * the latter.
 	 */
 	vy_index_unacct_range(index, range);
+	index->compact_bytes += task->dump_size;
 	rlist_foreach_entry_safe(r, &range->split_list, split_list, tmp) {
 		/*
 		 * Add the new run created by split to the list
@@ -4317,6 +4662,7 @@ vy_task_compact_complete(struct vy_task *task)
 	 */
 	vy_index_unacct_range(index, range);
 	vy_range_dump_mems(range, scheduler, task->dump_lsn);
+	index->compact_bytes += task->dump_size;
 	n = range->compact_priority;
 	rlist_foreach_entry_safe(run, &range->runs, in_range, tmp) {
 		vy_range_remove_run(range, run);
@@ -5190,6 +5536,9 @@ vy_conf_new()
 	conf->memory_limit = cfg_getd("vinyl_memory");
 	conf->cache = cfg_getd("vinyl_cache");
 	conf->bloom_fpr = cfg_getd("vinyl_bloom_fpr");
+	conf->io_free_cache = cfg_geti("vinyl_io_free_cache") != 0;
+	conf->load_threads = cfg_geti("vinyl_threads");
+	conf->verify_runs = cfg_geti("vinyl_verify_runs") != 0;
 
 	conf->path = strdup(cfg_gets("vinyl_dir"));
 	if (conf->path == NULL) {
@@ -5293,6 +5642,8 @@ vy_info_append_memory(struct vy_env *env, struct vy_info_handler *h)
 	snprintf(buf, sizeof(buf), "%d%%", (int)(100 * q->used / q->limit));
 	vy_info_append_str(h, "ratio", buf);
 	vy_info_append_u64(h, "min_lsn", env->scheduler->mem_min_lsn);
+	vy_info_append_u64(h, "throttle_rate", q->throttle_rate);
+	vy_info_append_u64(h, "throttle_delay", q->throttle_delay * 1000000000);
 	vy_info_table_end(h);
 }
 
@@ -5342,6 +5693,8 @@ vy_info_append_performance(struct vy_env *env, struct vy_info_handler *h)
 
 	vy_info_append_stat_latency(h, "tx_latency", &stat->tx_latency);
 	vy_info_append_stat_latency(h, "get_latency", &stat->get_latency);
+	vy_info_append_stat_latency(h, "lookup_latency",
+				    &stat->lookup_latency);
 	vy_info_append_stat_latency(h, "cursor_latency", &stat->cursor_latency);
 
 	vy_info_append_u64(h, "tx_rollback", stat->tx_rlb);
@@ -5368,6 +5721,27 @@ vy_info_append_performance(struct vy_env *env, struct vy_info_handler *h)
 	vy_info_table_end(h);
 }
 
+static void
+vy_info_append_scheduler(struct vy_env *env, struct vy_info_handler *h)
+{
+	struct vy_io_limit *l = &env->io_limit;
+	tt_pthread_mutex_lock(&l->mutex);
+	uint64_t rate = l->rate;
+	uint64_t read_bytes = l->read_bytes;
+	uint64_t write_bytes = l->write_bytes;
+	uint64_t throttle_count = l->throttle_count;
+	double throttle_time = l->throttle_time;
+	tt_pthread_mutex_unlock(&l->mutex);
+
+	vy_info_table_begin(h, "scheduler");
+	vy_info_append_u64(h, "io_rate_limit", rate);
+	vy_info_append_u64(h, "read_bytes", read_bytes);
+	vy_info_append_u64(h, "write_bytes", write_bytes);
+	vy_info_append_u64(h, "throttle_count", throttle_count);
+	vy_info_append_u64(h, "throttle_time", throttle_time * 1000000000);
+	vy_info_table_end(h);
+}
+
 static void
 vy_info_append_metric(struct vy_env *env, struct vy_info_handler *h)
 {
@@ -5376,6 +5750,65 @@ vy_info_append_metric(struct vy_env *env, struct vy_info_handler *h)
 	vy_info_table_end(h);
 }
 
+/**
+ * Estimate write, read and space amplification of an index
+ * and append them to the index info.
+ *
+ * - write amplification is the ratio of the total number of
+ *   bytes written by dumps and compaction to the number of
+ *   bytes written by dumps;
+ * - read amplification is the average number of runs a point
+ *   lookup has to check in a range;
+ * - space amplification is the ratio of the index size to the
+ *   size of the oldest (last level) runs, which approximates
+ *   the size of live data.
+ */
+static void
+vy_info_append_amplification(struct vy_index *index,
+			     struct vy_info_handler *h)
+{
+	char buf[32];
+	uint64_t last_level_size = 0;
+	struct vy_range *range;
+	for (range = vy_range_tree_first(&index->tree); range != NULL;
+	     range = vy_range_tree_next(&index->tree, range)) {
+		if (range->run_count == 0)
+			continue;
+		struct vy_run *run = rlist_last_entry(&range->runs,
+						      struct vy_run, in_range);
+		last_level_size += vy_run_size(run);
+	}
+	double write_amp = index->dump_bytes == 0 ? 1 :
+		(double)(index->dump_bytes + index->compact_bytes) /
+		index->dump_bytes;
+	double read_amp = index->range_count == 0 ? 0 :
+		(double)index->run_count / index->range_count;
+	double space_amp = last_level_size == 0 ? 1 :
+		(double)index->size / last_level_size;
+
+	vy_info_table_begin(h, "amplification");
+	snprintf(buf, sizeof(buf), "%.2f", write_amp);
+	vy_info_append_str(h, "write", buf);
+	snprintf(buf, sizeof(buf), "%.2f", read_amp);
+	vy_info_append_str(h, "read", buf);
+	snprintf(buf, sizeof(buf), "%.2f", space_amp);
+	vy_info_append_str(h, "space", buf);
+	vy_info_table_end(h);
+}
+
+static void
+vy_info_append_cache(struct vy_cache *cache, struct vy_info_handler *h)
+{
+	vy_info_table_begin(h, "cache");
+	vy_info_append_u64(h, "count", cache->cached_count);
+	vy_info_append_u64(h, "used", cache->used);
+	vy_info_append_u64(h, "budget", cache->budget);
+	vy_info_append_u64(h, "hit", cache->stat.hit);
+	vy_info_append_u64(h, "miss", cache->stat.miss);
+	vy_info_append_u64(h, "evict", cache->stat.evict);
+	vy_info_table_end(h);
+}
+
 static void
 vy_info_append_indices(struct vy_env *env, struct vy_info_handler *h)
 {
@@ -5396,6 +5829,12 @@ vy_info_append_indices(struct vy_env *env, struct vy_info_handler *h)
 		vy_info_append_u32(h, "run_avg", i->run_count / i->range_count);
 		histogram_snprint(buf, sizeof(buf), i->run_hist);
 		vy_info_append_str(h, "run_histogram", buf);
+		vy_info_append_str(h, "compaction_policy",
+			vy_compaction_policy_strs[i->key_def->opts.compaction_policy]);
+		vy_info_append_u64(h, "dump_bytes", i->dump_bytes);
+		vy_info_append_u64(h, "compact_bytes", i->compact_bytes);
+		vy_info_append_amplification(i, h);
+		vy_info_append_cache(i->cache, h);
 		vy_info_table_end(h);
 	}
 	vy_info_table_end(h);
@@ -5409,6 +5848,7 @@ vy_info_gather(struct vy_env *env, struct vy_info_handler *h)
 	vy_info_append_memory(env, h);
 	vy_info_append_metric(env, h);
 	vy_info_append_performance(env, h);
+	vy_info_append_scheduler(env, h);
 }
 
 /** }}} Introspection */
@@ -5670,17 +6110,16 @@ vy_index_new(struct vy_env *e, struct key_def *user_key_def,
 		 * Calculate the bitmask of columns used in this
 		 * index.
 		 */
-		for (uint32_t i = 0; i < user_key_def->part_count; ++i) {
-			uint32_t fieldno = user_key_def->parts[i].fieldno;
-			if (fieldno >= 64) {
-				index->column_mask = UINT64_MAX;
-				break;
-			}
-			index->column_mask |= ((uint64_t)1) << (63 - fieldno);
-		}
+		index->column_mask = key_def_column_mask(user_key_def);
+		/*
+		 * Included fields are stored in the index too,
+		 * so updates of them must not be skipped.
+		 */
+		index->column_mask |= user_key_def->opts.include_mask;
 	}
 
-	index->cache = vy_cache_new(&e->cache_env, index->key_def);
+	index->cache = vy_cache_new(&e->cache_env, index->key_def,
+				    index->key_def->opts.cache_size);
 	if (index->cache == NULL)
 		goto fail_cache_init;
 
@@ -6121,6 +6560,21 @@ vy_index_get(struct vy_tx *tx, struct vy_index *index, const char *key,
 	if (tx != NULL)
 		vlsn_ptr = &tx->vlsn;
 
+	if (part_count == index->key_def->part_count) {
+		/* A full key matches at most one statement. */
+		if (vy_point_lookup(index, tx, vlsn_ptr, vykey, result) != 0)
+			goto error;
+		if (tx != NULL &&
+		    vy_tx_track(tx, index, vykey, *result == NULL) != 0) {
+			if (*result != NULL)
+				tuple_unref(*result);
+			goto error;
+		}
+		tuple_unref(vykey);
+		vy_stat_lookup(e->stat, start);
+		return 0;
+	}
+
 	struct vy_read_iterator itr;
 	vy_read_iterator_open(&itr, index, tx, ITER_EQ, vykey, vlsn_ptr, false);
 	if (vy_read_iterator_next(&itr, result) != 0)
@@ -6420,6 +6874,25 @@ vy_unique_key_validate(struct vy_index *index, const char *key,
 	return key_validate_parts(def, key, part_count);
 }
 
+/**
+ * Check if a secondary index stores every field of the tuples,
+ * i.e. the space has a fixed field count and all its fields are
+ * either key parts or included into the index. Such an index
+ * can answer selects without looking up the primary index.
+ */
+static inline bool
+vy_index_is_covering(struct vy_index *index)
+{
+	uint32_t field_count = index->space->format->exact_field_count;
+	if (field_count == 0 || field_count >= 64 ||
+	    index->key_def->opts.include_mask == 0)
+		return false;
+	uint64_t mask = key_def_column_mask(index->key_def) |
+			index->key_def->opts.include_mask;
+	uint64_t all = ~(UINT64_MAX >> field_count);
+	return (mask & all) == all;
+}
+
 /**
  * Get a tuple from the primary index by the partial tuple from
  * the secondary index.
@@ -6437,6 +6910,17 @@ vy_index_full_by_stmt(struct vy_tx *tx, struct vy_index *index,
 		      const struct tuple *partial, struct tuple **full)
 {
 	assert(index->key_def->iid > 0);
+	if (vy_index_is_covering(index)) {
+		/*
+		 * All fields are stored in the secondary index,
+		 * no need to look up the primary one.
+		 */
+		uint32_t size;
+		const char *data = tuple_data_range(partial, &size);
+		*full = vy_stmt_new_replace(index->space->format, data,
+					    data + size);
+		return *full != NULL ? 0 : -1;
+	}
 	/*
 	 * Fetch the primary key from the secondary index tuple.
 	 */
@@ -7107,6 +7591,13 @@ vy_commit(struct vy_env *e, struct vy_tx *tx, int64_t lsn)
 	free(tx);
 
 	vy_quota_use(quota, write_size);
+	/*
+	 * Slow down the writer if memory is consumed faster
+	 * than it is dumped, see vy_quota_throttle().
+	 */
+	double delay = vy_quota_throttle(quota, write_size, ev_now(loop()));
+	if (delay > 0 && status == VINYL_ONLINE)
+		fiber_sleep(delay);
 	return 0;
 }
 
@@ -7260,6 +7751,7 @@ vy_env_new(void)
 	ev_timer_init(&e->quota_timer, vy_env_quota_timer_cb, 0, 1.);
 	e->quota_timer.data = e;
 	ev_timer_start(loop(), &e->quota_timer);
+	vy_io_limit_create(&e->io_limit);
 	vy_cache_env_create(&e->cache_env, slab_cache,
 			    e->conf->cache);
 	return e;
@@ -7296,10 +7788,17 @@ vy_env_delete(struct vy_env *e)
 	lsregion_destroy(&e->allocator);
 	tt_pthread_key_delete(e->zdctx_key);
 	vy_cache_env_destroy(&e->cache_env);
+	vy_io_limit_destroy(&e->io_limit);
 	TRASH(e);
 	free(e);
 }
 
+void
+vy_set_io_rate_limit(struct vy_env *env, double limit)
+{
+	vy_io_limit_set_rate(&env->io_limit, limit * 1024 * 1024);
+}
+
 /** }}} Environment */
 
 /** {{{ Recovery */
@@ -7347,6 +7846,15 @@ vy_begin_final_recovery(struct vy_env *e)
 int
 vy_end_recovery(struct vy_env *e)
 {
+	struct vy_load_stat *stat = &e->load_stat;
+	if (stat->run_count > 0) {
+		say_info("vinyl: loaded %u runs, %llu pages of %u indexes "
+			 "in %.3f sec, verified checksums in %.3f sec",
+			 (unsigned)stat->run_count,
+			 (unsigned long long)stat->page_count,
+			 (unsigned)stat->index_count,
+			 stat->load_time, stat->verify_time);
+	}
 	switch (e->status) {
 	case VINYL_FINAL_RECOVERY_LOCAL:
 		vy_quota_set_limit(&e->quota, e->conf->memory_limit);
@@ -7696,6 +8204,32 @@ error:
 	return -1;
 }
 
+static ZSTD_DStream *
+vy_env_get_zdctx(struct vy_env *env);
+
+/**
+ * Read all pages of a run to check their checksums.
+ * Used at startup if vinyl_verify_runs is set.
+ */
+static int
+vy_run_verify(struct vy_run *run, struct vy_env *env)
+{
+	ZSTD_DStream *zdctx = vy_env_get_zdctx(env);
+	if (zdctx == NULL)
+		return -1;
+	for (uint32_t page_no = 0; page_no < run->info.count; page_no++) {
+		struct vy_page_info *page_info = vy_run_page_info(run, page_no);
+		struct vy_page *page = vy_page_new(page_info);
+		if (page == NULL)
+			return -1;
+		int rc = vy_page_read(page, page_info, run->fd, zdctx);
+		vy_page_delete(page);
+		if (rc != 0)
+			return -1;
+	}
+	return 0;
+}
+
 /**
  * Get thread local zstd decompression context
  */
@@ -7846,6 +8380,15 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 			vy_page_delete(page);
 			return -1;
 		}
+		if (!cord_is_main()) {
+			/* Dump or compaction task in a worker thread. */
+			if (env->conf->io_free_cache)
+				vy_run_free_cache(itr->run->fd,
+						  page_info->offset,
+						  page_info->size);
+			vy_io_limit_throttle(&index->env->io_limit,
+					     page_info->size, false);
+		}
 	}
 
 	/* Iterator is never used from multiple fibers */
@@ -8152,13 +8695,15 @@ vy_run_iterator_start(struct vy_run_iterator *itr, struct tuple **ret)
 	struct key_def *user_key_def = itr->index->user_key_def;
 	if (itr->run->info.has_bloom && itr->iterator_type == ITER_EQ &&
 	    tuple_field_count(itr->key) >= user_key_def->part_count) {
-		uint32_t hash;
+		uint32_t version = itr->run->info.bloom_version;
+		bloom_hash_t hash;
 		if (vy_stmt_type(itr->key) == IPROTO_SELECT) {
 			const char *data = tuple_data(itr->key);
 			mp_decode_array(&data);
-			hash = key_hash(data, user_key_def);
+			hash = vy_bloom_key_hash(version, data, user_key_def);
 		} else {
-			hash = tuple_hash(itr->key, user_key_def);
+			hash = vy_bloom_tuple_hash(version, itr->key,
+						   user_key_def);
 		}
 		if (!bloom_possible_has(&itr->run->info.bloom, hash)) {
 			itr->search_ended = true;
@@ -10040,6 +10585,303 @@ vy_read_iterator_close(struct vy_read_iterator *itr)
 
 /* }}} Iterator over index */
 
+/** {{{ Point lookup */
+
+/**
+ * Fold the next older statement of the looked up key into the
+ * result accumulated so far. Newer UPSERTs are applied on top
+ * of older statements the same way the merge iterator squashes
+ * them, see vy_merge_iterator_squash_upsert().
+ *
+ * @retval  0 Success.
+ * @retval -1 Memory error.
+ */
+static NODISCARD int
+vy_point_lookup_fold(struct vy_index *index, struct tuple **result,
+		     struct tuple *stmt)
+{
+	if (*result == NULL) {
+		tuple_ref(stmt);
+		*result = stmt;
+		return 0;
+	}
+	assert(vy_stmt_type(*result) == IPROTO_UPSERT);
+	struct tuple *applied;
+	applied = vy_apply_upsert(*result, stmt, index->key_def,
+				  index->space_format, index->upsert_format,
+				  true, index->env->stat);
+	tuple_unref(*result);
+	*result = applied;
+	return applied == NULL ? -1 : 0;
+}
+
+/**
+ * True if the accumulated result does not depend on older
+ * statements: it is either a REPLACE or a DELETE.
+ */
+static inline bool
+vy_point_lookup_is_done(struct tuple *result)
+{
+	return result != NULL && vy_stmt_type(result) != IPROTO_UPSERT;
+}
+
+/**
+ * Fold all statements of the key visible in a single source,
+ * from newer to older ones, until a terminal statement is met.
+ * The source is closed on return.
+ *
+ * @retval  0 Success.
+ * @retval -1 Read or memory error.
+ * @retval -2 The source was invalidated while reading from disk.
+ */
+static NODISCARD int
+vy_point_lookup_scan(struct vy_index *index, struct vy_stmt_iterator *src,
+		     const struct tuple *key, struct tuple **result)
+{
+	struct tuple *stmt;
+	bool stop;
+	int rc = src->iface->next_key(src, &stmt, &stop);
+	while (rc == 0 && stmt != NULL) {
+		/*
+		 * The cache iterator may step past the key if
+		 * the cached statement is not visible.
+		 */
+		if (vy_stmt_compare(stmt, key, index->key_def) != 0)
+			break;
+		if (vy_point_lookup_fold(index, result, stmt) != 0) {
+			rc = -1;
+			break;
+		}
+		if (vy_point_lookup_is_done(*result))
+			break;
+		rc = src->iface->next_lsn(src, &stmt);
+	}
+	src->iface->cleanup(src);
+	src->iface->close(src);
+	return rc;
+}
+
+/**
+ * Look up the key in in-memory indexes of a range.
+ */
+static NODISCARD int
+vy_point_lookup_scan_mems(struct vy_index *index, struct vy_range *range,
+			  const struct tuple *key, const int64_t *vlsn,
+			  struct tuple **result)
+{
+	struct vy_iterator_stat *stat = &index->env->stat->mem_stat;
+	struct vy_mem_iterator mem_itr;
+	if (range->mem != NULL) {
+		vy_mem_iterator_open(&mem_itr, stat, range->mem, ITER_EQ,
+				     key, vlsn);
+		if (vy_point_lookup_scan(index, &mem_itr.base, key,
+					 result) != 0)
+			return -1;
+		if (vy_point_lookup_is_done(*result))
+			return 0;
+	}
+	struct vy_mem *mem;
+	rlist_foreach_entry(mem, &range->frozen, in_frozen) {
+		vy_mem_iterator_open(&mem_itr, stat, mem, ITER_EQ, key, vlsn);
+		if (vy_point_lookup_scan(index, &mem_itr.base, key,
+					 result) != 0)
+			return -1;
+		if (vy_point_lookup_is_done(*result))
+			return 0;
+	}
+	return 0;
+}
+
+/**
+ * Return the LSN of the newest statement of the key visible at
+ * @a vlsn in an in-memory index, or -1 if there is none. The
+ * lookup is not accounted in the in-memory index statistics.
+ */
+static int64_t
+vy_point_lookup_mem_lsn(struct vy_index *index, struct vy_mem *mem,
+			const struct tuple *key, const int64_t *vlsn)
+{
+	if (mem == NULL)
+		return -1;
+	struct vy_iterator_stat stat;
+	memset(&stat, 0, sizeof(stat));
+	struct vy_mem_iterator mem_itr;
+	vy_mem_iterator_open(&mem_itr, &stat, mem, ITER_EQ, key, vlsn);
+	struct tuple *stmt;
+	bool stop;
+	int64_t lsn = -1;
+	if (mem_itr.base.iface->next_key(&mem_itr.base, &stmt, &stop) == 0 &&
+	    stmt != NULL && vy_stmt_compare(stmt, key, index->key_def) == 0)
+		lsn = vy_stmt_lsn(stmt);
+	mem_itr.base.iface->cleanup(&mem_itr.base);
+	mem_itr.base.iface->close(&mem_itr.base);
+	return lsn;
+}
+
+/**
+ * Return the LSN of the newest statement of the key visible at
+ * @a vlsn in the active in-memory indexes of a range and of the
+ * ranges it is being split into. Only active in-memory indexes
+ * accept new statements, so if the value changes while a run
+ * page is read from disk, the key has been written meanwhile.
+ */
+static int64_t
+vy_point_lookup_range_lsn(struct vy_index *index, struct vy_range *range,
+			  const struct tuple *key, const int64_t *vlsn)
+{
+	int64_t lsn = vy_point_lookup_mem_lsn(index, range->mem, key, vlsn);
+	struct vy_range *r;
+	rlist_foreach_entry(r, &range->split_list, split_list) {
+		lsn = MAX(lsn, vy_point_lookup_mem_lsn(index, r->mem,
+						       key, vlsn));
+	}
+	return lsn;
+}
+
+/**
+ * Look up a full key in a vinyl index.
+ *
+ * Unlike the read iterator, which merges all sources of a range,
+ * check the transaction write set, the cache, in-memory indexes
+ * and runs one by one, from the newest to the oldest, and stop
+ * at the first REPLACE or DELETE visible at @a vlsn, applying
+ * UPSERTs met along the way. Runs are skipped when their bloom
+ * filter tells that the key is absent. If the range is changed
+ * by a dump or compaction, or the key is written while a run is
+ * read from disk, the lookup starts over.
+ *
+ * @param index       Index to look up in.
+ * @param tx          Current transaction, if exists.
+ * @param vlsn        Maximal visible LSN.
+ * @param key         Full key of the index.
+ * @param[out] result Found tuple or NULL. The caller must
+ *                    unreference it.
+ *
+ * @retval  0 Success.
+ * @retval -1 Read or memory error.
+ */
+static NODISCARD int
+vy_point_lookup(struct vy_index *index, struct vy_tx *tx,
+		const int64_t *vlsn, const struct tuple *key,
+		struct tuple **result)
+{
+	assert(tuple_field_count(key) == index->key_def->part_count);
+	struct vy_stat *stat = index->env->stat;
+	struct tuple *found = NULL;
+	*result = NULL;
+restart:
+	if (found != NULL)
+		tuple_unref(found);
+	found = NULL;
+
+	if (tx != NULL) {
+		struct vy_txw_iterator txw_itr;
+		vy_txw_iterator_open(&txw_itr, &stat->txw_stat, index, tx,
+				     ITER_EQ, key);
+		if (vy_point_lookup_scan(index, &txw_itr.base, key,
+					 &found) != 0)
+			goto error;
+		if (vy_point_lookup_is_done(found))
+			goto done;
+	}
+
+	struct vy_cache_iterator cache_itr;
+	vy_cache_iterator_open(&cache_itr, &stat->cache_stat, index->cache,
+			       ITER_EQ, key, vlsn);
+	if (vy_point_lookup_scan(index, &cache_itr.base, key, &found) != 0)
+		goto error;
+	if (vy_point_lookup_is_done(found))
+		goto done;
+
+	struct vy_range_iterator range_itr;
+	struct vy_range *range;
+	vy_range_iterator_open(&range_itr, index, ITER_EQ, key);
+	vy_range_iterator_next(&range_itr, &range);
+	if (range == NULL)
+		goto done;
+
+	/*
+	 * The range may be in the middle of split, in which case
+	 * in-memory indexes of new ranges hold newer data.
+	 */
+	struct vy_range *r;
+	rlist_foreach_entry(r, &range->split_list, split_list) {
+		if (vy_point_lookup_scan_mems(index, r, key, vlsn,
+					      &found) != 0)
+			goto error;
+		if (vy_point_lookup_is_done(found))
+			goto done;
+	}
+	if (vy_point_lookup_scan_mems(index, range, key, vlsn, &found) != 0)
+		goto error;
+	if (vy_point_lookup_is_done(found))
+		goto done;
+
+	struct tuple_format *format = index->surrogate_format;
+	/* @sa vy_read_iterator_add_disk(). */
+	if (index->space_index_count == 1)
+		format = index->space_format;
+	/*
+	 * Reading a run page yields, and other fibers may commit
+	 * a statement of the key meanwhile. The statement goes to
+	 * an active in-memory index and invalidates the cache, so
+	 * the result folded so far must neither be returned nor
+	 * stored in the cache. Statements added to the cache by
+	 * other readers don't make the result stale, so the cache
+	 * version isn't checked: it would only cause restarts.
+	 */
+	uint32_t index_version = index->version;
+	uint32_t range_version = range->version;
+	uint32_t txw_version = tx != NULL ? tx->write_set_version : 0;
+	int64_t mem_lsn = vy_point_lookup_range_lsn(index, range, key, vlsn);
+	struct vy_run *run;
+	rlist_foreach_entry(run, &range->runs, in_range) {
+		struct vy_run_iterator run_itr;
+		vy_run_iterator_open(&run_itr, &stat->run_stat, range, run,
+				     ITER_EQ, key, vlsn, format,
+				     index->upsert_format);
+		int rc = vy_point_lookup_scan(index, &run_itr.base, key,
+					      &found);
+		if (rc == -1)
+			goto error;
+		if (rc == -2 || index_version != index->version ||
+		    range_version != range->version)
+			goto restart;
+		if ((tx != NULL && txw_version != tx->write_set_version) ||
+		    mem_lsn != vy_point_lookup_range_lsn(index, range,
+							 key, vlsn))
+			goto restart;
+		if (vy_point_lookup_is_done(found))
+			goto done;
+	}
+done:
+	if (found != NULL && vy_stmt_type(found) == IPROTO_UPSERT) {
+		struct tuple *applied;
+		applied = vy_apply_upsert(found, NULL, index->key_def,
+					  index->space_format,
+					  index->upsert_format, true, stat);
+		tuple_unref(found);
+		found = applied;
+		if (found == NULL)
+			return -1;
+	}
+	if (found != NULL && vy_stmt_type(found) == IPROTO_DELETE) {
+		tuple_unref(found);
+		found = NULL;
+	}
+	/* Do not store non-latest data, @sa vy_read_iterator_next(). */
+	if (*vlsn == INT64_MAX)
+		vy_cache_add(index->cache, found, NULL, key, ITER_EQ);
+	*result = found;
+	return 0;
+error:
+	if (found != NULL)
+		tuple_unref(found);
+	return -1;
+}
+
+/* }}} Point lookup */
+
 /** {{{ Replication */
 
 /** Argument passed to vy_join_cb(). */
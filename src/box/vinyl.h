@@ -89,6 +89,17 @@ vy_wait_checkpoint(struct vy_env *env);
 void
 vy_end_checkpoint(struct vy_env *env);
 
+/*
+ * Configuration
+ */
+
+/**
+ * Set the disk bandwidth limit for dumps and compaction,
+ * in megabytes per second, 0 means unlimited.
+ */
+void
+vy_set_io_rate_limit(struct vy_env *env, double limit);
+
 /*
  * Introspection
  */
@@ -171,6 +171,12 @@ VinylEngine::keydefCheck(struct space *space, struct key_def *key_def)
 		          key_def->name,
 		          space_name(space));
 	}
+	if (key_def->iid == 0 && key_def->opts.include_mask != 0) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name,
+			  space_name(space),
+			  "primary key can not include fields");
+	}
 }
 
 void
@@ -278,3 +284,9 @@ VinylEngine::abortCheckpoint()
 {
 	vy_end_checkpoint(env);
 }
+
+void
+VinylEngine::setIoRateLimit(double new_limit)
+{
+	vy_set_io_rate_limit(env, new_limit);
+}
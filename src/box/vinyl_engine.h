@@ -60,6 +60,11 @@ struct VinylEngine: public Engine {
 	virtual int waitCheckpoint(struct vclock *vclock) override;
 	virtual void commitCheckpoint(struct vclock *vclock) override;
 	virtual void abortCheckpoint() override;
+	/**
+	 * Limit the disk bandwidth used by dumps and
+	 * compaction, in megabytes per second.
+	 */
+	void setIoRateLimit(double new_limit);
 public:
 	struct vy_env *env;
 };
@@ -47,6 +47,9 @@ enum {
 	/* Max number of deletes that are made by cleanup action per one
 	 * cache operation */
 	VY_CACHE_CLEANUP_MAX_STEPS = 10,
+	/* Max share of the quota taken by the protected LRU segment,
+	 * in percent */
+	VY_CACHE_PROTECTED_PERCENT = 80,
 };
 
 void
@@ -54,6 +57,8 @@ vy_cache_env_create(struct vy_cache_env *e, struct slab_cache *slab_cache,
 		    uint64_t mem_quota)
 {
 	rlist_create(&e->cache_lru);
+	rlist_create(&e->probation_lru);
+	e->protected_used = 0;
 	vy_quota_init(&e->quota, NULL, NULL);
 	vy_quota_set_limit(&e->quota, mem_quota);
 	mempool_create(&e->cache_entry_mempool, slab_cache,
@@ -81,26 +86,65 @@ vy_cache_entry_new(struct vy_cache_env *env, struct vy_cache *cache,
 	entry->flags = 0;
 	entry->left_boundary_level = cache->key_def->part_count;
 	entry->right_boundary_level = cache->key_def->part_count;
-	rlist_add(&env->cache_lru, &entry->in_lru);
+	entry->is_protected = false;
+	rlist_add(&env->probation_lru, &entry->in_lru);
+	rlist_add(&cache->cache_lru, &entry->in_cache_lru);
 	size_t use = sizeof(struct vy_cache_entry) + tuple_size(stmt);
 	vy_quota_force_use(&env->quota, use);
 	env->cached_count++;
+	cache->used += use;
+	cache->cached_count++;
 	return entry;
 }
 
 static void
 vy_cache_entry_delete(struct vy_cache_env *env, struct vy_cache_entry *entry)
 {
+	struct vy_cache *cache = entry->cache;
 	struct tuple *stmt = entry->stmt;
 	size_t put = sizeof(struct vy_cache_entry) + tuple_size(stmt);
 	env->cached_count--;
 	vy_quota_release(&env->quota, put);
+	if (entry->is_protected)
+		env->protected_used -= put;
+	cache->used -= put;
+	cache->cached_count--;
 	tuple_unref(stmt);
 	rlist_del(&entry->in_lru);
+	rlist_del(&entry->in_cache_lru);
 	TRASH(entry);
 	mempool_free(&env->cache_entry_mempool, entry);
 }
 
+/**
+ * Move an entry to the head of the protected LRU segment. If the
+ * segment grows too big, demote its oldest entries to the
+ * probation segment.
+ */
+static void
+vy_cache_entry_promote(struct vy_cache_env *env, struct vy_cache_entry *entry)
+{
+	rlist_move_entry(&entry->cache->cache_lru, entry, in_cache_lru);
+	rlist_move_entry(&env->cache_lru, entry, in_lru);
+	if (entry->is_protected)
+		return;
+	entry->is_protected = true;
+	env->protected_used += sizeof(struct vy_cache_entry) +
+			       tuple_size(entry->stmt);
+	size_t limit = env->quota.limit / 100 * VY_CACHE_PROTECTED_PERCENT;
+	while (env->protected_used > limit) {
+		struct vy_cache_entry *last =
+			rlist_last_entry(&env->cache_lru,
+					 struct vy_cache_entry, in_lru);
+		if (last == entry)
+			break;
+		last->is_protected = false;
+		env->protected_used -= sizeof(struct vy_cache_entry) +
+				       tuple_size(last->stmt);
+		rlist_move_entry(&env->probation_lru, last, in_lru);
+	}
+}
+
 static void *
 vy_cache_tree_page_alloc(void *ctx)
 {
@@ -118,7 +162,8 @@ vy_cache_tree_page_free(void *ctx, void *p)
 }
 
 struct vy_cache *
-vy_cache_new(struct vy_cache_env *env, struct key_def *key_def)
+vy_cache_new(struct vy_cache_env *env, struct key_def *key_def,
+	     size_t budget)
 {
 	struct vy_cache *cache = (struct vy_cache *)
 		malloc(sizeof(struct vy_cache));
@@ -131,6 +176,11 @@ vy_cache_new(struct vy_cache_env *env, struct key_def *key_def)
 	cache->env = env;
 	cache->key_def = key_def;
 	cache->version = 1;
+	rlist_create(&cache->cache_lru);
+	cache->cached_count = 0;
+	cache->used = 0;
+	cache->budget = budget;
+	memset(&cache->stat, 0, sizeof(cache->stat));
 	vy_cache_tree_create(&cache->cache_tree, key_def,
 			     vy_cache_tree_page_alloc,
 			     vy_cache_tree_page_free, env);
@@ -155,11 +205,8 @@ vy_cache_delete(struct vy_cache *cache)
 }
 
 static void
-vy_cache_gc_step(struct vy_cache_env *env)
+vy_cache_evict(struct vy_cache_entry *entry)
 {
-	struct rlist *lru = &env->cache_lru;
-	struct vy_cache_entry *entry =
-	rlist_last_entry(lru, struct vy_cache_entry, in_lru);
 	struct vy_cache *cache = entry->cache;
 	struct vy_cache_tree *tree = &cache->cache_tree;
 	if (entry->flags & (VY_CACHE_LEFT_LINKED |
@@ -188,10 +235,20 @@ vy_cache_gc_step(struct vy_cache_env *env)
 		}
 	}
 	cache->version++;
+	cache->stat.evict++;
 	vy_cache_tree_delete(&cache->cache_tree, entry);
 	vy_cache_entry_delete(cache->env, entry);
 }
 
+static void
+vy_cache_gc_step(struct vy_cache_env *env)
+{
+	/* Evict entries that have never been read from cache first */
+	struct rlist *lru = !rlist_empty(&env->probation_lru) ?
+			    &env->probation_lru : &env->cache_lru;
+	vy_cache_evict(rlist_last_entry(lru, struct vy_cache_entry, in_lru));
+}
+
 static void
 vy_cache_gc(struct vy_cache_env *env)
 {
@@ -203,6 +260,23 @@ vy_cache_gc(struct vy_cache_env *env)
 	}
 }
 
+/**
+ * Evict the oldest entries of the cache if it exceeds its budget.
+ */
+static void
+vy_cache_gc_budget(struct vy_cache *cache)
+{
+	if (cache->budget == 0)
+		return;
+	for (uint32_t i = 0;
+	     cache->used > cache->budget && i < VY_CACHE_CLEANUP_MAX_STEPS;
+	     i++) {
+		vy_cache_evict(rlist_last_entry(&cache->cache_lru,
+						struct vy_cache_entry,
+						in_cache_lru));
+	}
+}
+
 void
 vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 	     struct tuple *prev_stmt, const struct tuple *key,
@@ -210,6 +284,7 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 {
 	/* Delete some entries if quota overused */
 	vy_cache_gc(cache->env);
+	vy_cache_gc_budget(cache);
 
 	if (stmt != NULL && vy_stmt_lsn(stmt) == INT64_MAX) {
 		/* Do not store a statement from write set of a tx */
@@ -286,7 +361,12 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		entry->flags = replaced->flags;
 		entry->left_boundary_level = replaced->left_boundary_level;
 		entry->right_boundary_level = replaced->right_boundary_level;
+		bool is_protected = replaced->is_protected;
 		vy_cache_entry_delete(cache->env, replaced);
+		if (is_protected)
+			vy_cache_entry_promote(cache->env, entry);
+	} else {
+		cache->stat.miss++;
 	}
 	if (direction > 0 && boundary_level < entry->left_boundary_level)
 		entry->left_boundary_level = boundary_level;
@@ -320,7 +400,10 @@ vy_cache_add(struct vy_cache *cache, struct tuple *stmt,
 		prev_entry->flags = replaced->flags;
 		prev_entry->left_boundary_level = replaced->left_boundary_level;
 		prev_entry->right_boundary_level = replaced->right_boundary_level;
+		bool is_protected = replaced->is_protected;
 		vy_cache_entry_delete(cache->env, replaced);
+		if (is_protected)
+			vy_cache_entry_promote(cache->env, prev_entry);
 	}
 
 	/* Set proper flags */
@@ -396,6 +479,17 @@ vy_cache_on_write(struct vy_cache *cache, struct tuple *stmt)
 	}
 }
 
+/**
+ * Account a statement read from the cache and promote its entry.
+ */
+static void
+vy_cache_iterator_hit(struct vy_cache_iterator *itr,
+		      struct vy_cache_entry *entry)
+{
+	itr->cache->stat.hit++;
+	vy_cache_entry_promote(itr->cache->env, entry);
+}
+
 /**
  * Get a stmt by current position
  */
@@ -531,6 +625,7 @@ vy_cache_iterator_start(struct vy_cache_iterator *itr, struct tuple **ret,
 	itr->curr_stmt = candidate;
 	tuple_ref(itr->curr_stmt);
 	*ret = itr->curr_stmt;
+	vy_cache_iterator_hit(itr, *entry);
 	return;
 }
 
@@ -650,6 +745,7 @@ vy_cache_iterator_next_key(struct vy_stmt_iterator *vitr,
 		tuple_ref(itr->curr_stmt);
 	}
 	*ret = itr->curr_stmt;
+	vy_cache_iterator_hit(itr, *entry);
 	return 0;
 }
 
@@ -56,6 +56,10 @@ struct vy_cache_entry {
 	struct tuple *stmt;
 	/* Link in LRU list */
 	struct rlist in_lru;
+	/* Link in LRU list of the cache */
+	struct rlist in_cache_lru;
+	/* True if the entry is in the protected LRU segment */
+	bool is_protected;
 	/* VY_CACHE_LEFT_LINKED and/or VY_CACHE_RIGHT_LINKED, see
 	 * description of them for more information */
 	uint32_t flags;
@@ -111,10 +115,28 @@ vy_cache_tree_key_cmp(struct vy_cache_entry *a,
 
 /**
  * Environment of the cache
+ *
+ * The cache uses segmented LRU to resist scans. A new entry is
+ * put to the probation segment and promoted to the protected
+ * segment only when it is read from the cache. Entries are
+ * evicted from the probation segment first, so a large one-time
+ * scan can't flush out the working set. The protected segment
+ * is limited to a fraction of the quota, the entries exceeding
+ * it are demoted back to the probation segment.
  */
 struct vy_cache_env {
-	/** Common LRU list of read cache. The first element is the newest */
+	/**
+	 * Common LRU list of the protected segment.
+	 * The first element is the newest.
+	 */
 	struct rlist cache_lru;
+	/**
+	 * Common LRU list of the probation segment.
+	 * The first element is the newest.
+	 */
+	struct rlist probation_lru;
+	/** Memory used by entries of the protected segment */
+	size_t protected_used;
 	/** Common quota for read cache */
 	struct vy_quota quota;
 	/** Common mempool for vy_cache_entry struct */
@@ -140,6 +162,18 @@ vy_cache_env_create(struct vy_cache_env *env, struct slab_cache *slab_cache,
 void
 vy_cache_env_destroy(struct vy_cache_env *e);
 
+/**
+ * Tuple cache statistics (of one particular index)
+ */
+struct vy_cache_stat {
+	/* Number of statements read from the cache */
+	size_t hit;
+	/* Number of statements added to the cache on read */
+	size_t miss;
+	/* Number of entries evicted from the cache */
+	size_t evict;
+};
+
 /**
  * Tuple cache (of one particular index)
  */
@@ -152,16 +186,29 @@ struct vy_cache {
 	uint32_t version;
 	/* Saved pointer to common cache environment */
 	struct vy_cache_env *env;
+	/* LRU list of entries of this cache. The first element is the newest */
+	struct rlist cache_lru;
+	/* Number of cached tuples */
+	size_t cached_count;
+	/* Memory used by the cache */
+	size_t used;
+	/* Memory limit of the cache, 0 if only the common quota applies */
+	size_t budget;
+	/* Usage statistics */
+	struct vy_cache_stat stat;
 };
 
 /**
  * Allocate and initialize tuple cache.
  * @param env - pointer to common cache environment.
  * @param key_def - key definition for tuple comparison.
+ * @param budget - memory limit of the cache, 0 for no limit
+ *  besides the common quota.
  * @retval - new tuple cache.
  */
 struct vy_cache *
-vy_cache_new(struct vy_cache_env *env, struct key_def *key_def);
+vy_cache_new(struct vy_cache_env *env, struct key_def *key_def,
+	     size_t budget);
 
 /**
  * Destroy and deallocate tuple cache.
@@ -0,0 +1,151 @@
+#ifndef INCLUDES_TARANTOOL_BOX_VY_IO_LIMIT_H
+#define INCLUDES_TARANTOOL_BOX_VY_IO_LIMIT_H
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY AUTHORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * AUTHORS OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "tt_pthread.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+/**
+ * Token bucket limiting the disk bandwidth consumed by
+ * background vinyl I/O, i.e. dumps and compaction.
+ * Shared by all worker threads, hence protected with a mutex.
+ *
+ * The bucket is refilled at @rate bytes per second and holds
+ * at most @burst seconds worth of tokens. A reader or writer
+ * takes as many tokens as the number of bytes it has just
+ * transferred. If the bucket runs dry, the balance goes
+ * negative and the caller is supposed to sleep until the debt
+ * is repaid, so the aggregate bandwidth of all workers never
+ * exceeds the limit for long.
+ */
+struct vy_io_limit {
+	pthread_mutex_t mutex;
+	/** Bandwidth limit, in bytes per second, 0 if unlimited. */
+	uint64_t rate;
+	/** Number of tokens in the bucket, negative if in debt. */
+	double tokens;
+	/** Time the bucket was last refilled at. */
+	double refill_time;
+	/** Number of bytes read by background tasks. */
+	uint64_t read_bytes;
+	/** Number of bytes written by background tasks. */
+	uint64_t write_bytes;
+	/** Number of times a task was throttled. */
+	uint64_t throttle_count;
+	/** Total time tasks were throttled for, in seconds. */
+	double throttle_time;
+};
+
+/**
+ * Max amount of tokens the bucket may accumulate while I/O
+ * is idle, in seconds.
+ */
+static const double vy_io_limit_burst = 0.1;
+
+static inline void
+vy_io_limit_create(struct vy_io_limit *l)
+{
+	tt_pthread_mutex_init(&l->mutex, NULL);
+	l->rate = 0;
+	l->tokens = 0;
+	l->refill_time = 0;
+	l->read_bytes = 0;
+	l->write_bytes = 0;
+	l->throttle_count = 0;
+	l->throttle_time = 0;
+}
+
+static inline void
+vy_io_limit_destroy(struct vy_io_limit *l)
+{
+	tt_pthread_mutex_destroy(&l->mutex);
+}
+
+/**
+ * Set the bandwidth limit, in bytes per second, 0 to disable.
+ */
+static inline void
+vy_io_limit_set_rate(struct vy_io_limit *l, uint64_t rate)
+{
+	tt_pthread_mutex_lock(&l->mutex);
+	l->rate = rate;
+	l->tokens = 0;
+	l->refill_time = 0;
+	tt_pthread_mutex_unlock(&l->mutex);
+}
+
+/**
+ * Account @size bytes read (@is_write is false) or written
+ * (@is_write is true) by a background task at time @now.
+ *
+ * Returns the time the caller should sleep for in order to
+ * stay within the limit, in seconds, 0 if it need not wait.
+ */
+static inline double
+vy_io_limit_consume(struct vy_io_limit *l, size_t size, bool is_write,
+		    double now)
+{
+	double delay = 0;
+	tt_pthread_mutex_lock(&l->mutex);
+	if (is_write)
+		l->write_bytes += size;
+	else
+		l->read_bytes += size;
+	if (l->rate > 0) {
+		if (now > l->refill_time) {
+			l->tokens += (now - l->refill_time) * l->rate;
+			if (l->tokens > vy_io_limit_burst * l->rate)
+				l->tokens = vy_io_limit_burst * l->rate;
+			l->refill_time = now;
+		}
+		l->tokens -= size;
+		if (l->tokens < 0) {
+			delay = -l->tokens / l->rate;
+			l->throttle_count++;
+			l->throttle_time += delay;
+		}
+	}
+	tt_pthread_mutex_unlock(&l->mutex);
+	return delay;
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* INCLUDES_TARANTOOL_BOX_VY_IO_LIMIT_H */
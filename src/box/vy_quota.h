@@ -67,6 +67,22 @@ struct vy_quota {
 	size_t watermark;
 	/** Current memory consumption. */
 	size_t used;
+	/**
+	 * Rate at which memory is released, in bytes per second,
+	 * i.e. the dump bandwidth. Used for computing the rate
+	 * at which writers are allowed to consume memory when
+	 * the watermark is exceeded. 0 if unknown.
+	 */
+	size_t release_rate;
+	/**
+	 * Theoretical arrival time of the next write when writers
+	 * are throttled, @sa vy_quota_throttle().
+	 */
+	double throttle_tat;
+	/** Write rate allowed by the throttler, 0 if not throttled. */
+	size_t throttle_rate;
+	/** The last delay imposed on a writer, in seconds. */
+	double throttle_delay;
 	/** Quota callback. */
 	vy_quota_cb cb;
 	/** Argument passed to cb. */
@@ -79,6 +95,10 @@ vy_quota_init(struct vy_quota *q, vy_quota_cb cb, void *cb_arg)
 	q->limit = SIZE_MAX;
 	q->watermark = SIZE_MAX;
 	q->used = 0;
+	q->release_rate = 0;
+	q->throttle_tat = 0;
+	q->throttle_rate = 0;
+	q->throttle_delay = 0;
 	q->cb = cb;
 	q->cb_arg = cb_arg;
 }
@@ -113,6 +133,7 @@ static inline void
 vy_quota_update_watermark(struct vy_quota *q, size_t chunk_size,
 			  size_t use_rate, size_t release_rate)
 {
+	q->release_rate = release_rate;
 	if (q->limit == SIZE_MAX)
 		return;
 	/*
@@ -128,6 +149,58 @@ vy_quota_update_watermark(struct vy_quota *q, size_t chunk_size,
 		q->watermark = 0;
 }
 
+/**
+ * Allowance for bursts of writes that are not delayed by
+ * the throttler even if they exceed the allowed rate, in
+ * seconds.
+ */
+static const double vy_quota_throttle_burst = 0.01;
+/** Maximal delay imposed on a writer by the throttler, in seconds. */
+static const double vy_quota_throttle_max_delay = 1.;
+
+/**
+ * Compute the delay a writer that has just consumed @size bytes
+ * of memory should be throttled for, given the current time @now.
+ *
+ * While memory usage is below the watermark, writers are not
+ * delayed. Above the watermark, the allowed write rate decreases
+ * linearly from the rate memory is released at (dump bandwidth)
+ * down to zero as memory usage approaches the limit, so writers
+ * slow down gradually instead of stopping dead when the limit is
+ * hit. The rate is enforced with the generic cell rate algorithm:
+ * each write shifts the theoretical arrival time of the next one
+ * by size / rate, and a writer that arrives earlier than that
+ * (minus the burst allowance) has to wait.
+ *
+ * Returns the delay in seconds, 0 if the writer need not wait.
+ */
+static inline double
+vy_quota_throttle(struct vy_quota *q, size_t size, double now)
+{
+	if (q->limit == SIZE_MAX || q->release_rate == 0 ||
+	    q->used <= q->watermark || q->watermark >= q->limit) {
+		q->throttle_rate = 0;
+		q->throttle_delay = 0;
+		q->throttle_tat = now;
+		return 0;
+	}
+	size_t left = q->used < q->limit ? q->limit - q->used : 0;
+	double rate = (double)q->release_rate * left /
+		      (q->limit - q->watermark);
+	q->throttle_rate = rate;
+	if (q->throttle_tat < now)
+		q->throttle_tat = now;
+	if (rate > 0)
+		q->throttle_tat += size / rate;
+	else
+		q->throttle_tat += vy_quota_throttle_max_delay;
+	if (q->throttle_tat > now + vy_quota_throttle_max_delay)
+		q->throttle_tat = now + vy_quota_throttle_max_delay;
+	double delay = q->throttle_tat - now - vy_quota_throttle_burst;
+	q->throttle_delay = delay > 0 ? delay : 0;
+	return q->throttle_delay;
+}
+
 /**
  * Consume @size bytes of memory. Throttle the caller if
  * the limit is exceeded.
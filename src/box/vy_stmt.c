@@ -322,10 +322,14 @@ vy_stmt_replace_from_upsert(struct tuple_format *replace_format,
 	return replace;
 }
 
-struct tuple *
-vy_stmt_new_surrogate_from_key(struct tuple_format *format,
-			       const char *key, const struct key_def *def,
-			       enum iproto_type type)
+/**
+ * Create a surrogate statement from key fields followed by the
+ * fields included into the index, @sa vy_stmt_encode().
+ */
+static struct tuple *
+vy_stmt_new_surrogate_from_fields(struct tuple_format *format,
+				  const char *key, const struct key_def *def,
+				  uint64_t include_mask, enum iproto_type type)
 {
 	/**
 	 * UPSERT can't be surrogate. Also any not UPSERT tuple
@@ -335,28 +339,41 @@ vy_stmt_new_surrogate_from_key(struct tuple_format *format,
 	struct region *region = &fiber()->gc;
 
 	uint32_t field_count = format->field_count;
+	uint32_t part_count = def->part_count;
+	include_mask &= ~key_def_column_mask(def);
+	if (include_mask != 0) {
+		/* The lowest bit is the last included field. */
+		uint32_t last = 63 - __builtin_ctzll(include_mask);
+		field_count = MAX(field_count, last + 1);
+		part_count += __builtin_popcountll(include_mask);
+	}
 	struct iovec *iov = region_alloc(region, sizeof(*iov) * field_count);
 	if (iov == NULL) {
 		diag_set(OutOfMemory, sizeof(*iov) * field_count,
 			 "region", "iov for surrogate key");
 		return NULL;
 	}
-#ifndef NDEBUG
-	memset(iov, '#', sizeof(*iov) * field_count);
-#endif
-	uint32_t part_count = mp_decode_array(&key);
-	assert(part_count == def->part_count);
+	memset(iov, 0, sizeof(*iov) * field_count);
+	uint32_t count = mp_decode_array(&key);
+	assert(count == part_count);
+	(void) count;
 	assert(part_count <= field_count);
-	uint32_t nulls_count = field_count - def->part_count;
+	uint32_t nulls_count = field_count - part_count;
 	uint32_t bsize = mp_sizeof_array(field_count) +
 		mp_sizeof_nil() * nulls_count;
 	for (uint32_t i = 0; i < part_count; ++i) {
-		const struct key_part *part = &def->parts[i];
-		assert(part->fieldno < field_count);
+		uint32_t fieldno;
+		if (i < def->part_count) {
+			fieldno = def->parts[i].fieldno;
+		} else {
+			fieldno = __builtin_clzll(include_mask);
+			include_mask &= ~(((uint64_t) 1) << (63 - fieldno));
+		}
+		assert(fieldno < field_count);
 		const char *svp = key;
-		iov[part->fieldno].iov_base = (char *) key;
+		iov[fieldno].iov_base = (char *) key;
 		mp_next(&key);
-		iov[part->fieldno].iov_len = key - svp;
+		iov[fieldno].iov_len = key - svp;
 		bsize += key - svp;
 	}
 
@@ -367,12 +384,12 @@ vy_stmt_new_surrogate_from_key(struct tuple_format *format,
 	char *raw = (char *) tuple_data(stmt);
 	char *wpos = mp_encode_array(raw, field_count);
 	for (uint32_t i = 0; i < field_count; ++i) {
-		struct tuple_field_format *field = &format->fields[i];
-		if (field->type == FIELD_TYPE_ANY) {
+		if (iov[i].iov_base == NULL) {
+			assert(i >= format->field_count ||
+			       format->fields[i].type == FIELD_TYPE_ANY);
 			wpos = mp_encode_nil(wpos);
 			continue;
 		}
-		assert(iov[i].iov_base != NULL);
 		memcpy(wpos, iov[i].iov_base, iov[i].iov_len);
 		wpos += iov[i].iov_len;
 	}
@@ -387,6 +404,14 @@ vy_stmt_new_surrogate_from_key(struct tuple_format *format,
 	return stmt;
 }
 
+struct tuple *
+vy_stmt_new_surrogate_from_key(struct tuple_format *format,
+			       const char *key, const struct key_def *def,
+			       enum iproto_type type)
+{
+	return vy_stmt_new_surrogate_from_fields(format, key, def, 0, type);
+}
+
 struct tuple *
 vy_stmt_new_surrogate_delete_from_key(struct tuple_format *format,
 				      const char *key,
@@ -444,6 +469,62 @@ vy_stmt_new_surrogate_delete(struct tuple_format *format,
 	return vy_stmt_new_surrogate(format, src, IPROTO_DELETE);
 }
 
+/**
+ * Append the fields of @a value included into a secondary index
+ * to the key extracted from it.
+ */
+static const char *
+vy_stmt_extract_key_with_include(const struct tuple *value,
+				 const struct key_def *key_def, uint32_t *size)
+{
+	const char *key = tuple_extract_key(value, key_def, size);
+	uint64_t include_mask = key_def->opts.include_mask &
+				~key_def_column_mask(key_def);
+	if (key == NULL || include_mask == 0)
+		return key;
+	const char *key_end = key + *size;
+	uint32_t part_count = mp_decode_array(&key);
+	uint32_t include_count = __builtin_popcountll(include_mask);
+	uint32_t bsize = mp_sizeof_array(part_count + include_count) +
+			 (key_end - key);
+	for (uint64_t mask = include_mask; mask != 0; ) {
+		uint32_t fieldno = __builtin_clzll(mask);
+		mask &= ~(((uint64_t) 1) << (63 - fieldno));
+		const char *field = tuple_field(value, fieldno);
+		if (field == NULL) {
+			bsize += mp_sizeof_nil();
+			continue;
+		}
+		const char *field_end = field;
+		mp_next(&field_end);
+		bsize += field_end - field;
+	}
+	char *data = region_alloc(&fiber()->gc, bsize);
+	if (data == NULL) {
+		diag_set(OutOfMemory, bsize, "region", "included fields");
+		return NULL;
+	}
+	char *pos = mp_encode_array(data, part_count + include_count);
+	memcpy(pos, key, key_end - key);
+	pos += key_end - key;
+	for (uint64_t mask = include_mask; mask != 0; ) {
+		uint32_t fieldno = __builtin_clzll(mask);
+		mask &= ~(((uint64_t) 1) << (63 - fieldno));
+		const char *field = tuple_field(value, fieldno);
+		if (field == NULL) {
+			pos = mp_encode_nil(pos);
+			continue;
+		}
+		const char *field_end = field;
+		mp_next(&field_end);
+		memcpy(pos, field, field_end - field);
+		pos += field_end - field;
+	}
+	assert(pos == data + bsize);
+	*size = bsize;
+	return data;
+}
+
 int
 vy_stmt_encode(const struct tuple *value, const struct key_def *key_def,
 	       struct xrow_header *xrow)
@@ -459,7 +540,12 @@ vy_stmt_encode(const struct tuple *value, const struct key_def *key_def,
 	request.index_id = key_def->iid;
 	uint32_t size;
 	const char *extracted = NULL;
-	if (key_def->iid != 0 || type == IPROTO_DELETE) {
+	if (key_def->iid != 0 && type == IPROTO_REPLACE) {
+		extracted = vy_stmt_extract_key_with_include(value, key_def,
+							     &size);
+		if (extracted == NULL)
+			return -1;
+	} else if (key_def->iid != 0 || type == IPROTO_DELETE) {
 		extracted = tuple_extract_key(value, key_def, &size);
 		if (extracted == NULL)
 			return -1;
@@ -524,10 +610,10 @@ vy_stmt_decode(struct xrow_header *xrow, struct tuple_format *format,
 			stmt = vy_stmt_new_replace(format, request.tuple,
 					    request.tuple_end);
 		} else {
-			stmt = vy_stmt_new_surrogate_from_key(format,
-					                      request.tuple,
-							      def,
-							      IPROTO_REPLACE);
+			uint64_t include_mask = def->opts.include_mask;
+			stmt = vy_stmt_new_surrogate_from_fields(format,
+					request.tuple, def, include_mask,
+					IPROTO_REPLACE);
 		}
 		break;
 	case IPROTO_UPSERT:
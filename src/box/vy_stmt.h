@@ -510,7 +510,10 @@ vy_key_from_msgpack(struct tuple_format *format, const char *key)
 }
 
 /**
- * Encode vy_stmt as xrow_header
+ * Encode vy_stmt as xrow_header.
+ * A REPLACE in a secondary index is stored as its key followed
+ * by the fields listed in key_def->opts.include_mask, in
+ * ascending order.
  *
  * @retval 0 if OK
  * @retval -1 if error
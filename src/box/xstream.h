@@ -42,20 +42,31 @@ struct xrow_header;
 struct xstream;
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
+typedef void (*xstream_flush_f)(struct xstream *);
 
 struct xstream {
 	xstream_write_f write;
+	/**
+	 * Optional callback invoked when the producer has no
+	 * more rows to write for the time being, so that a stream
+	 * that buffers rows can push them out.
+	 */
+	xstream_flush_f flush;
 };
 
 static inline void
 xstream_create(struct xstream *xstream, xstream_write_f write)
 {
 	xstream->write = write;
+	xstream->flush = NULL;
 }
 
 int
 xstream_write(struct xstream *stream, struct xrow_header *row);
 
+int
+xstream_flush(struct xstream *stream);
+
 #if defined(__cplusplus)
 } /* extern C */
 
@@ -66,6 +77,13 @@ xstream_write_xc(struct xstream *stream, struct xrow_header *row)
 		diag_raise();
 }
 
+static inline void
+xstream_flush_xc(struct xstream *stream)
+{
+	if (xstream_flush(stream) != 0)
+		diag_raise();
+}
+
 #endif /* defined(__cplusplus) */
 
 #endif /* TARANTOOL_XSTREAM_H_INCLUDED */
@@ -32,34 +32,114 @@
 
 #include "trivia/config.h"
 #include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <assert.h>
 #include <string.h>
 #include <sys/mman.h>
 #include "small/slab_cache.h"
 #include "third_party/valgrind/memcheck.h"
 #include "diag.h"
+#include "say.h"
 #if ENABLE_ASAN
 #include <sanitizer/asan_interface.h>
 #endif
 
+static inline void *
+page_align_down(void *ptr, size_t page)
+{
+	return (void *) ((uintptr_t) ptr & ~(page - 1));
+}
+
+static inline void *
+page_align_up(void *ptr, size_t page)
+{
+	return page_align_down((char *) ptr + page - 1, page);
+}
+
+/**
+ * Number of stacks with a guard page, in all threads.
+ *
+ * A guarded stack has its own mapping, which the guard page
+ * splits in two entries of the memory map of the process. The
+ * size of the map is limited (by vm.max_map_count on Linux,
+ * 65530 by default), and once it is reached, any mmap() fails.
+ * So only the first CORO_GUARD_MAX stacks get a guard page.
+ */
+static int coro_guard_count;
+
+/**
+ * Try to reserve a guard page in the CORO_GUARD_MAX budget.
+ */
+static bool
+coro_guard_reserve(void)
+{
+	static bool warned = false;
+	if (__atomic_add_fetch(&coro_guard_count, 1,
+			       __ATOMIC_RELAXED) <= CORO_GUARD_MAX)
+		return true;
+	__atomic_sub_fetch(&coro_guard_count, 1, __ATOMIC_RELAXED);
+	if (!warned) {
+		warned = true;
+		say_warn("%d fiber stacks have a guard page, "
+			 "new stacks are created without it",
+			 CORO_GUARD_MAX);
+	}
+	return false;
+}
+
 int
 tarantool_coro_create(struct tarantool_coro *coro,
-		      struct slab_cache *slabc,
-		      void (*f) (void *), void *data)
+		      struct slab_cache *slabc, size_t stack_size,
+		      bool use_guard, void (*f) (void *), void *data)
 {
-	const int page = sysconf(_SC_PAGESIZE);
+	const size_t page = sysconf(_SC_PAGESIZE);
 
 	memset(coro, 0, sizeof(*coro));
 
-	/* TODO: guard pages */
-	coro->stack_size = page * 16 - slab_sizeof();
-	coro->stack = (char *) slab_get(slabc, coro->stack_size)
-					+ slab_sizeof();
-
-	if (coro->stack == NULL) {
-		diag_set(OutOfMemory, coro->stack_size + slab_sizeof(),
-			 "runtime arena", "coro stack");
+	if (stack_size <= slab_sizeof()) {
+		errno = EINVAL;
+		diag_set(SystemError, "fiber stack size %zu is too small",
+			 stack_size);
 		return -1;
 	}
+	coro->size = stack_size;
+	/*
+	 * The stack grows down, so a protected page below it
+	 * catches an overflow instead of letting it silently
+	 * corrupt the neighbouring memory. A guarded stack is
+	 * mapped separately, with the guard page on top of the
+	 * requested size: a slab has a power of two size, so
+	 * an extra page would double it.
+	 */
+	if (use_guard && stack_size % page == 0 && coro_guard_reserve()) {
+		char *map = (char *) mmap(NULL, stack_size + page,
+					  PROT_READ | PROT_WRITE,
+					  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (map == MAP_FAILED) {
+			say_syserror("mmap");
+		} else if (mprotect(map, page, PROT_NONE) != 0) {
+			say_syserror("mprotect");
+			munmap(map, stack_size + page);
+		} else {
+			coro->guard = map;
+			coro->stack = map + page;
+			coro->stack_size = stack_size;
+		}
+		if (coro->guard == NULL)
+			__atomic_sub_fetch(&coro_guard_count, 1,
+					   __ATOMIC_RELAXED);
+	}
+	if (coro->guard == NULL) {
+		coro->slab = slab_get(slabc, stack_size - slab_sizeof());
+		if (coro->slab == NULL) {
+			diag_set(OutOfMemory, stack_size,
+				 "runtime arena", "coro stack");
+			return -1;
+		}
+		coro->stack = (char *) coro->slab + slab_sizeof();
+		coro->stack_size = stack_size - slab_sizeof();
+	}
 
 	coro->stack_id = VALGRIND_STACK_REGISTER(coro->stack,
 						 (char *) coro->stack +
@@ -69,6 +149,28 @@ tarantool_coro_create(struct tarantool_coro *coro,
 	return 0;
 }
 
+int
+tarantool_coro_guard_count(void)
+{
+	return __atomic_load_n(&coro_guard_count, __ATOMIC_RELAXED);
+}
+
+size_t
+tarantool_coro_reclaim(struct tarantool_coro *coro, void *top)
+{
+	const size_t page = sysconf(_SC_PAGESIZE);
+	char *begin = (char *) page_align_up(coro->stack, page);
+	char *end = (char *) page_align_down(top, page);
+	if (end <= begin)
+		return 0;
+#if ENABLE_ASAN
+	ASAN_UNPOISON_MEMORY_REGION(begin, end - begin);
+#endif
+	if (madvise(begin, end - begin, MADV_DONTNEED) != 0)
+		return 0;
+	return end - begin;
+}
+
 void
 tarantool_coro_destroy(struct tarantool_coro *coro, struct slab_cache *slabc)
 {
@@ -77,7 +179,13 @@ tarantool_coro_destroy(struct tarantool_coro *coro, struct slab_cache *slabc)
 #if ENABLE_ASAN
 		ASAN_UNPOISON_MEMORY_REGION(coro->stack, coro->stack_size);
 #endif
-		slab_put(slabc, (struct slab *)
-			 ((char *) coro->stack - slab_sizeof()));
+		if (coro->guard != NULL) {
+			const size_t page = sysconf(_SC_PAGESIZE);
+			munmap(coro->guard, coro->stack_size + page);
+			__atomic_sub_fetch(&coro_guard_count, 1,
+					   __ATOMIC_RELAXED);
+		} else {
+			slab_put(slabc, coro->slab);
+		}
 	}
 }
@@ -31,6 +31,7 @@
  * SUCH DAMAGE.
  */
 #include <stddef.h> /* size_t */
+#include <stdbool.h>
 
 #include <third_party/coro/coro.h>
 
@@ -40,18 +41,57 @@ extern "C" {
 
 struct tarantool_coro {
 	coro_context ctx;
+	/** The slab of an unguarded stack, NULL otherwise. */
+	struct slab *slab;
+	/**
+	 * Protected page below the stack, NULL if there is none.
+	 * It starts the mapping of a guarded stack.
+	 */
+	void *guard;
+	/** The stack size requested at creation. */
+	size_t size;
 	void *stack;
 	size_t stack_size;
 	/** Valgrind stack id. */
 	unsigned int stack_id;
 };
 
+struct slab;
 struct slab_cache;
 
+enum {
+	/**
+	 * Max number of stacks with a guard page in the process,
+	 * @sa tarantool_coro_create().
+	 */
+	CORO_GUARD_MAX = 16384,
+};
+
+/**
+ * Allocate a stack of @a stack_size bytes and create a
+ * coroutine on it. An unguarded stack is a slab, including
+ * its header. If @a use_guard is set, @a stack_size is a
+ * multiple of the page size and fewer than CORO_GUARD_MAX
+ * stacks are guarded already, the stack is mapped separately
+ * with a guard page below it, in addition to @a stack_size.
+ */
 int
 tarantool_coro_create(struct tarantool_coro *ctx,
-		      struct slab_cache *cache,
-		      void (*f) (void *), void *data);
+		      struct slab_cache *cache, size_t stack_size,
+		      bool use_guard, void (*f) (void *), void *data);
+
+/** Number of stacks with a guard page in the process. */
+int
+tarantool_coro_guard_count(void);
+
+/**
+ * Return the pages of the stack below @a top to the OS.
+ * The memory stays mapped and is zero-filled on the next
+ * touch. Returns the number of bytes released.
+ */
+size_t
+tarantool_coro_reclaim(struct tarantool_coro *ctx, void *top);
+
 void
 tarantool_coro_destroy(struct tarantool_coro *ctx,
 		       struct slab_cache *cache);
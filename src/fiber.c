@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <pmatomic.h>
 
 #include "assoc.h"
@@ -92,6 +93,9 @@ update_last_stack_frame(struct fiber *fiber)
 static void
 fiber_recycle(struct fiber *fiber);
 
+void
+fiber_destroy(struct cord *cord, struct fiber *f);
+
 /**
  * Transfer control to callee fiber.
  */
@@ -153,6 +157,46 @@ fiber_checkstack()
 	return false;
 }
 
+/** Stack size of new fibers, shared by all cords. */
+static size_t stack_size_default = FIBER_STACK_SIZE_DEFAULT;
+
+size_t
+fiber_stack_size(void)
+{
+	return stack_size_default;
+}
+
+void
+fiber_set_stack_size(size_t size)
+{
+	const size_t page = sysconf(_SC_PAGESIZE);
+	if (size < FIBER_STACK_SIZE_MIN)
+		size = FIBER_STACK_SIZE_MIN;
+	stack_size_default = (size + page - 1) & ~(page - 1);
+}
+
+/** Whether new fiber stacks get a guard page. */
+static bool stack_guard_enabled = true;
+
+bool
+fiber_stack_guard(void)
+{
+	return stack_guard_enabled;
+}
+
+void
+fiber_set_stack_guard(bool enable)
+{
+	stack_guard_enabled = enable;
+}
+
+/** The stack size the fiber was created with. */
+static inline size_t
+fiber_stack_size_of(struct fiber *fiber)
+{
+	return fiber->coro.size;
+}
+
 /**
  * Interrupt a synchronous wait of a fiber inside the event loop.
  * We do so by keeping an "async" event in every fiber, solely
@@ -543,7 +587,31 @@ fiber_recycle(struct fiber *fiber)
 	unregister_fid(fiber);
 	fiber->fid = 0;
 	region_free(&fiber->gc);
-	rlist_move_entry(&cord()->dead, fiber, link);
+	struct cord *cord = cord();
+	if (++cord->dead_count <= FIBER_DEAD_WATERMARK) {
+		rlist_move_entry(&cord->dead, fiber, link);
+		return;
+	}
+	/*
+	 * Too many idle fibers: keep this one at the cold end
+	 * of the cache and give its stack back to the OS. A
+	 * fiber recycling itself still runs on the top of its
+	 * stack, so only the part below the current frame is
+	 * released.
+	 */
+	rlist_move_tail_entry(&cord->dead, fiber, link);
+	void *top;
+	if (fiber == fiber()) {
+		top = (char *) __builtin_frame_address(0) -
+		      sysconf(_SC_PAGESIZE);
+	} else {
+		top = (char *) fiber->coro.stack + fiber->coro.stack_size;
+	}
+	size_t reclaimed = tarantool_coro_reclaim(&fiber->coro, top);
+	if (reclaimed > 0) {
+		cord->stack_reclaim_count++;
+		cord->stack_reclaimed += reclaimed;
+	}
 }
 
 static void
@@ -637,8 +705,18 @@ fiber_new(const char *name, fiber_func f)
 	if (! rlist_empty(&cord->dead)) {
 		fiber = rlist_first_entry(&cord->dead,
 					  struct fiber, link);
-		rlist_move_entry(&cord->alive, fiber, link);
-	} else {
+		cord->dead_count--;
+		if (fiber_stack_size_of(fiber) == stack_size_default) {
+			rlist_move_entry(&cord->alive, fiber, link);
+		} else {
+			/* The stack size has been changed. */
+			rlist_del_entry(fiber, link);
+			fiber_destroy(cord, fiber);
+			mempool_free(&cord->fiber_mempool, fiber);
+			fiber = NULL;
+		}
+	}
+	if (fiber == NULL) {
 		fiber = (struct fiber *)
 			mempool_alloc(&cord->fiber_mempool);
 		if (fiber == NULL) {
@@ -649,6 +727,8 @@ fiber_new(const char *name, fiber_func f)
 		memset(fiber, 0, sizeof(struct fiber));
 
 		if (tarantool_coro_create(&fiber->coro, &cord->slabc,
+					  stack_size_default,
+					  stack_guard_enabled,
 					  fiber_loop, NULL)) {
 			mempool_free(&cord->fiber_mempool, fiber);
 			return NULL;
@@ -723,6 +803,9 @@ cord_create(struct cord *cord, const char *name)
 	rlist_create(&cord->alive);
 	rlist_create(&cord->ready);
 	rlist_create(&cord->dead);
+	cord->dead_count = 0;
+	cord->stack_reclaim_count = 0;
+	cord->stack_reclaimed = 0;
 	cord->fiber_registry = mh_i32ptr_new();
 
 	/* sched fiber is not present in alive/ready/dead list. */
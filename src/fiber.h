@@ -87,6 +87,22 @@ enum {
 	FIBER_DEFAULT_FLAGS = FIBER_IS_CANCELLABLE
 };
 
+enum {
+	/**
+	 * Default size of a fiber stack, including the slab
+	 * header and the guard page.
+	 */
+	FIBER_STACK_SIZE_DEFAULT = 65536,
+	/** The smallest stack fiber_set_stack_size() accepts. */
+	FIBER_STACK_SIZE_MIN = 16384,
+	/**
+	 * How many dead fibers a cord caches with their stacks
+	 * intact. Stacks of the fibers cached beyond this
+	 * watermark are returned to the OS.
+	 */
+	FIBER_DEAD_WATERMARK = 128,
+};
+
 /**
  * \brief Pre-defined key for fiber local storage
  */
@@ -318,6 +334,12 @@ struct cord {
 	struct rlist ready;
 	/** A cache of dead fibers for reuse */
 	struct rlist dead;
+	/** Number of fibers in the dead list. */
+	uint32_t dead_count;
+	/** Number of cached fiber stacks returned to the OS. */
+	uint64_t stack_reclaim_count;
+	/** Total bytes of fiber stacks returned to the OS. */
+	uint64_t stack_reclaimed;
 	/** A watcher to have a single async event for all ready fibers.
 	 * This technique is necessary to be able to suspend
 	 * a single fiber on a few watchers (for example,
@@ -438,6 +460,32 @@ fiber_name(struct fiber *f)
 bool
 fiber_checkstack();
 
+/** Stack size of fibers created from now on. */
+size_t
+fiber_stack_size(void);
+
+/**
+ * Change the stack size of new fibers. The size is rounded
+ * up to the page size. Cached dead fibers with a stack of a
+ * different size get a new one when they are reused.
+ */
+void
+fiber_set_stack_size(size_t size);
+
+/** Whether fibers created from now on get a stack guard page. */
+bool
+fiber_stack_guard(void);
+
+/**
+ * Enable or disable the guard page below the stack of new
+ * fibers. Each guard page adds entries to the memory map of
+ * the process, so it may be worth disabling with a very large
+ * number of fibers. At most CORO_GUARD_MAX stacks are guarded
+ * anyway.
+ */
+void
+fiber_set_stack_guard(bool enable);
+
 /**
  * @brief yield & check for timeout
  * @return true if timeout exceeded
@@ -34,6 +34,7 @@
 #include <stdbool.h>
 #include "small/ibuf.h"
 #include "small/obuf.h"
+#include "small/rlist.h"
 
 struct iobuf
 {
@@ -41,6 +42,11 @@ struct iobuf
 	struct ibuf in;
 	/** Output buffer. */
 	struct obuf out;
+	/**
+	 * Link in a cache of idle buffers, if the owner
+	 * pools them (see iproto.cc).
+	 */
+	struct rlist in_cache;
 };
 
 /**
@@ -270,6 +270,18 @@
 #error "BPS_TREE_COMPARE_KEY must be defined"
 #endif
 
+/**
+ * Function to check that two elements are identical, i.e. are
+ * copies of the same element. Used only for debug checks of the
+ * tree structure. By default elements are compared with ==, so
+ * it must be defined if bps_tree_elem_t is a structure. Example:
+ * #define BPS_TREE_IS_IDENTICAL(a, b) ((a).ptr == (b).ptr)
+ */
+#ifndef BPS_TREE_IS_IDENTICAL
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a) == (b))
+#define BPS_TREE_IS_IDENTICAL_DEFAULT
+#endif
+
 /**
  * A switch to define the type of search in an array elements.
  * By default, bps_tree uses binary search to find a particular
@@ -347,6 +359,7 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_find _api_name(find)
 #define bps_tree_insert _api_name(insert)
 #define bps_tree_delete _api_name(delete)
+#define bps_tree_update _api_name(update)
 #define bps_tree_size _api_name(size)
 #define bps_tree_mem_used _api_name(mem_used)
 #define bps_tree_random _api_name(random)
@@ -616,6 +629,21 @@ bps_tree_insert(struct bps_tree *tree, bps_tree_elem_t new_elem,
 static inline int
 bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem);
 
+/**
+ * @brief Replace an element with another one in place. The new
+ *  element must take exactly the same position in the tree as the
+ *  old one, i.e. be greater than the previous element and less than
+ *  the next one, so the replace requires no rebalancing.
+ * @param tree - pointer to a tree
+ * @param old_elem - the element to replace
+ * @param new_elem - the element to put in its place
+ * @return - 0 on success or -1 if the old element was not found in
+ *  tree or the new element does not fit into its position
+ */
+static inline int
+bps_tree_update(struct bps_tree *tree, bps_tree_elem_t old_elem,
+		bps_tree_elem_t new_elem);
+
 /**
  * @brief Get size of tree, i.e. count of elements in tree
  * @param tree - pointer to a tree
@@ -4195,6 +4223,58 @@ bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem)
 	return 0;
 }
 
+/**
+ * @brief Replace an element with another one in place.
+ * @param tree - pointer to a tree
+ * @param old_elem - the element to replace
+ * @param new_elem - the element to put in its place
+ * @return - 0 on success or -1 if the old element was not found in
+ *  tree or the new element does not fit into its position
+ */
+static inline int
+bps_tree_update(struct bps_tree *tree, bps_tree_elem_t old_elem,
+		bps_tree_elem_t new_elem)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return -1;
+	struct bps_inner_path_elem path[BPS_TREE_MAX_DEPTH];
+	struct bps_leaf_path_elem leaf_path_elem;
+	bool exact;
+	bps_tree_collect_path(tree, old_elem, path, &leaf_path_elem, &exact);
+
+	if (!exact)
+		return -1;
+
+	/* Check that the new element is between the neighbours */
+	struct bps_leaf *leaf = leaf_path_elem.block;
+	bps_tree_pos_t pos = leaf_path_elem.insertion_point;
+	if (pos > 0) {
+		if (BPS_TREE_COMPARE(leaf->elems[pos - 1], new_elem,
+				     tree->arg) >= 0)
+			return -1;
+	} else if (leaf->prev_id != (bps_tree_block_id_t)(-1)) {
+		struct bps_leaf *prev = (struct bps_leaf *)
+			bps_tree_restore_block(tree, leaf->prev_id);
+		if (BPS_TREE_COMPARE(prev->elems[prev->header.size - 1],
+				     new_elem, tree->arg) >= 0)
+			return -1;
+	}
+	if (pos < leaf->header.size - 1) {
+		if (BPS_TREE_COMPARE(new_elem, leaf->elems[pos + 1],
+				     tree->arg) >= 0)
+			return -1;
+	} else if (leaf->next_id != (bps_tree_block_id_t)(-1)) {
+		struct bps_leaf *next = (struct bps_leaf *)
+			bps_tree_restore_block(tree, leaf->next_id);
+		if (BPS_TREE_COMPARE(new_elem, next->elems[0],
+				     tree->arg) >= 0)
+			return -1;
+	}
+
+	bps_tree_process_replace(tree, &leaf_path_elem, new_elem, NULL);
+	return 0;
+}
+
 /**
  * @brief Recursively find a maximum element in subtree.
  * Used only for debug purposes
@@ -4279,7 +4359,8 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 						       inner->child_ids[i]);
 			bps_tree_elem_t calc_max_elem =
 				bps_tree_debug_find_max_elem(tree, block);
-			if (inner->elems[i] != calc_max_elem)
+			if (!BPS_TREE_IS_IDENTICAL(inner->elems[i],
+						   calc_max_elem))
 				result |= 0x4000;
 		}
 		if (block->size > 1) {
@@ -4338,7 +4419,8 @@ bps_tree_debug_check(const struct bps_tree *tree)
 		return result;
 	}
 	struct bps_block *root = bps_tree_root(tree);
-	if (tree->max_elem != bps_tree_debug_find_max_elem(tree, root))
+	if (!BPS_TREE_IS_IDENTICAL(tree->max_elem,
+				   bps_tree_debug_find_max_elem(tree, root)))
 		result |= 0x8;
 	size_t calc_count = 0;
 	bps_tree_block_id_t expected_prev_id = (bps_tree_block_id_t)(-1);
@@ -4704,12 +4786,14 @@ bps_tree_debug_check_move_to_right_leaf(struct bps_tree *tree, bool assertme)
 				}
 
 				if (a.header.size)
-					if (ma != a.elems[a.header.size - 1]) {
+					if (!BPS_TREE_IS_IDENTICAL(ma,
+						a.elems[a.header.size - 1])) {
 						result |= (1 << 5);
 						assert(!assertme);
 					}
 				if (b.header.size)
-					if (mb != b.elems[b.header.size - 1]) {
+					if (!BPS_TREE_IS_IDENTICAL(mb,
+						b.elems[b.header.size - 1])) {
 						result |= (1 << 5);
 						assert(!assertme);
 					}
@@ -4801,12 +4885,14 @@ bps_tree_debug_check_move_to_left_leaf(struct bps_tree *tree, bool assertme)
 				}
 
 				if (a.header.size)
-					if (ma != a.elems[a.header.size - 1]) {
+					if (!BPS_TREE_IS_IDENTICAL(ma,
+						a.elems[a.header.size - 1])) {
 						result |= (1 << 7);
 						assert(!assertme);
 					}
 				if (b.header.size)
-					if (mb != b.elems[b.header.size - 1]) {
+					if (!BPS_TREE_IS_IDENTICAL(mb,
+						b.elems[b.header.size - 1])) {
 						result |= (1 << 7);
 						assert(!assertme);
 					}
@@ -4912,16 +4998,14 @@ bps_tree_debug_check_insert_and_move_to_right_leaf(struct bps_tree *tree,
 					}
 
 					if (i - u + 1)
-						if (ma
-							!= a.elems[a.header.size
-								- 1]) {
+						if (!BPS_TREE_IS_IDENTICAL(ma,
+							a.elems[a.header.size - 1])) {
 							result |= (1 << 9);
 							assert(!assertme);
 						}
 					if (j + u)
-						if (mb
-							!= b.elems[b.header.size
-								- 1]) {
+						if (!BPS_TREE_IS_IDENTICAL(mb,
+							b.elems[b.header.size - 1])) {
 							result |= (1 << 9);
 							assert(!assertme);
 						}
@@ -5028,16 +5112,14 @@ bps_tree_debug_check_insert_and_move_to_left_leaf(struct bps_tree *tree,
 					}
 
 					if (i + u)
-						if (ma
-							!= a.elems[a.header.size
-								- 1]) {
+						if (!BPS_TREE_IS_IDENTICAL(ma,
+							a.elems[a.header.size - 1])) {
 							result |= (1 << 11);
 							assert(!assertme);
 						}
 					if (j - u + 1)
-						if (mb
-							!= b.elems[b.header.size
-								- 1]) {
+						if (!BPS_TREE_IS_IDENTICAL(mb,
+							b.elems[b.header.size - 1])) {
 							result |= (1 << 11);
 							assert(!assertme);
 						}
@@ -5712,6 +5794,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_find
 #undef bps_tree_insert
 #undef bps_tree_delete
+#undef bps_tree_update
 #undef bps_tree_size
 #undef bps_tree_mem_used
 #undef bps_tree_random
@@ -5741,6 +5824,11 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef BPS_TREE_BT_INNER
 #undef BPS_TREE_BT_LEAF
 
+#ifdef BPS_TREE_IS_IDENTICAL_DEFAULT
+#undef BPS_TREE_IS_IDENTICAL
+#undef BPS_TREE_IS_IDENTICAL_DEFAULT
+#endif
+
 #undef bps_tree_restore_block
 #undef bps_tree_restore_block_ver
 #undef bps_tree_root
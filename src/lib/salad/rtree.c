@@ -30,10 +30,18 @@
  */
 #include "rtree.h"
 #include <string.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <limits.h>
 #include <stddef.h>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
 #include <sys/types.h>
+#include <third_party/qsort_arg.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 /*------------------------------------------------------------------------- */
 /* R-tree internal structures definition */
@@ -42,8 +50,9 @@ enum {
 	/* rtree will try to determine optimal page size */
 	RTREE_OPTIMAL_BRANCHES_IN_PAGE = 18,
 	/* actual number of branches could be up to double of the previous
-	 * constant */
-	RTREE_MAXIMUM_BRANCHES_IN_PAGE = RTREE_OPTIMAL_BRANCHES_IN_PAGE * 2
+	 * constant, and double of that with RTREE_COORD_FLOAT, since the
+	 * page size is chosen for coord_t coordinates */
+	RTREE_MAXIMUM_BRANCHES_IN_PAGE = RTREE_OPTIMAL_BRANCHES_IN_PAGE * 4
 };
 
 struct rtree_page_branch {
@@ -51,7 +60,12 @@ struct rtree_page_branch {
 		struct rtree_page *page;
 		record_t record;
 	} data;
-	struct rtree_rect rect;
+	union {
+		/* RTREE_COORD_DOUBLE */
+		struct rtree_rect rect;
+		/* RTREE_COORD_FLOAT, same layout */
+		float fcoords[RTREE_MAX_DIMENSION * 2];
+	};
 };
 
 enum {
@@ -70,6 +84,17 @@ struct rtree_neighbor_page {
 	struct rtree_neighbor buf[];
 };
 
+enum {
+	/*
+	 * Level of a record neighbor with the distance computed by the
+	 * float rectangle of the record. It is a lower bound of the
+	 * exact distance, so a record is returned by KNN iterator only
+	 * after the exact distance is fetched and the record is still
+	 * the closest one.
+	 */
+	RTREE_NEIGHBOR_LOWER_BOUND = -1
+};
+
 struct rtree_reinsert_list {
 	struct rtree_page *chain;
 	int level;
@@ -132,6 +157,73 @@ rtree_set2dp(struct rtree_rect *rect, coord_t x, coord_t y)
 	rect->coords[3] = y;
 }
 
+#if defined(__SSE2__)
+
+/*
+ * SSE2 versions of the hottest rectangle functions. Coordinates
+ * of an axis are a pair { low, upper } that fits a single register,
+ * so an axis is processed without branches, and results are the
+ * same as of the scalar versions, including NaN handling.
+ */
+
+/* { a, -b } of a pair { a, b } */
+static inline __m128d
+rtree_pair_neg_hi(__m128d v)
+{
+	return _mm_xor_pd(v, _mm_set_pd(-0.0, 0.0));
+}
+
+/* { low - x, x - upper }, clamped at zero from below */
+static inline __m128d
+rtree_pair_excess(__m128d coords, double x)
+{
+	__m128d excess = _mm_sub_pd(rtree_pair_neg_hi(coords),
+				    _mm_set_pd(-x, x));
+	return _mm_max_pd(excess, _mm_setzero_pd());
+}
+
+/* Sum of the two values of a pair */
+static inline double
+rtree_pair_sum(__m128d v)
+{
+	return _mm_cvtsd_f64(v) + _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+}
+
+/* Manhattan distance */
+static sq_coord_t
+rtree_rect_neigh_distance(const struct rtree_rect *rect,
+			   const struct rtree_rect *neigh_rect,
+			   unsigned dimension)
+{
+	sq_coord_t result = 0;
+	for (int i = dimension; --i >= 0; ) {
+		__m128d excess =
+			rtree_pair_excess(_mm_loadu_pd(&rect->coords[2 * i]),
+					  neigh_rect->coords[2 * i]);
+		/* At most one of the values is not zero */
+		result += rtree_pair_sum(excess);
+	}
+	return result;
+}
+
+/* Euclid distance, squared */
+static sq_coord_t
+rtree_rect_neigh_distance2(const struct rtree_rect *rect,
+			   const struct rtree_rect *neigh_rect,
+			   unsigned dimension)
+{
+	sq_coord_t result = 0;
+	for (int i = dimension; --i >= 0; ) {
+		__m128d excess =
+			rtree_pair_excess(_mm_loadu_pd(&rect->coords[2 * i]),
+					  neigh_rect->coords[2 * i]);
+		result += rtree_pair_sum(_mm_mul_pd(excess, excess));
+	}
+	return result;
+}
+
+#else /* !defined(__SSE2__) */
+
 /* Manhattan distance */
 static sq_coord_t
 rtree_rect_neigh_distance(const struct rtree_rect *rect,
@@ -174,6 +266,8 @@ rtree_rect_neigh_distance2(const struct rtree_rect *rect,
 	return result;
 }
 
+#endif /* defined(__SSE2__) */
+
 static area_t
 rtree_rect_area(const struct rtree_rect *rect, unsigned dimension)
 {
@@ -261,6 +355,20 @@ rtree_rect_intersects_rect(const struct rtree_rect *rt1,
 			   const struct rtree_rect *rt2,
 			   unsigned dimension)
 {
+#if defined(__SSE2__)
+	/*
+	 * Rectangles are apart along an axis if
+	 * { low1, -upper1 } > { upper2, -low2 } in any lane.
+	 */
+	__m128d apart = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d c1 = rtree_pair_neg_hi(_mm_loadu_pd(&rt1->coords[2 * i]));
+		__m128d c2 = _mm_loadu_pd(&rt2->coords[2 * i]);
+		c2 = rtree_pair_neg_hi(_mm_shuffle_pd(c2, c2, 1));
+		apart = _mm_or_pd(apart, _mm_cmpgt_pd(c1, c2));
+	}
+	return _mm_movemask_pd(apart) == 0;
+#else
 	for (int i = dimension; --i >= 0; ) {
 		const coord_t *coords1 = &rt1->coords[2 * i];
 		const coord_t *coords2 = &rt2->coords[2 * i];
@@ -268,6 +376,42 @@ rtree_rect_intersects_rect(const struct rtree_rect *rt1,
 			return false;
 	}
 	return true;
+#endif
+}
+
+/*
+ * rtree_rect_intersects_rect() with float coordinates of rt2,
+ * or, if strict, the same with touching rectangles considered
+ * apart.
+ */
+static inline bool
+rtree_rect_intersects_frect(const struct rtree_rect *rt1,
+			    const float *fcoords2, unsigned dimension,
+			    bool strict)
+{
+#if defined(__SSE2__)
+	__m128d apart = _mm_setzero_pd();
+	for (int i = dimension; --i >= 0; ) {
+		__m128d c1 = rtree_pair_neg_hi(_mm_loadu_pd(&rt1->coords[2 * i]));
+		__m128d c2 = _mm_cvtps_pd(_mm_castsi128_ps(
+			_mm_loadl_epi64((const __m128i *)&fcoords2[2 * i])));
+		c2 = rtree_pair_neg_hi(_mm_shuffle_pd(c2, c2, 1));
+		apart = _mm_or_pd(apart, strict ? _mm_cmpge_pd(c1, c2) :
+						  _mm_cmpgt_pd(c1, c2));
+	}
+	return _mm_movemask_pd(apart) == 0;
+#else
+	for (int i = dimension; --i >= 0; ) {
+		const coord_t *coords1 = &rt1->coords[2 * i];
+		const float *coords2 = &fcoords2[2 * i];
+		if (strict ? coords1[0] >= coords2[1] ||
+			     coords1[1] <= coords2[0] :
+			     coords1[0] > coords2[1] ||
+			     coords1[1] < coords2[0])
+			return false;
+	}
+	return true;
+#endif
 }
 
 static bool
@@ -371,11 +515,87 @@ rtree_branch_get(const struct rtree *tree, const struct rtree_page *page,
 }
 
 static void
-rtree_branch_copy(struct rtree_page_branch *to,
-		  const struct rtree_page_branch *from, unsigned dimension)
+rtree_branch_copy(const struct rtree *tree, struct rtree_page_branch *to,
+		  const struct rtree_page_branch *from)
+{
+	memcpy(to, from, tree->page_branch_size);
+}
+
+/*
+ * Rectangle of a branch. Float coordinates are converted into buf,
+ * coord_t ones are returned as is.
+ */
+static inline const struct rtree_rect *
+rtree_branch_rect(const struct rtree *tree, const struct rtree_page_branch *b,
+		  struct rtree_rect *buf)
+{
+	if (tree->coord_type == RTREE_COORD_DOUBLE)
+		return &b->rect;
+	for (int i = tree->dimension * 2; --i >= 0; )
+		buf->coords[i] = b->fcoords[i];
+	return buf;
+}
+
+/*
+ * A float one step up or down from f, or a bit farther: faster
+ * than nextafterf() and good enough for bounds of rectangles.
+ */
+static inline float
+rtree_float_step(float f, bool up)
+{
+	union {
+		float f;
+		int32_t i;
+	} u;
+	u.f = f;
+	if (f == 0 || f != f || f == INFINITY || f == -INFINITY) {
+		/* FLT_MIN is farther than the least denormal */
+		if (f == 0)
+			return up ? FLT_MIN : -FLT_MIN;
+		if (f == INFINITY && !up)
+			return FLT_MAX;
+		if (f == -INFINITY && up)
+			return -FLT_MAX;
+		return f;
+	}
+	/* Adjacent floats of the same sign have adjacent bit patterns */
+	u.i += (f > 0) == up ? 1 : -1;
+	return u.f;
+}
+
+/* The greatest float not greater than the value */
+static float
+rtree_float_floor(coord_t value)
+{
+	float f = (float)value;
+	return f > value ? nextafterf(f, -INFINITY) : f;
+}
+
+/* The least float not less than the value */
+static float
+rtree_float_ceil(coord_t value)
+{
+	float f = (float)value;
+	return f < value ? nextafterf(f, INFINITY) : f;
+}
+
+/*
+ * Set the rectangle of a branch. Float coordinates are rounded
+ * outwards, so that the stored rectangle covers the given one.
+ */
+static void
+rtree_branch_set_rect(const struct rtree *tree, struct rtree_page_branch *b,
+		      const struct rtree_rect *rect)
 {
-	to->data = from->data;
-	rtree_rect_copy(&to->rect, &from->rect, dimension);
+	if (tree->coord_type == RTREE_COORD_DOUBLE) {
+		rtree_rect_copy(&b->rect, rect, tree->dimension);
+		return;
+	}
+	for (int i = tree->dimension; --i >= 0; ) {
+		b->fcoords[2 * i] = rtree_float_floor(rect->coords[2 * i]);
+		b->fcoords[2 * i + 1] =
+			rtree_float_ceil(rect->coords[2 * i + 1]);
+	}
 }
 
 
@@ -402,14 +622,30 @@ static void
 rtree_page_cover(const struct rtree *tree, const struct rtree_page *page,
 		 struct rtree_rect *res)
 {
-	rtree_rect_copy(res, &rtree_branch_get(tree, page, 0)->rect,
-			tree->dimension);
+	struct rtree_rect buf;
+	rtree_rect_copy(res, rtree_branch_rect(tree,
+			rtree_branch_get(tree, page, 0), &buf), tree->dimension);
 	for (unsigned i = 1; i < page->n; i++) {
-		rtree_rect_add(res, &rtree_branch_get(tree, page, i)->rect,
+		rtree_rect_add(res, rtree_branch_rect(tree,
+			       rtree_branch_get(tree, page, i), &buf),
 			       tree->dimension);
 	}
 }
 
+/* Set the rectangle of a branch to the cover of a page */
+static void
+rtree_branch_cover_page(const struct rtree *tree, struct rtree_page_branch *b,
+			const struct rtree_page *page)
+{
+	if (tree->coord_type == RTREE_COORD_DOUBLE) {
+		rtree_page_cover(tree, page, &b->rect);
+	} else {
+		struct rtree_rect cover;
+		rtree_page_cover(tree, page, &cover);
+		rtree_branch_set_rect(tree, b, &cover);
+	}
+}
+
 /* Create root page by first inserting record */
 static void
 rtree_page_init_with_record(const struct rtree *tree, struct rtree_page *page,
@@ -417,7 +653,7 @@ rtree_page_init_with_record(const struct rtree *tree, struct rtree_page *page,
 {
 	struct rtree_page_branch *b = rtree_branch_get(tree, page, 0);
 	page->n = 1;
-	rtree_rect_copy(&b->rect, rect, tree->dimension);
+	rtree_branch_set_rect(tree, b, rect);
 	b->data.record = obj;
 }
 
@@ -428,10 +664,10 @@ rtree_page_init_with_pages(const struct rtree *tree, struct rtree_page *page,
 {
 	page->n = 2;
 	struct rtree_page_branch *b = rtree_branch_get(tree, page, 0);
-	rtree_page_cover(tree, page1, &b->rect);
+	rtree_branch_cover_page(tree, b, page1);
 	b->data.page = page1;
 	b = rtree_branch_get(tree, page, 1);
-	rtree_page_cover(tree, page2, &b->rect);
+	rtree_branch_cover_page(tree, b, page2);
 	b->data.page = page2;
 }
 
@@ -442,11 +678,15 @@ rtree_split_page(struct rtree *tree, struct rtree_page *page,
 	assert(page->n == tree->page_max_fill);
 	const struct rtree_rect *rects[RTREE_MAXIMUM_BRANCHES_IN_PAGE + 1];
 	unsigned ids[RTREE_MAXIMUM_BRANCHES_IN_PAGE + 1];
-	rects[0] = &br->rect;
+	/* Float rectangles are converted into split_rects */
+	struct rtree_rect *buf = tree->split_rects;
+	rects[0] = rtree_branch_rect(tree, br, buf);
 	ids[0] = 0;
 	for (unsigned i = 0; i < page->n; i++) {
 		struct rtree_page_branch *b = rtree_branch_get(tree, page, i);
-		rects[i + 1] = &b->rect;
+		if (buf != NULL)
+			buf++;
+		rects[i + 1] = rtree_branch_rect(tree, b, buf);
 		ids[i + 1] = i + 1;
 	}
 	const unsigned n = page->n + 1;
@@ -559,7 +799,7 @@ rtree_split_page(struct rtree *tree, struct rtree_page *page,
 			from_b = rtree_branch_get(tree, page, ids[i] - 1);
 			taken[ids[i] - 1] = 1;
 		}
-		rtree_branch_copy(new_b, from_b, d);
+		rtree_branch_copy(tree, new_b, from_b);
 	}
 	unsigned moved = 0;
 	for (unsigned i = 0, j = 0; j < page->n; j++) {
@@ -567,7 +807,7 @@ rtree_split_page(struct rtree *tree, struct rtree_page *page,
 			struct rtree_page_branch *to, *from;
 			to = rtree_branch_get(tree, page, i++);
 			from = rtree_branch_get(tree, page, j);
-			rtree_branch_copy(to, from, tree->dimension);
+			rtree_branch_copy(tree, to, from);
 			moved++;
 		}
 	}
@@ -575,7 +815,7 @@ rtree_split_page(struct rtree *tree, struct rtree_page *page,
 	if (moved + 1 == k2) {
 		struct rtree_page_branch *to;
 		to = rtree_branch_get(tree, page, moved);
-		rtree_branch_copy(to, br, tree->dimension);
+		rtree_branch_copy(tree, to, br);
 	}
 	new_page->n = k1;
 	page->n = k2;
@@ -589,7 +829,7 @@ rtree_page_add_branch(struct rtree *tree, struct rtree_page *page,
 	if (page->n < tree->page_max_fill) {
 		struct rtree_page_branch *b;
 		b = rtree_branch_get(tree, page, page->n++);
-		rtree_branch_copy(b, br, tree->dimension);
+		rtree_branch_copy(tree, b, br);
 		return NULL;
 	} else {
 		return rtree_split_page(tree, page, br);
@@ -604,7 +844,7 @@ rtree_page_remove_branch(struct rtree *tree, struct rtree_page *page, int i)
 		struct rtree_page_branch *to, *from;
 		to = rtree_branch_get(tree, page, j);
 		from = rtree_branch_get(tree, page, j + 1);
-		rtree_branch_copy(to, from, tree->dimension);
+		rtree_branch_copy(tree, to, from);
 	}
 }
 
@@ -621,10 +861,13 @@ rtree_page_insert(struct rtree *tree, struct rtree_page *page,
 		for (unsigned i = 0; i < page->n; i++) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(tree, page, i);
-			area_t r_area = rtree_rect_area(&b->rect,
+			struct rtree_rect buf;
+			const struct rtree_rect *b_rect =
+				rtree_branch_rect(tree, b, &buf);
+			area_t r_area = rtree_rect_area(b_rect,
 							tree->dimension);
 			struct rtree_rect cover;
-			rtree_rect_cover(&b->rect, rect,
+			rtree_rect_cover(b_rect, rect,
 					 &cover, tree->dimension);
 			area_t incr = rtree_rect_area(&cover,
 						      tree->dimension);
@@ -646,18 +889,26 @@ rtree_page_insert(struct rtree *tree, struct rtree_page *page,
 							 rect, obj, level);
 		if (q == NULL) {
 			/* child was not split */
-			rtree_rect_add(&b->rect, rect, tree->dimension);
+			if (tree->coord_type == RTREE_COORD_DOUBLE) {
+				rtree_rect_add(&b->rect, rect, tree->dimension);
+			} else {
+				struct rtree_rect cover;
+				rtree_rect_cover(rtree_branch_rect(tree, b,
+								   &cover),
+						 rect, &cover, tree->dimension);
+				rtree_branch_set_rect(tree, b, &cover);
+			}
 			return NULL;
 		} else {
 			/* child was split */
-			rtree_page_cover(tree, p, &b->rect);
+			rtree_branch_cover_page(tree, b, p);
 			br.data.page = q;
-			rtree_page_cover(tree, q, &br.rect);
+			rtree_branch_cover_page(tree, &br, q);
 			return rtree_page_add_branch(tree, page, &br);
 		}
 	} else {
 		br.data.record = obj;
-		rtree_rect_copy(&br.rect, rect, tree->dimension);
+		rtree_branch_set_rect(tree, &br, rect);
 		return rtree_page_add_branch(tree, page, &br);
 	}
 }
@@ -672,14 +923,16 @@ rtree_page_remove(struct rtree *tree, struct rtree_page *page,
 		for (unsigned i = 0; i < page->n; i++) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(tree, page, i);
-			if (!rtree_rect_intersects_rect(&b->rect, rect, d))
+			struct rtree_rect buf;
+			if (!rtree_rect_intersects_rect(rtree_branch_rect(tree,
+							b, &buf), rect, d))
 				continue;
 			struct rtree_page *next_page = b->data.page;
 			if (!rtree_page_remove(tree, next_page, rect,
 					       obj, level, rlist))
 				continue;
 			if (next_page->n >= tree->page_min_fill) {
-				rtree_page_cover(tree, next_page, &b->rect);
+				rtree_branch_cover_page(tree, b, next_page);
 			} else {
 				/* not enough entries in child */
 				set_next_reinsert_page(tree, next_page,
@@ -720,16 +973,89 @@ rtree_page_purge(struct rtree *tree, struct rtree_page *page, int level)
 /* R-tree iterator methods */
 /*------------------------------------------------------------------------- */
 
+/* Check a branch of an internal page */
+static inline bool
+rtree_iterator_intr_match(const struct rtree_iterator *itr,
+			  const struct rtree_page_branch *b)
+{
+	const struct rtree *tree = itr->tree;
+	if (tree->coord_type == RTREE_COORD_FLOAT &&
+	    itr->intr_cmp == rtree_rect_intersects_rect) {
+		/* The most common case, compare without conversion */
+		return rtree_rect_intersects_frect(&itr->rect, b->fcoords,
+						   tree->dimension, false);
+	}
+	struct rtree_rect buf;
+	return itr->intr_cmp(&itr->rect, rtree_branch_rect(tree, b, &buf),
+			     tree->dimension);
+}
+
+/* Check a branch of a leaf page */
+static inline bool
+rtree_iterator_leaf_match(const struct rtree_iterator *itr,
+			  const struct rtree_page_branch *b)
+{
+	const struct rtree *tree = itr->tree;
+	unsigned d = tree->dimension;
+	if (tree->coord_type == RTREE_COORD_DOUBLE)
+		return itr->leaf_cmp(&itr->rect, &b->rect, d);
+	if (itr->op == SOP_ALL)
+		return true;
+	/*
+	 * The stored rectangle covers the exact one. For any search
+	 * operation the internal page comparator accepts a rectangle
+	 * if the leaf comparator accepts something inside it, so it
+	 * filters out records before their exact rectangles are
+	 * fetched.
+	 */
+	if (!rtree_iterator_intr_match(itr, b))
+		return false;
+	struct rtree_rect rect;
+	/*
+	 * Each exact coordinate is not farther than one float step
+	 * inwards from the stored one. Accept the record if any such
+	 * rectangle is accepted.
+	 */
+	switch (itr->op) {
+	case SOP_BELONGS:
+	case SOP_STRICT_BELONGS:
+		if (itr->leaf_cmp(&itr->rect,
+				  rtree_branch_rect(tree, b, &rect), d))
+			return true;
+		break;
+	case SOP_OVERLAPS:
+		/* The most common case, see rtree_search() */
+		if (rtree_rect_intersects_frect(&itr->inner_rect, b->fcoords,
+						d, true))
+			return true;
+		break;
+	case SOP_CONTAINS:
+	case SOP_STRICT_CONTAINS:
+		for (int i = d; --i >= 0; ) {
+			rect.coords[2 * i] =
+				rtree_float_step(b->fcoords[2 * i], true);
+			rect.coords[2 * i + 1] =
+				rtree_float_step(b->fcoords[2 * i + 1], false);
+		}
+		if (itr->leaf_cmp(&itr->rect, &rect, d))
+			return true;
+		break;
+	default:
+		break;
+	}
+	tree->record_rect(tree->record_rect_ctx, b->data.record, &rect);
+	return itr->leaf_cmp(&itr->rect, &rect, d);
+}
+
 static bool
 rtree_iterator_goto_first(struct rtree_iterator *itr, unsigned sp,
 			  struct rtree_page* pg)
 {
-	unsigned d = itr->tree->dimension;
 	if (sp + 1 == itr->tree->height) {
 		for (unsigned i = 0, n = pg->n; i < n; i++) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(itr->tree, pg, i);
-			if (itr->leaf_cmp(&itr->rect, &b->rect, d)) {
+			if (rtree_iterator_leaf_match(itr, b)) {
 				itr->stack[sp].page = pg;
 				itr->stack[sp].pos = i;
 				return true;
@@ -739,7 +1065,7 @@ rtree_iterator_goto_first(struct rtree_iterator *itr, unsigned sp,
 		for (unsigned i = 0, n = pg->n; i < n; i++) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(itr->tree, pg, i);
-			if (itr->intr_cmp(&itr->rect, &b->rect, d)
+			if (rtree_iterator_intr_match(itr, b)
 			    && rtree_iterator_goto_first(itr, sp + 1,
 							 b->data.page))
 			{
@@ -756,13 +1082,12 @@ rtree_iterator_goto_first(struct rtree_iterator *itr, unsigned sp,
 static bool
 rtree_iterator_goto_next(struct rtree_iterator *itr, unsigned sp)
 {
-	unsigned d = itr->tree->dimension;
 	struct rtree_page *pg = itr->stack[sp].page;
 	if (sp + 1 == itr->tree->height) {
 		for (unsigned i = itr->stack[sp].pos, n = pg->n; ++i < n;) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(itr->tree, pg, i);
-			if (itr->leaf_cmp(&itr->rect, &b->rect, d)) {
+			if (rtree_iterator_leaf_match(itr, b)) {
 				itr->stack[sp].pos = i;
 				return true;
 			}
@@ -771,7 +1096,7 @@ rtree_iterator_goto_next(struct rtree_iterator *itr, unsigned sp)
 		for (int i = itr->stack[sp].pos, n = pg->n; ++i < n;) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(itr->tree, pg, i);
-			if (itr->intr_cmp(&itr->rect, &b->rect, d)
+			if (rtree_iterator_intr_match(itr, b)
 			    && rtree_iterator_goto_first(itr, sp + 1,
 							 b->data.page))
 			{
@@ -865,28 +1190,56 @@ static void
 rtree_iterator_process_neigh(struct rtree_iterator *itr,
 			     struct rtree_neighbor *neighbor)
 {
-	unsigned d = itr->tree->dimension;
+	const struct rtree *tree = itr->tree;
+	unsigned d = tree->dimension;
 	void *child = neighbor->child;
 	struct rtree_page *pg = (struct rtree_page *)child;
 	int level = neighbor->level;
 	rtree_iterator_free_neighbor(itr, neighbor);
 	for (int i = 0, n = pg->n; i < n; i++) {
 		struct rtree_page_branch *b;
-		b = rtree_branch_get(itr->tree, pg, i);
+		b = rtree_branch_get(tree, pg, i);
+		struct rtree_rect buf;
+		const struct rtree_rect *rect = rtree_branch_rect(tree, b,
+								  &buf);
 		coord_t distance;
-		if (itr->tree->distance_type == RTREE_EUCLID)
-			distance = rtree_rect_neigh_distance2(&b->rect,
+		if (tree->distance_type == RTREE_EUCLID)
+			distance = rtree_rect_neigh_distance2(rect,
 							      &itr->rect, d);
 		else
-			distance = rtree_rect_neigh_distance(&b->rect,
+			distance = rtree_rect_neigh_distance(rect,
 							     &itr->rect, d);
+		int child_level = level - 1;
+		if (child_level == 0 && tree->coord_type == RTREE_COORD_FLOAT)
+			child_level = RTREE_NEIGHBOR_LOWER_BOUND;
 		struct rtree_neighbor *neigh =
 			rtree_iterator_new_neighbor(itr, b->data.page,
-						    distance, level - 1);
+						    distance, child_level);
 		rtnt_insert(&itr->neigh_tree, neigh);
 	}
 }
 
+/*
+ * Replace the lower bound of the distance to a record, given by
+ * its float rectangle, with the exact distance.
+ */
+static void
+rtree_iterator_refine_neigh(struct rtree_iterator *itr,
+			    struct rtree_neighbor *neighbor)
+{
+	const struct rtree *tree = itr->tree;
+	struct rtree_rect rect;
+	tree->record_rect(tree->record_rect_ctx, neighbor->child, &rect);
+	if (tree->distance_type == RTREE_EUCLID)
+		neighbor->distance = rtree_rect_neigh_distance2(&rect,
+						&itr->rect, tree->dimension);
+	else
+		neighbor->distance = rtree_rect_neigh_distance(&rect,
+						&itr->rect, tree->dimension);
+	neighbor->level = 0;
+	rtnt_insert(&itr->neigh_tree, neighbor);
+}
+
 
 record_t
 rtree_iterator_next(struct rtree_iterator *itr)
@@ -920,6 +1273,9 @@ rtree_iterator_next(struct rtree_iterator *itr)
 				void *child = neighbor->child;
 				rtree_iterator_free_neighbor(itr, neighbor);
 				return (record_t)child;
+			} else if (neighbor->level ==
+				   RTREE_NEIGHBOR_LOWER_BOUND) {
+				rtree_iterator_refine_neigh(itr, neighbor);
 			} else {
 				rtree_iterator_process_neigh(itr, neighbor);
 			}
@@ -940,6 +1296,16 @@ rtree_iterator_next(struct rtree_iterator *itr)
 /* R-tree methods */
 /*------------------------------------------------------------------------- */
 
+/* Set page fill limits according to the page branch size */
+static void
+rtree_set_page_fill(struct rtree *tree)
+{
+	tree->page_max_fill = (tree->page_size - sizeof(int)) /
+		tree->page_branch_size;
+	tree->page_min_fill = tree->page_max_fill * 2 / 5;
+	assert(tree->page_max_fill <= RTREE_MAXIMUM_BRANCHES_IN_PAGE);
+}
+
 int
 rtree_init(struct rtree *tree, unsigned dimension, uint32_t extent_size,
 	   rtree_extent_alloc_t extent_alloc, rtree_extent_free_t extent_free,
@@ -954,6 +1320,10 @@ rtree_init(struct rtree *tree, unsigned dimension, uint32_t extent_size,
 
 	tree->dimension = dimension;
 	tree->distance_type = distance_type;
+	tree->coord_type = RTREE_COORD_DOUBLE;
+	tree->record_rect = NULL;
+	tree->record_rect_ctx = NULL;
+	tree->split_rects = NULL;
 	tree->page_branch_size =
 		(RTREE_BRANCH_DATA_SIZE + dimension * 2 * sizeof(coord_t));
 	tree->page_size = RTREE_OPTIMAL_BRANCHES_IN_PAGE *
@@ -963,21 +1333,55 @@ rtree_init(struct rtree *tree, unsigned dimension, uint32_t extent_size,
 	tree->page_size = 1u << (sizeof(int) * CHAR_BIT - lz);
 	assert(tree->page_size - sizeof(int) >=
 	       tree->page_branch_size * RTREE_OPTIMAL_BRANCHES_IN_PAGE);
-	tree->page_max_fill = (tree->page_size - sizeof(int)) /
-		tree->page_branch_size;
-	tree->page_min_fill = tree->page_max_fill * 2 / 5;
+	rtree_set_page_fill(tree);
 	tree->neighbours_in_page = (tree->page_size - sizeof(void *))
 		/ sizeof(struct rtree_neighbor);
 
+	tree->build_buf = NULL;
+	tree->build_count = 0;
+	tree->build_capacity = 0;
+
 	matras_create(&tree->mtab, extent_size, tree->page_size,
 		      extent_alloc, extent_free, alloc_ctx);
 	return 0;
 }
 
+int
+rtree_set_coord_type(struct rtree *tree, enum rtree_coord_type coord_type,
+		     rtree_record_rect_t record_rect, void *record_rect_ctx)
+{
+	assert(tree->root == NULL && tree->build_count == 0);
+	assert(coord_type == RTREE_COORD_DOUBLE || record_rect != NULL);
+	size_t coord_size = sizeof(coord_t);
+	if (coord_type == RTREE_COORD_FLOAT) {
+		if (tree->split_rects == NULL) {
+			tree->split_rects = (struct rtree_rect *)
+				malloc((RTREE_MAXIMUM_BRANCHES_IN_PAGE + 1) *
+				       sizeof(struct rtree_rect));
+			if (tree->split_rects == NULL)
+				return -1;
+		}
+		coord_size = sizeof(float);
+	}
+	tree->coord_type = coord_type;
+	tree->record_rect = record_rect;
+	tree->record_rect_ctx = record_rect_ctx;
+	/* Keep the page size, so float pages get twice as many branches */
+	tree->page_branch_size = RTREE_BRANCH_DATA_SIZE +
+		tree->dimension * 2 * coord_size;
+	rtree_set_page_fill(tree);
+	return 0;
+}
+
 void
 rtree_destroy(struct rtree *tree)
 {
 	rtree_purge(tree);
+	free(tree->split_rects);
+	tree->split_rects = NULL;
+	free(tree->build_buf);
+	tree->build_buf = NULL;
+	tree->build_count = tree->build_capacity = 0;
 	matras_destroy(&tree->mtab);
 }
 
@@ -1006,6 +1410,174 @@ rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj)
 	tree->n_records++;
 }
 
+int
+rtree_build_reserve(struct rtree *tree, size_t count)
+{
+	if (count <= tree->build_capacity)
+		return 0;
+	char *buf = (char *)realloc(tree->build_buf,
+				    count * tree->page_branch_size);
+	if (buf == NULL)
+		return -1;
+	tree->build_buf = buf;
+	tree->build_capacity = count;
+	return 0;
+}
+
+int
+rtree_build_add(struct rtree *tree, const struct rtree_rect *rect,
+		record_t obj)
+{
+	if (tree->build_count == tree->build_capacity) {
+		size_t capacity = tree->build_capacity +
+				  tree->build_capacity / 2;
+		if (capacity < RTREE_MAXIMUM_BRANCHES_IN_PAGE)
+			capacity = RTREE_MAXIMUM_BRANCHES_IN_PAGE;
+		if (rtree_build_reserve(tree, capacity) != 0)
+			return -1;
+	}
+	struct rtree_page_branch *b = (struct rtree_page_branch *)
+		(tree->build_buf + tree->build_count * tree->page_branch_size);
+	b->data.record = obj;
+	rtree_branch_set_rect(tree, b, rect);
+	tree->build_count++;
+	return 0;
+}
+
+/* Axis of rtree_branch_center_cmp() */
+struct rtree_sort_axis {
+	const struct rtree *tree;
+	unsigned axis;
+};
+
+/* Doubled center of a branch along an axis, to save a division */
+static inline coord_t
+rtree_branch_center2(const struct rtree *tree,
+		     const struct rtree_page_branch *b, unsigned axis)
+{
+	if (tree->coord_type == RTREE_COORD_DOUBLE)
+		return b->rect.coords[2 * axis] + b->rect.coords[2 * axis + 1];
+	return (coord_t)b->fcoords[2 * axis] + b->fcoords[2 * axis + 1];
+}
+
+/* Compare branches by the center of the rectangle along an axis */
+static int
+rtree_branch_center_cmp(const void *a, const void *b, void *arg)
+{
+	const struct rtree_sort_axis *sort_axis =
+		(const struct rtree_sort_axis *)arg;
+	coord_t sa = rtree_branch_center2(sort_axis->tree,
+		(const struct rtree_page_branch *)a, sort_axis->axis);
+	coord_t sb = rtree_branch_center2(sort_axis->tree,
+		(const struct rtree_page_branch *)b, sort_axis->axis);
+	return sa < sb ? -1 : sa > sb;
+}
+
+/* The smallest s such that s^k >= n */
+static size_t
+rtree_root_ceil(size_t n, unsigned k)
+{
+	size_t s = 1;
+	while (true) {
+		size_t p = 1;
+		for (unsigned i = 0; i < k && p < n; i++)
+			p *= s;
+		if (p >= n)
+			return s;
+		s++;
+	}
+}
+
+/*
+ * Sort-Tile-Recursive ordering of count branches: sort them by
+ * the axis, cut into slabs of whole pages and order each slab by
+ * the next axes, so that every page_max_fill consecutive branches
+ * are close to each other.
+ */
+static void
+rtree_str_sort(const struct rtree *tree, char *branches, size_t count,
+	       unsigned axis)
+{
+	struct rtree_sort_axis sort_axis = { tree, axis };
+	qsort_arg(branches, count, tree->page_branch_size,
+		  rtree_branch_center_cmp, &sort_axis);
+	if (axis + 1 == tree->dimension)
+		return;
+	size_t max_fill = tree->page_max_fill;
+	size_t n_pages = (count + max_fill - 1) / max_fill;
+	size_t n_slabs = rtree_root_ceil(n_pages, tree->dimension - axis);
+	size_t slab_size = (n_pages + n_slabs - 1) / n_slabs * max_fill;
+	for (size_t i = 0; i < count; i += slab_size) {
+		size_t n = count - i < slab_size ? count - i : slab_size;
+		rtree_str_sort(tree, branches + i * tree->page_branch_size,
+			       n, axis + 1);
+	}
+}
+
+/*
+ * Pack count ordered branches into pages of one tree level and
+ * replace them with the branches that point to the new pages.
+ * Pages are filled up to the maximum, only the last two may be
+ * balanced to keep the minimal fill. Returns the number of pages.
+ */
+static size_t
+rtree_build_level(struct rtree *tree, char *branches, size_t count)
+{
+	size_t max_fill = tree->page_max_fill;
+	size_t n_pages = (count + max_fill - 1) / max_fill;
+	size_t last_fill = count - (n_pages - 1) * max_fill;
+	size_t pos = 0;
+	for (size_t i = 0; i < n_pages; i++) {
+		size_t n = max_fill;
+		if (n_pages > 1 && last_fill < tree->page_min_fill) {
+			/* Share the branches of the last two pages */
+			if (i == n_pages - 2)
+				n = (max_fill + last_fill) / 2;
+			else if (i == n_pages - 1)
+				n = count - pos;
+		} else if (i == n_pages - 1) {
+			n = last_fill;
+		}
+		struct rtree_page *page = rtree_page_alloc(tree);
+		tree->n_pages++;
+		page->n = n;
+		memcpy(page->data, branches + pos * tree->page_branch_size,
+		       n * tree->page_branch_size);
+		pos += n;
+		/* The branches of the page are consumed, reuse them */
+		struct rtree_page_branch *b = (struct rtree_page_branch *)
+			(branches + i * tree->page_branch_size);
+		b->data.page = page;
+		rtree_branch_cover_page(tree, b, page);
+	}
+	assert(pos == count);
+	return n_pages;
+}
+
+void
+rtree_build(struct rtree *tree)
+{
+	assert(tree->root == NULL);
+	size_t count = tree->build_count;
+	if (count > 0) {
+		char *branches = tree->build_buf;
+		unsigned height = 0;
+		do {
+			rtree_str_sort(tree, branches, count, 0);
+			count = rtree_build_level(tree, branches, count);
+			height++;
+		} while (count > 1);
+		assert(height <= RTREE_MAX_HEIGHT);
+		tree->root = ((struct rtree_page_branch *)branches)->data.page;
+		tree->height = height;
+		tree->n_records = tree->build_count;
+		tree->version++;
+	}
+	free(tree->build_buf);
+	tree->build_buf = NULL;
+	tree->build_count = tree->build_capacity = 0;
+}
+
 bool
 rtree_remove(struct rtree *tree, const struct rtree_rect *rect, record_t obj)
 {
@@ -1021,9 +1593,12 @@ rtree_remove(struct rtree *tree, const struct rtree_rect *rect, record_t obj)
 		for (int i = 0, n = pg->n; i < n; i++) {
 			struct rtree_page_branch *b;
 			b = rtree_branch_get(tree, pg, i);
+			struct rtree_rect buf;
 			struct rtree_page *p =
 				rtree_page_insert(tree, tree->root,
-						  &b->rect, b->data.record,
+						  rtree_branch_rect(tree, b,
+								    &buf),
+						  b->data.record,
 						  tree->height - level);
 			if (p != NULL) {
 				/* root splitted */
@@ -1083,6 +1658,20 @@ rtree_search(const struct rtree *tree, const struct rtree_rect *rect,
 		break;
 	case SOP_OVERLAPS:
 		itr->intr_cmp = itr->leaf_cmp = rtree_rect_intersects_rect;
+		if (tree->coord_type == RTREE_COORD_FLOAT) {
+			/*
+			 * A float rectangle certainly overlaps the
+			 * rectangle if it strictly overlaps the rectangle
+			 * shrunk to floats, since exact coordinates of a
+			 * record are less than a float step inside it.
+			 */
+			for (int i = tree->dimension; --i >= 0; ) {
+				itr->inner_rect.coords[2 * i] =
+					rtree_float_ceil(rect->coords[2 * i]);
+				itr->inner_rect.coords[2 * i + 1] =
+					rtree_float_floor(rect->coords[2 * i + 1]);
+			}
+		}
 		break;
 	case SOP_BELONGS:
 		itr->intr_cmp = rtree_rect_intersects_rect;
@@ -120,6 +120,20 @@ enum rtree_distance_type {
 	RTREE_MANHATTAN = 1 /* Manhattan distance, fabs(dx) + fabs(dy) */
 };
 
+/* Type of coordinates stored in tree pages */
+enum rtree_coord_type {
+	/* coord_t, rectangles are stored as is */
+	RTREE_COORD_DOUBLE = 0,
+	/* float, rectangles are rounded outwards, so the pages are
+	 * twice as wide, and records are re-checked with their exact
+	 * rectangles, see rtree_record_rect_t */
+	RTREE_COORD_FLOAT = 1
+};
+
+/* Type of function, returning the exact rectangle of a record */
+typedef void (*rtree_record_rect_t)(void *ctx, record_t record,
+				    struct rtree_rect *rect);
+
 /* Main rtree struct */
 struct rtree
 {
@@ -152,6 +166,18 @@ struct rtree
 	void *free_pages;
 	/* Distance type */
 	enum rtree_distance_type distance_type;
+	/* Type of coordinates in pages */
+	enum rtree_coord_type coord_type;
+	/* Exact rectangle of a record, for RTREE_COORD_FLOAT */
+	rtree_record_rect_t record_rect;
+	void *record_rect_ctx;
+	/* Rectangles of a page being split, for RTREE_COORD_FLOAT */
+	struct rtree_rect *split_rects;
+	/* Records added by rtree_build_add() for bulk loading, packed
+	 * as page branches, and their number and capacity */
+	char *build_buf;
+	size_t build_count;
+	size_t build_capacity;
 };
 
 /* Struct for iteration and retrieving rtree values */
@@ -161,6 +187,9 @@ struct rtree_iterator
 	const struct rtree *tree;
 	/* Rectangle of current iteration operation */
 	struct rtree_rect rect;
+	/* The rectangle shrunk to floats, for SOP_OVERLAPS search in
+	 * a tree with RTREE_COORD_FLOAT */
+	struct rtree_rect inner_rect;
 	/* Type of current iteration operation */
 	enum spatial_search_op op;
 	/* Flag that means that no more values left */
@@ -239,6 +268,23 @@ rtree_init(struct rtree *tree, unsigned dimension, uint32_t extent_size,
 	   rtree_extent_alloc_t extent_alloc, rtree_extent_free_t extent_free,
 	   void *alloc_ctx, enum rtree_distance_type distance_type);
 
+/**
+ * @brief Set the type of coordinates stored in tree pages.
+ * Must be called before any record is added to the tree.
+ * With RTREE_COORD_FLOAT the tree takes about half the memory,
+ * but a record matched by its stored rectangle is re-checked
+ * against the exact one, returned by record_rect.
+ * @param tree - pointer to a tree
+ * @param coord_type - type of coordinates
+ * @param record_rect - function returning the exact rectangle of
+ *  a record, needed only for RTREE_COORD_FLOAT
+ * @param record_rect_ctx - argument passed to record_rect
+ * @return 0 on success, -1 on memory allocation error
+ */
+int
+rtree_set_coord_type(struct rtree *tree, enum rtree_coord_type coord_type,
+		     rtree_record_rect_t record_rect, void *record_rect_ctx);
+
 /**
  * @brief Destroy a tree
  * @param tree - pointer to a tree
@@ -275,6 +321,41 @@ rtree_search(const struct rtree *tree, const struct rtree_rect *rect,
 void
 rtree_insert(struct rtree *tree, struct rtree_rect *rect, record_t obj);
 
+/**
+ * @brief Reserve memory for bulk loading of a tree
+ * @param tree - pointer to a tree
+ * @param count - expected number of records
+ * @return 0 on success, -1 on memory allocation error
+ */
+int
+rtree_build_reserve(struct rtree *tree, size_t count);
+
+/**
+ * @brief Add a record to the bulk load of a tree. The record
+ * is not visible in the tree until rtree_build() is called.
+ * @param tree - pointer to a tree
+ * @param rect - rectangle of the record
+ * @param obj - record to add
+ * @return 0 on success, -1 on memory allocation error
+ */
+int
+rtree_build_add(struct rtree *tree, const struct rtree_rect *rect,
+		record_t obj);
+
+/**
+ * @brief Build a tree of all records added by rtree_build_add().
+ * The tree must be empty. Uses Sort-Tile-Recursive packing:
+ * records are sorted by the center of the first axis and cut into
+ * slabs, each slab is sorted by the next axis, and so on, and the
+ * result is cut into pages filled up to the maximum. The upper
+ * levels are built the same way from the pages of the level below.
+ * The resulting tree has less overlap and fewer pages than one
+ * built by insertion, and the build takes O(N log N).
+ * @param tree - pointer to a tree
+ */
+void
+rtree_build(struct rtree *tree);
+
 /**
  * @brief Remove the record from a tree
  * @return true if the record deleted (false otherwise)
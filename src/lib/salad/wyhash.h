@@ -0,0 +1,187 @@
+#ifndef TARANTOOL_WYHASH_H_INCLUDED
+#define TARANTOOL_WYHASH_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * wyhash: a fast 64-bit non-cryptographic hash function,
+ * Wang Yi, https://github.com/wangyi-fudan/wyhash (public domain).
+ *
+ * The hash is built around one 64x64->128 bit multiplication per
+ * 16 bytes of input, so it is several times faster than MurmurHash3
+ * on short keys and has good avalanche on sequential integers,
+ * which makes it a good fit for bloom filters. Values are defined
+ * in terms of little-endian loads and are the same on every
+ * platform, so they can be stored on disk.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+static const uint64_t wyhash_p0 = 0xa0761d6478bd642full;
+static const uint64_t wyhash_p1 = 0xe7037ed1a0b428dbull;
+static const uint64_t wyhash_p2 = 0x8ebc6af09c88c6e3ull;
+static const uint64_t wyhash_p3 = 0x589965cc75374cc3ull;
+
+/** 128-bit multiplication, *a and *b get the low and the high half. */
+static inline void
+wyhash_mum(uint64_t *a, uint64_t *b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t r = (__uint128_t) *a * *b;
+	*a = (uint64_t) r;
+	*b = (uint64_t) (r >> 64);
+#else
+	uint64_t ha = *a >> 32, hb = *b >> 32;
+	uint64_t la = (uint32_t) *a, lb = (uint32_t) *b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+	*a = lo;
+	*b = hi;
+#endif
+}
+
+static inline uint64_t
+wyhash_mix(uint64_t a, uint64_t b)
+{
+	wyhash_mum(&a, &b);
+	return a ^ b;
+}
+
+static inline uint64_t
+wyhash_read8(const uint8_t *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	return v;
+}
+
+static inline uint64_t
+wyhash_read4(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap32(v);
+#endif
+	return v;
+}
+
+/** Read 1-3 bytes. */
+static inline uint64_t
+wyhash_read3(const uint8_t *p, size_t k)
+{
+	return ((uint64_t) p[0] << 16) | ((uint64_t) p[k >> 1] << 8) |
+	       p[k - 1];
+}
+
+/**
+ * Hash @a len bytes at @a key. Feed the result of the previous
+ * call as @a seed to hash a sequence of values.
+ */
+static inline uint64_t
+wyhash(const void *key, size_t len, uint64_t seed)
+{
+	const uint8_t *p = (const uint8_t *) key;
+	uint64_t a, b;
+	seed ^= wyhash_mix(seed ^ wyhash_p0, wyhash_p1);
+	if (len <= 16) {
+		if (len >= 4) {
+			size_t off = (len >> 3) << 2;
+			a = (wyhash_read4(p) << 32) | wyhash_read4(p + off);
+			b = (wyhash_read4(p + len - 4) << 32) |
+			    wyhash_read4(p + len - 4 - off);
+		} else if (len > 0) {
+			a = wyhash_read3(p, len);
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t i = len;
+		if (i > 48) {
+			uint64_t see1 = seed, see2 = seed;
+			do {
+				seed = wyhash_mix(wyhash_read8(p) ^ wyhash_p1,
+						  wyhash_read8(p + 8) ^ seed);
+				see1 = wyhash_mix(wyhash_read8(p + 16) ^
+						  wyhash_p2,
+						  wyhash_read8(p + 24) ^ see1);
+				see2 = wyhash_mix(wyhash_read8(p + 32) ^
+						  wyhash_p3,
+						  wyhash_read8(p + 40) ^ see2);
+				p += 48;
+				i -= 48;
+			} while (i > 48);
+			seed ^= see1 ^ see2;
+		}
+		while (i > 16) {
+			seed = wyhash_mix(wyhash_read8(p) ^ wyhash_p1,
+					  wyhash_read8(p + 8) ^ seed);
+			i -= 16;
+			p += 16;
+		}
+		a = wyhash_read8(p + i - 16);
+		b = wyhash_read8(p + i - 8);
+	}
+	a ^= wyhash_p1;
+	b ^= seed;
+	wyhash_mum(&a, &b);
+	return wyhash_mix(a ^ wyhash_p0 ^ len, b ^ wyhash_p1);
+}
+
+/** Hash a 64-bit integer, cheaper than wyhash() over its bytes. */
+static inline uint64_t
+wyhash_u64(uint64_t val, uint64_t seed)
+{
+	uint64_t a = val ^ wyhash_p0;
+	uint64_t b = seed ^ wyhash_p1;
+	wyhash_mum(&a, &b);
+	return wyhash_mix(a ^ wyhash_p0, b ^ wyhash_p1);
+}
+
+#if defined(__cplusplus)
+} /* extern "C" */
+#endif /* defined(__cplusplus) */
+
+#endif /* TARANTOOL_WYHASH_H_INCLUDED */
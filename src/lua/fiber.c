@@ -225,6 +225,9 @@ lbox_fiber_statof(struct fiber *f, void *cb_ctx)
 	lua_pushnumber(L, region_total(&f->gc) + f->coro.stack_size +
 		       sizeof(struct fiber));
 	lua_settable(L, -3);
+	lua_pushstring(L, "stack");
+	lua_pushnumber(L, f->coro.stack_size);
+	lua_settable(L, -3);
 	lua_settable(L, -3);
 
 #ifdef ENABLE_BACKTRACE
@@ -257,6 +260,71 @@ lbox_fiber_info(struct lua_State *L)
 	return 1;
 }
 
+/**
+ * Return statistics of the fiber stacks of this cord: the
+ * stack size of new fibers, the number of cached dead fibers
+ * and how much of their stacks was given back to the OS.
+ */
+static int
+lbox_fiber_stack_info(struct lua_State *L)
+{
+	struct cord *cord = cord();
+	lua_newtable(L);
+	lua_pushstring(L, "size");
+	lua_pushnumber(L, fiber_stack_size());
+	lua_settable(L, -3);
+	lua_pushstring(L, "cached");
+	lua_pushnumber(L, cord->dead_count);
+	lua_settable(L, -3);
+	lua_pushstring(L, "cached_watermark");
+	lua_pushnumber(L, FIBER_DEAD_WATERMARK);
+	lua_settable(L, -3);
+	lua_pushstring(L, "reclaim_count");
+	luaL_pushuint64(L, cord->stack_reclaim_count);
+	lua_settable(L, -3);
+	lua_pushstring(L, "reclaimed");
+	luaL_pushuint64(L, cord->stack_reclaimed);
+	lua_settable(L, -3);
+	lua_pushstring(L, "guarded");
+	lua_pushnumber(L, tarantool_coro_guard_count());
+	lua_settable(L, -3);
+	return 1;
+}
+
+/**
+ * Check or enable/disable the guard page of new fiber stacks.
+ */
+static int
+lbox_fiber_stack_guard(struct lua_State *L)
+{
+	if (lua_gettop(L) > 0) {
+		if (! lua_isboolean(L, 1))
+			luaL_error(L, "fiber.stack_guard(enable): "
+				   "enable must be a boolean");
+		fiber_set_stack_guard(lua_toboolean(L, 1));
+	}
+	lua_pushboolean(L, fiber_stack_guard());
+	return 1;
+}
+
+/**
+ * Get or set the stack size of new fibers.
+ */
+static int
+lbox_fiber_stack_size(struct lua_State *L)
+{
+	if (lua_gettop(L) > 0) {
+		if (! lua_isnumber(L, 1) ||
+		    lua_tonumber(L, 1) < FIBER_STACK_SIZE_MIN)
+			luaL_error(L, "fiber.stack_size(size): size must be "
+				   "a number not less than %d",
+				   FIBER_STACK_SIZE_MIN);
+		fiber_set_stack_size(lua_tonumber(L, 1));
+	}
+	lua_pushnumber(L, fiber_stack_size());
+	return 1;
+}
+
 static int
 lua_fiber_run_f(va_list ap)
 {
@@ -526,6 +594,9 @@ static const struct luaL_reg lbox_fiber_meta [] = {
 
 static const struct luaL_reg fiberlib[] = {
 	{"info", lbox_fiber_info},
+	{"stack_info", lbox_fiber_stack_info},
+	{"stack_size", lbox_fiber_stack_size},
+	{"stack_guard", lbox_fiber_stack_guard},
 	{"sleep", lbox_fiber_sleep},
 	{"yield", lbox_fiber_yield},
 	{"self", lbox_fiber_self},
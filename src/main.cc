@@ -441,6 +441,10 @@ load_cfg()
 	if (background)
 		daemonize();
 
+	/* The writer thread wouldn't survive daemonize(). */
+	if (cfg_geti("log_async"))
+		say_logger_async_start();
+
 	/*
 	 * after (optional) daemonising to avoid confusing messages with
 	 * different pids
@@ -501,6 +505,7 @@ tarantool_free(void)
 	symbols_free();
 #endif
 	cbus_free();
+	say_logger_free();
 #if 0
 	/*
 	 * This doesn't work reliably since things
@@ -41,8 +41,10 @@
 #include <sys/param.h>
 #endif
 #include <syslog.h>
+#include <sys/uio.h>
 
 #include "fiber.h"
+#include "tt_pthread.h"
 
 pid_t log_pid = 0;
 int log_level = S_INFO;
@@ -58,6 +60,67 @@ static int logger_nonblock;
 static int log_fd = STDERR_FILENO;
 static char *log_path; /* iff logger_type == SAY_LOGGER_FILE */
 
+/*
+ * Asynchronous logging.
+ *
+ * Every thread appends formatted records to its own ring
+ * buffer, without taking locks or making system calls, and
+ * a dedicated writer thread drains all rings with writev().
+ * A record which doesn't fit into the ring is dropped and
+ * accounted, the writer reports drops to the log.
+ */
+enum {
+	/** Size of a per-thread ring, must be a power of 2. */
+	SAY_RING_SIZE = 64 * 1024,
+	/** Max number of iovecs in a single writev() of the writer. */
+	SAY_WRITER_IOVMAX = 64,
+};
+
+/** The writer wakes up at least this often, in nanoseconds. */
+static const long SAY_WRITER_PERIOD = 10 * 1000 * 1000;
+
+struct say_ring {
+	/** Producer position, advanced only by the owner thread. */
+	size_t head;
+	/** Consumer position, advanced only by the writer. */
+	size_t tail;
+	/** Number of records dropped due to the ring overflow. */
+	size_t dropped;
+	/** Number of dropped records reported by the writer. */
+	size_t dropped_reported;
+	/** Set when the owner thread exits. */
+	bool is_orphan;
+	/** Next ring in the list of all rings. */
+	struct say_ring *next;
+	char buf[SAY_RING_SIZE];
+};
+
+/** True if log records are written by the writer thread. */
+static bool logger_async;
+/** List of rings of all threads which ever logged anything. */
+static struct say_ring *say_rings;
+/**
+ * Number of records dropped by the rings which have been
+ * freed, protected by say_writer_mutex.
+ */
+static size_t say_rings_dropped;
+/** The current thread's ring. */
+static __thread struct say_ring *say_ring;
+/** Marks the ring orphaned on thread exit. */
+static pthread_key_t say_ring_key;
+static pthread_t say_writer_thread;
+static bool say_writer_stop;
+/** Serializes draining of the rings. */
+static pthread_mutex_t say_writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t say_writer_cond = PTHREAD_COND_INITIALIZER;
+
+/** Per-thread cache of the timestamp prefix down to seconds. */
+static __thread struct {
+	time_t seconds;
+	int len;
+	char buf[32];
+} say_time_cache;
+
 static void
 sayf(int level, const char *filename, int line, const char *error,
      const char *format, ...);
@@ -110,6 +173,264 @@ level_to_syslog_priority(int level)
 	}
 }
 
+/**
+ * Print the timestamp and pid log line prefix, e.g.
+ * 2012-08-07 18:30:00.634 [1234]
+ */
+static int
+say_format_time(char *buf, int len)
+{
+	/* Don't use ev_now() since it requires a working event loop. */
+	ev_tstamp now = ev_time();
+	time_t now_seconds = (time_t) now;
+	if (now_seconds != say_time_cache.seconds ||
+	    say_time_cache.len == 0) {
+		struct tm tm;
+		localtime_r(&now_seconds, &tm);
+		say_time_cache.len = strftime(say_time_cache.buf,
+					      sizeof(say_time_cache.buf),
+					      "%F %H:%M:%S", &tm);
+		say_time_cache.seconds = now_seconds;
+	}
+	return snprintf(buf, len, "%.*s.%03d [%i]", say_time_cache.len,
+			say_time_cache.buf,
+			(int) ((now - now_seconds) * 1000), getpid());
+}
+
+static void
+say_ring_orphan(void *arg)
+{
+	struct say_ring *ring = (struct say_ring *) arg;
+	__atomic_store_n(&ring->is_orphan, true, __ATOMIC_RELEASE);
+}
+
+/**
+ * Get the current thread's ring, allocate and register it on
+ * the first use. Registration is lock-free, so that a thread
+ * never waits for the writer.
+ */
+static struct say_ring *
+say_ring_get(void)
+{
+	if (say_ring != NULL)
+		return say_ring;
+	struct say_ring *ring = (struct say_ring *) calloc(1, sizeof(*ring));
+	if (ring == NULL)
+		return NULL;
+	ring->next = __atomic_load_n(&say_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&say_rings, &ring->next, ring,
+					    true, __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED));
+	pthread_setspecific(say_ring_key, ring);
+	say_ring = ring;
+	return ring;
+}
+
+/**
+ * Append a formatted record to the current thread's ring.
+ * @retval -1 no memory for the ring, the caller must write
+ *            the record itself
+ * @retval  0 the record is queued or dropped
+ */
+static int
+say_ring_append(const char *buf, size_t len)
+{
+	struct say_ring *ring = say_ring_get();
+	if (ring == NULL)
+		return -1;
+	size_t head = ring->head;
+	size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (head - tail + len > SAY_RING_SIZE) {
+		__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	size_t offset = head & (SAY_RING_SIZE - 1);
+	size_t first = MIN(len, SAY_RING_SIZE - offset);
+	memcpy(ring->buf + offset, buf, first);
+	memcpy(ring->buf, buf + first, len - first);
+	__atomic_store_n(&ring->head, head + len, __ATOMIC_RELEASE);
+	/* Don't wait for the writer timer if the ring fills up. */
+	if (head - tail + len > SAY_RING_SIZE / 2)
+		pthread_cond_signal(&say_writer_cond);
+	return 0;
+}
+
+/**
+ * Write out records accumulated in the rings with a single
+ * writev(), report dropped records and free rings of exited
+ * threads. Must be called with say_writer_mutex locked.
+ * @return the number of bytes written or -1 on error
+ */
+static ssize_t
+say_rings_flush(void)
+{
+	struct iovec iov[SAY_WRITER_IOVMAX];
+	struct say_ring *rings[SAY_WRITER_IOVMAX];
+	size_t sizes[SAY_WRITER_IOVMAX];
+	int iovcnt = 0, ring_count = 0;
+	char msg[PIPE_BUF];
+	size_t dropped = 0;
+
+	struct say_ring *ring = __atomic_load_n(&say_rings, __ATOMIC_ACQUIRE);
+	for (; ring != NULL; ring = ring->next) {
+		size_t d = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+		dropped += d - ring->dropped_reported;
+		ring->dropped_reported = d;
+	}
+	if (dropped > 0) {
+		int len = say_format_time(msg, sizeof(msg));
+		len += snprintf(msg + len, sizeof(msg) - len,
+				" W> %zu log records dropped\n", dropped);
+		iov[iovcnt].iov_base = msg;
+		iov[iovcnt].iov_len = len;
+		iovcnt++;
+	}
+	ring = __atomic_load_n(&say_rings, __ATOMIC_ACQUIRE);
+	for (; ring != NULL && iovcnt < SAY_WRITER_IOVMAX - 1;
+	     ring = ring->next) {
+		size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		size_t size = head - ring->tail;
+		if (size == 0)
+			continue;
+		size_t offset = ring->tail & (SAY_RING_SIZE - 1);
+		size_t first = MIN(size, SAY_RING_SIZE - offset);
+		iov[iovcnt].iov_base = ring->buf + offset;
+		iov[iovcnt].iov_len = first;
+		iovcnt++;
+		if (size > first) {
+			iov[iovcnt].iov_base = ring->buf;
+			iov[iovcnt].iov_len = size - first;
+			iovcnt++;
+		}
+		rings[ring_count] = ring;
+		sizes[ring_count] = size;
+		ring_count++;
+	}
+	if (iovcnt == 0)
+		return 0;
+	ssize_t written = writev(log_fd, iov, iovcnt);
+	if (written < 0)
+		return -1;
+	/* Consume what has been written, possibly partially. */
+	size_t left = written;
+	if (dropped > 0)
+		left -= MIN(left, iov[0].iov_len);
+	for (int i = 0; i < ring_count && left > 0; i++) {
+		size_t n = MIN(left, sizes[i]);
+		__atomic_store_n(&rings[i]->tail, rings[i]->tail + n,
+				 __ATOMIC_RELEASE);
+		left -= n;
+	}
+	/*
+	 * Free drained rings of exited threads. The list head
+	 * may be concurrently replaced by a new thread, so it
+	 * is never unlinked.
+	 */
+	struct say_ring *prev = __atomic_load_n(&say_rings, __ATOMIC_ACQUIRE);
+	while (prev != NULL && (ring = prev->next) != NULL) {
+		if (__atomic_load_n(&ring->is_orphan, __ATOMIC_ACQUIRE) &&
+		    ring->head == ring->tail &&
+		    ring->dropped == ring->dropped_reported) {
+			prev->next = ring->next;
+			say_rings_dropped += ring->dropped;
+			free(ring);
+		} else {
+			prev = ring;
+		}
+	}
+	return written;
+}
+
+/**
+ * Synchronously write out all queued records.
+ */
+static void
+say_rings_flush_all(void)
+{
+	pthread_mutex_lock(&say_writer_mutex);
+	while (say_rings_flush() > 0);
+	pthread_mutex_unlock(&say_writer_mutex);
+}
+
+static void *
+say_writer_f(void *arg)
+{
+	(void) arg;
+	/* The writer must never log itself: it'd deadlock. */
+	pthread_mutex_lock(&say_writer_mutex);
+	while (!say_writer_stop) {
+		if (say_rings_flush() > 0)
+			continue;
+		struct timespec timeout;
+		clock_gettime(CLOCK_REALTIME, &timeout);
+		timeout.tv_nsec += SAY_WRITER_PERIOD;
+		if (timeout.tv_nsec >= 1000000000) {
+			timeout.tv_sec++;
+			timeout.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&say_writer_cond, &say_writer_mutex,
+				       &timeout);
+	}
+	pthread_mutex_unlock(&say_writer_mutex);
+	return NULL;
+}
+
+/**
+ * Only the calling thread survives fork(), so the child has
+ * no writer and must log synchronously.
+ */
+static void
+say_atfork_child(void)
+{
+	logger_async = false;
+	say_time_cache.len = 0;
+}
+
+void
+say_logger_async_start(void)
+{
+	if (logger_async || logger_type == SAY_LOGGER_SYSLOG)
+		return;
+	tt_pthread_key_create(&say_ring_key, say_ring_orphan);
+	tt_pthread_atfork(NULL, NULL, say_atfork_child);
+	say_writer_stop = false;
+	tt_pthread_create(&say_writer_thread, NULL, say_writer_f, NULL);
+	logger_async = true;
+}
+
+bool
+say_logger_is_async(void)
+{
+	return logger_async;
+}
+
+size_t
+say_logger_dropped(void)
+{
+	/* Rings of exited threads are freed under the mutex. */
+	pthread_mutex_lock(&say_writer_mutex);
+	size_t dropped = say_rings_dropped;
+	struct say_ring *ring = __atomic_load_n(&say_rings, __ATOMIC_ACQUIRE);
+	for (; ring != NULL; ring = ring->next)
+		dropped += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+	pthread_mutex_unlock(&say_writer_mutex);
+	return dropped;
+}
+
+void
+say_logger_free(void)
+{
+	if (!logger_async)
+		return;
+	logger_async = false;
+	pthread_mutex_lock(&say_writer_mutex);
+	say_writer_stop = true;
+	pthread_cond_signal(&say_writer_cond);
+	pthread_mutex_unlock(&say_writer_mutex);
+	tt_pthread_join(say_writer_thread, NULL);
+	say_rings_flush_all();
+}
+
 void
 say_set_log_level(int new_level)
 {
@@ -348,19 +669,8 @@ vsay(int level, const char *filename, int line, const char *error,
 		if (*f == '/' && *(f + 1) != '\0')
 			filename = f + 1;
 
-	if (logger_type != SAY_LOGGER_SYSLOG) {
-		/* Don't use ev_now() since it requires a working event loop. */
-		ev_tstamp now = ev_time();
-		time_t now_seconds = (time_t) now;
-		struct tm tm;
-		localtime_r(&now_seconds, &tm);
-
-		/* Print time in format 2012-08-07 18:30:00.634 */
-		p += strftime(buf + p, len - p, "%F %H:%M", &tm);
-		p += snprintf(buf + p, len - p, ":%06.3f",
-				now - now_seconds + tm.tm_sec);
-		p += snprintf(buf + p, len - p, " [%i]", getpid());
-	}
+	if (logger_type != SAY_LOGGER_SYSLOG)
+		p += say_format_time(buf + p, len - p);
 
 	struct cord *cord = cord();
 	if (cord) {
@@ -385,8 +695,13 @@ vsay(int level, const char *filename, int line, const char *error,
 		if (p >= len - 1)
 			p = len - 1;
 		*(buf + p) = '\n';
-		int r = write(log_fd, buf, p + 1);
-		(void)r;
+		if (!logger_async || say_ring_append(buf, p + 1) != 0) {
+			int r = write(log_fd, buf, p + 1);
+			(void)r;
+		} else if (level == S_FATAL) {
+			/* The process is about to exit. */
+			say_rings_flush_all();
+		}
 	} else {
 		/*
 		 * Due to omitted timestamp we have a leading
@@ -76,6 +76,27 @@ say_logrotate(int /* signo */);
 void say_logger_init(const char *init_str,
                      int log_level, int nonblock, int background);
 
+/**
+ * Switch the logger to the asynchronous mode: log records are
+ * queued in per-thread rings and written by a separate thread,
+ * so that no thread blocks on log I/O. Records which don't fit
+ * into a ring are dropped. Must be called after daemonizing.
+ */
+void
+say_logger_async_start(void);
+
+/** True if the logger works in the asynchronous mode. */
+bool
+say_logger_is_async(void);
+
+/** Total number of log records dropped in the asynchronous mode. */
+size_t
+say_logger_dropped(void);
+
+/** Stop the log writer thread and write out queued records. */
+void
+say_logger_free(void);
+
 CFORMAT(printf, 5, 0) void
 vsay(int level, const char *filename, int line, const char *error,
      const char *format, va_list ap);
@@ -388,6 +388,27 @@ fiber.sleep(0.01)
 
 box.space.test2066:drop()
 
+--
+-- Fiber stack size and reclamation of idle fiber stacks
+--
+fiber.stack_size()
+fiber.stack_size(100)
+fiber.stack_size(128 * 1024)
+f = fiber.create(function() fiber.sleep(60) end)
+fiber.info()[f:id()].memory.stack > 64 * 1024
+f:cancel()
+reclaim_count = fiber.stack_info().reclaim_count
+for i = 1, 300 do fiber.create(function() fiber.sleep(0.01) end) end
+fiber.sleep(0.1)
+fiber.stack_info().cached >= 300
+fiber.stack_info().reclaim_count - reclaim_count >= 300 - fiber.stack_info().cached_watermark
+fiber.stack_info().reclaimed > 0
+fiber.stack_size(65536)
+fiber.stack_guard()
+fiber.stack_guard(1)
+fiber.stack_info().guarded > 0
+fiber.stack_guard(false)
+fiber.stack_guard(true)
 fiber = nil
 
 test_run:cmd("clear filter")
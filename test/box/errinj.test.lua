@@ -190,6 +190,14 @@ errinj.set("ERRINJ_WAL_WRITE", false)
 errinj.set("ERRINJ_WAL_WRITE_DISK", true)
 _ = space:insert{1, require'digest'.urandom(192 * 1024)}
 errinj.set("ERRINJ_WAL_WRITE_DISK", false)
+
+-- an update applied in place is undone if the WAL write fails
+_ = space:insert{2, 10, 'abc'}
+_ = collectgarbage('collect')
+errinj.set("ERRINJ_WAL_WRITE", true)
+space:update(2, {{'+', 2, 1}, {'=', 3, 'xyz'}})
+errinj.set("ERRINJ_WAL_WRITE", false)
+space:get(2)
 space:drop()
 
 errinj = nil
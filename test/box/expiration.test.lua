@@ -0,0 +1,38 @@
+fiber = require('fiber')
+
+-- ttl_field is supported by memtx only
+s = box.schema.space.create('test', {engine = 'vinyl', ttl_field = 2})
+s = box.schema.space.create('test', {ttl_field = -1})
+
+s = box.schema.space.create('test', {ttl_field = 2})
+s.index.expire
+_ = s:create_index('pk')
+s.index.expire.id
+s.index.expire.parts
+
+now = math.floor(fiber.time())
+for i = 1, 250 do s:insert{i, now - 100} end
+for i = 251, 260 do s:insert{i, now + 3600} end
+box.info.expiration().backlog >= 250
+while s:count() > 10 do fiber.sleep(0.01) end
+s:count()
+s.index.pk:min()[1]
+box.info.expiration().backlog
+box.info.expiration().expired >= 250
+
+-- rate limit
+box.cfg{expiration_rate_limit = -1}
+box.cfg{expiration_rate_limit = 100}
+box.info.expiration().rate_limit
+for i = 1, 10 do s:insert{i, now - 100.5} end
+while s:count() > 10 do fiber.sleep(0.01) end
+s:count()
+box.cfg{expiration_rate_limit = 0}
+
+-- a dropped expire index disables expiration
+s.index.expire:drop()
+s:insert{1, 0}
+fiber.sleep(1.5)
+s:get{1}
+
+s:drop()
@@ -15,3 +15,6 @@ t = {}
 for k, _ in pairs(box.info()) do table.insert(t, k) end
 table.sort(t)
 t
+-- the logger is synchronous by default and never drops records
+box.info.log().async
+box.info.log().dropped
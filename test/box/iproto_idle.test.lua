@@ -0,0 +1,63 @@
+socket = require('socket')
+msgpack = require('msgpack')
+uri = require('uri')
+fiber = require('fiber')
+
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+
+--
+-- Idle connections must not hold input and output buffers:
+-- they are taken from a shared cache only while there is
+-- data in flight.
+--
+test_run = require('test_run').new()
+test_run:cmd("setopt delimiter ';'")
+function iobuf_used()
+    -- buffers are returned to the cache by net thread
+    for i = 1, 100 do
+        if box.stat.net.IOBUF.used == 0 then break end
+        fiber.sleep(0.01)
+    end
+    return box.stat.net.IOBUF.used
+end;
+function ping(s, sync)
+    -- IPROTO_PING
+    local header = msgpack.encode({[0x00] = 64, [0x01] = sync})
+    s:write(msgpack.encode(#header) .. header)
+    local len = msgpack.decode(s:read(5))
+    local reply = msgpack.decode(s:read(len))
+    return reply[0x00]
+end;
+function connect()
+    local u = uri.parse(box.cfg.listen)
+    local s = socket.tcp_connect(u.host or 'unix/', u.service)
+    -- greeting
+    assert(#s:read(128) == 128)
+    return s
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- warm up
+s = connect()
+ping(s, 1)
+s:close()
+collectgarbage('collect')
+
+N = 300
+connections = {}
+for i = 1, N do connections[i] = connect() end
+for i = 1, N do assert(ping(connections[i], i) == 0) end
+
+-- each connection used to keep two buffers after a request
+iobuf_used()
+box.stat.net.IOBUF.cached <= 64
+
+-- the connections are still usable
+ping(connections[1], 1)
+ping(connections[N], N)
+iobuf_used()
+
+for i = 1, N do connections[i]:close() end
+connections = nil
+
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
@@ -0,0 +1,103 @@
+#include "module.h"
+
+#include <sys/time.h>
+
+#include <msgpuck.h>
+
+enum { BATCH_SIZE = 64 };
+
+static double
+proctime(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (double) tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+/* Full scan fetching a tuple per box_iterator_next() call. */
+static int
+scan(uint32_t space_id, uint32_t index_id, uint64_t *count)
+{
+	char key[1];
+	char *key_end = mp_encode_array(key, 0);
+	box_iterator_t *it = box_index_iterator(space_id, index_id, ITER_ALL,
+						key, key_end);
+	if (it == NULL)
+		return -1;
+	box_tuple_t *tuple;
+	*count = 0;
+	while (box_iterator_next(it, &tuple) == 0 && tuple != NULL)
+		++*count;
+	box_iterator_free(it);
+	return 0;
+}
+
+/* Full scan fetching BATCH_SIZE tuples per call. */
+static int
+scan_batch(uint32_t space_id, uint32_t index_id, uint64_t *count)
+{
+	char key[1];
+	char *key_end = mp_encode_array(key, 0);
+	box_iterator_t *it = box_index_iterator(space_id, index_id, ITER_ALL,
+						key, key_end);
+	if (it == NULL)
+		return -1;
+	box_tuple_t *tuples[BATCH_SIZE];
+	*count = 0;
+	int n;
+	while ((n = box_iterator_next_batch(it, tuples, BATCH_SIZE)) > 0) {
+		for (int i = 0; i < n; i++)
+			box_tuple_unref(tuples[i]);
+		*count += n;
+	}
+	box_iterator_free(it);
+	return n;
+}
+
+/*
+ * Scan the tester space with both iterator APIs and return
+ * the number of tuples seen by each of them. Timings go to
+ * the log.
+ */
+int
+iterator_bench(box_function_ctx_t *ctx, const char *args, const char *args_end)
+{
+	static const char *SPACE_NAME = "tester";
+	static const char *INDEX_NAME = "primary";
+
+	uint32_t space_id = box_space_id_by_name(SPACE_NAME, strlen(SPACE_NAME));
+	uint32_t index_id = box_index_id_by_name(space_id, INDEX_NAME,
+		strlen(INDEX_NAME));
+
+	if (space_id == BOX_ID_NIL || index_id == BOX_ID_NIL) {
+		return box_error_set(__FILE__, __LINE__, ER_PROC_C,
+			"Can't find index %s in space %s",
+			INDEX_NAME, SPACE_NAME);
+	}
+	(void) args;
+	(void) args_end;
+
+	uint64_t count, count_batch;
+	double t = proctime();
+	if (scan(space_id, index_id, &count) != 0)
+		return -1;
+	t = proctime() - t;
+	say_info("box_iterator_next: %lf", t);
+
+	t = proctime();
+	if (scan_batch(space_id, index_id, &count_batch) != 0)
+		return -1;
+	t = proctime() - t;
+	say_info("box_iterator_next_batch: %lf", t);
+
+	char tuple_buf[32];
+	char *d = tuple_buf;
+	d = mp_encode_array(d, 2);
+	d = mp_encode_uint(d, count);
+	d = mp_encode_uint(d, count_batch);
+	box_tuple_format_t *fmt = box_tuple_format_default();
+	box_tuple_t *tuple = box_tuple_new(fmt, tuple_buf, d);
+	if (tuple == NULL)
+		return -1;
+	return box_return_tuple(ctx, tuple);
+}
@@ -0,0 +1,55 @@
+package.cpath = '../box/?.so;../box/?.dylib;'..package.cpath
+
+net = require('net.box')
+clock = require('clock')
+log = require('log')
+
+c = net:new(os.getenv("LISTEN"))
+
+box.schema.func.create('iterator_bench', {language = "C"})
+box.schema.user.grant('guest', 'execute', 'function', 'iterator_bench')
+space = box.schema.space.create('tester')
+_ = space:create_index('primary', {type = 'TREE', parts = {1, 'unsigned'}})
+
+box.begin() for i = 1, 100000 do space:insert{i, 'tuple ' .. i} end box.commit()
+
+-- C API: box_iterator_next() vs box_iterator_next_batch()
+c:call('iterator_bench')
+
+-- Lua: chunked index:pairs() vs per-tuple index:pairs() and pairs_luac()
+function scan(method, opts) local t = clock.monotonic() local cnt = 0 local sum = 0 for _, tuple in space.index.primary[method](space.index.primary, nil, opts) do cnt = cnt + 1 sum = sum + tuple[1] end log.info('%s%s: %f', method, opts and ' prefetch' or '', clock.monotonic() - t) return cnt, sum end
+scan('pairs', {prefetch = true})
+scan('pairs')
+scan('pairs_luac')
+
+-- tuples outlive the chunk they were fetched in
+t = {} for _, tuple in space:pairs({100}, {iterator = 'LE', prefetch = true}) do table.insert(t, tuple) end
+#t
+collectgarbage('collect')
+t[1], t[50], t[64], t[65], t[100]
+space:truncate()
+collectgarbage('collect')
+t[1], t[100]
+t = nil
+
+-- abandoned iteration releases the prefetched tail of a chunk
+space:insert{1, 'a'}
+space:insert{2, 'b'}
+space:insert{3, 'c'}
+for _, tuple in space:pairs(nil, {prefetch = true}) do if tuple[1] == 2 then break end end
+collectgarbage('collect')
+space:select{}
+gen, param, state = space:pairs(nil, {prefetch = true})
+tostring(state)
+gen, param, state = nil
+collectgarbage('collect')
+
+-- a prefetched chunk does not see later changes
+t = {} for _, tuple in space:pairs(nil, {prefetch = true}) do if tuple[1] == 1 then space:replace{2, 'x'} space:delete{3} end table.insert(t, tuple) end
+t
+space:select{}
+t = nil
+
+box.schema.func.drop("iterator_bench")
+
+space:drop()
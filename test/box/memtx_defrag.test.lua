@@ -0,0 +1,61 @@
+--
+-- Defragmentation of memtx tuple slabs.
+--
+box.cfg.memtx_defrag_threshold
+box.cfg{memtx_defrag_threshold = 2}
+box.cfg{memtx_defrag_threshold = -1}
+fiber = require('fiber')
+
+-- A pass over small spaces frees nothing, and the job must not
+-- keep the tx thread busy retrying it.
+small = box.schema.space.create('small')
+_ = small:create_index('primary')
+for i = 1, 100 do small:insert{i, string.rep('x', 100)} end
+for i = 1, 100 do if i % 2 == 0 then small:delete{i} end end
+box.cfg{memtx_defrag_threshold = 0.99}
+_ = box.slab.defrag()
+runs = box.slab.defrag_info().runs
+fiber.sleep(0.1)
+box.slab.defrag_info().runs - runs < 10
+box.cfg{memtx_defrag_threshold = 0}
+small:drop()
+
+s = box.schema.space.create('test')
+_ = s:create_index('primary')
+_ = s:create_index('secondary', {parts = {2, 'unsigned'}, unique = false})
+pad = string.rep('x', 200)
+box.begin() for i = 1, 100000 do s:insert{i, i % 100, pad} end box.commit()
+-- Leave one tuple of ten, spread over all slabs.
+box.begin() for i = 1, 100000 do if i % 10 ~= 0 then s:delete{i} end end box.commit()
+size = box.slab.info().items_size
+
+res = box.slab.defrag()
+res.moved > 0
+res.reclaimed > 0
+box.slab.info().items_size < size
+
+-- The indexes reference the moved tuples.
+s:count()
+s.index.secondary:count(50)
+s:get{10}[2]
+s:get{100000}[3] == pad
+s:select({10}, {limit = 3, iterator = 'GE'})[3][1]
+#s.index.secondary:select(10)
+
+-- Tuples referenced from Lua are not moved.
+t = s:get{10}
+_ = box.slab.defrag()
+s:get{10} == t
+t = nil
+
+info = box.slab.defrag_info()
+info.running
+info.runs >= 2
+info.moved >= res.moved
+info.reclaimed >= res.reclaimed
+
+-- Writes after defragmentation.
+s:update({10}, {{'=', 3, 'y'}})
+s:delete{20}[1]
+s:count()
+s:drop()
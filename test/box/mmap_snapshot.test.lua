@@ -0,0 +1,55 @@
+test_run = require('test_run').new()
+
+--
+-- Spaces with mmap_snapshot = true are recovered from a memory
+-- mapped snapshot image written by the last checkpoint.
+--
+s = box.schema.space.create('test', {mmap_snapshot = true})
+_ = s:create_index('primary')
+_ = s:create_index('secondary', {parts = {2, 'string'}})
+for i = 1, 1000 do s:insert{i, 'v' .. i, string.rep('x', i % 50)} end
+box.snapshot()
+
+test_run:cmd("restart server default")
+
+test_run:grep_log('default', "recovering space 'test' from") ~= nil
+s = box.space.test
+s:count()
+s:get(1)
+s:get(1000)
+s.index.secondary:get('v500')
+s:bsize() > 0
+
+-- Writes to the mapped tuples copy them to the arena.
+s:update(1, {{'=', 2, 'updated'}})
+s:delete(2)
+s:replace{1001, 'v1001'}
+s.index.secondary:get('updated')
+s:count()
+box.snapshot()
+
+test_run:cmd("restart server default")
+
+s = box.space.test
+s:count()
+s:get(1)
+s:get(2)
+s.index.secondary:get('v1001')
+
+-- Changes made after the checkpoint are replayed from the WAL.
+s:replace{1002, 'v1002'}
+test_run:cmd("restart server default")
+s = box.space.test
+s:count()
+s:get(1002)
+
+-- Images of dropped spaces are removed by gc.
+fio = require('fio')
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snapimg'))
+s:drop()
+box.snapshot()
+box.internal.gc(box.info.cluster.signature)
+#fio.glob(fio.pathjoin(box.cfg.memtx_dir, '*.snapimg'))
+
+-- Vinyl spaces do not support the option.
+box.schema.space.create('test', {engine = 'vinyl', mmap_snapshot = true})
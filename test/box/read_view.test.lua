@@ -0,0 +1,36 @@
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {unique = false, parts = {2, 'unsigned'}})
+for i = 1, 10 do s:insert{i, i % 3} end
+
+s:read_view_select()
+s:read_view_select({5}, {iterator = 'GE', limit = 3})
+s:read_view_select({5}, {iterator = 'LT', offset = 1, limit = 2})
+s.index.sk:read_view_select({1}, {iterator = 'GT'})
+s.index.sk:read_view_select({}, {iterator = 'LE', limit = 4})
+
+-- the same as an ordinary select
+#s:read_view_select({}, {iterator = 'GT'}) == #s:select({}, {iterator = 'GT'})
+s:read_view_select({}, {limit = 0})
+
+-- key comparisons are not done in the scan thread
+s:read_view_select({5})
+s:read_view_select({5}, {iterator = 'REQ'})
+s:read_view_select({5}, {iterator = 'BITS_ALL_SET'})
+
+-- read views nest with checkpoints
+box.snapshot()
+s:delete{1}
+s:read_view_select({}, {limit = 2})
+
+-- DDL waits until the scan is over
+fiber = require('fiber')
+res = nil
+f = fiber.create(function() res = s:read_view_select() end) s:drop() return #res
+box.space.test
+
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+s:read_view_select()
+s:drop()
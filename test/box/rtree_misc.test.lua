@@ -245,3 +245,44 @@ i:select({0, 0, 0}, {iterator = 'neighbor'})
 i:select({1, 2, 3, 4, 5, 6}, {iterator = 'BITS_ALL_SET' } )
 
 s:drop()
+
+-- an index over existing data is bulk loaded
+s = box.schema.space.create('spatial')
+_ = s:create_index('primary')
+for i = 1, 1000 do s:insert{i, {i % 40, math.floor(i / 40)}} end
+i = s:create_index('spatial', {type = 'rtree', unique = false, parts = {2, 'array'}})
+i:count()
+#i:select({0, 0, 9, 9}, {iterator = 'le'})
+i:select({20.2, 10.2}, {iterator = 'neighbor', limit = 1})
+s:insert{1001, {100, 100}}
+i:select({99, 99}, {iterator = 'neighbor', limit = 1})
+s:delete(1001)
+i:count()
+s:drop()
+
+-- float coordinates, matches are re-checked with tuples
+s = box.schema.space.create('spatial')
+_ = s:create_index('primary')
+s:create_index('float', {type = 'rtree', unique = false, parts = {2, 'array'}, coord_type = 'half'})
+f = s:create_index('float', {type = 'rtree', unique = false, parts = {2, 'array'}, coord_type = 'float'})
+d = s:create_index('double', {type = 'rtree', unique = false, parts = {2, 'array'}})
+s:insert{1, {1, 1}}
+s:insert{2, {1.0000000001, 1}}
+s:insert{3, {0.9999999999, 1}}
+f:select({1, 1})
+f:select({1.0000000001, 1})
+f:select({0, 0, 1, 1}, {iterator = 'le'})
+f:select({1, 1, 2, 2}, {iterator = 'le'})
+f:select({1, 1, 2, 2}, {iterator = 'lt'})
+f:select({0.99999999995, 0, 2, 2}, {iterator = 'overlaps'})
+f:select({1.00000000002, 1}, {iterator = 'neighbor'})
+f:select({1.00000000008, 1}, {iterator = 'neighbor'})
+for i = 4, 1000 do s:insert{i, {i % 40 + 0.1, math.floor(i / 40) + 0.1}} end
+f:bsize() < d:bsize()
+function ids(r) local t = {} for _, v in ipairs(r) do table.insert(t, v[1]) end return table.concat(t, ' ') end
+ids(f:select({10, 10, 20, 20}, {iterator = 'le'})) == ids(d:select({10, 10, 20, 20}, {iterator = 'le'}))
+ids(f:select({5.35, 5.23}, {iterator = 'neighbor', limit = 4}))
+ids(d:select({5.35, 5.23}, {iterator = 'neighbor', limit = 4}))
+f:alter{coord_type = 'double'}
+f:select({1.0000000001, 1})
+s:drop()
@@ -0,0 +1,36 @@
+box.stat.hot.reset()
+stat = box.stat.hot()
+next(stat.spaces), #stat.keys, #stat.functions
+
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10 do s:replace{i} end
+for i = 1, 10000 do s:select{1} end
+
+stat = box.stat.hot()
+stat.spaces[s.id].count > 5000
+stat.spaces[s.id].index[0].count > 5000
+stat.spaces[s.id].time > 0
+stat.keys[1].space_id == s.id
+stat.keys[1].index_id
+stat.keys[1].key
+#stat.keys <= 32
+
+-- stored procedures
+function hot_f() return true end
+box.schema.user.grant('guest', 'execute', 'universe')
+remote = require('net.box')
+LISTEN = require('uri').parse(box.cfg.listen)
+cn = remote.connect(LISTEN.host, LISTEN.service)
+for i = 1, 2000 do cn:call('hot_f') end
+stat = box.stat.hot()
+stat.functions[1].name
+stat.functions[1].count > 500
+cn:close()
+box.schema.user.revoke('guest', 'execute', 'universe')
+
+box.stat.hot.reset()
+stat = box.stat.hot()
+next(stat.spaces), #stat.keys, #stat.functions
+
+s:drop()
@@ -21,6 +21,18 @@ box.stat.net.RECEIVED.total > 0
 -- box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
+-- request queues of iproto admission classes
+box.stat.net.QUEUE_BULK
+box.stat.net().QUEUE_HIGH
+box.session.priority()
+cn:eval("return box.session.priority()")
+cn:eval("return box.stat.net.QUEUE_BULK.current")
+cn:eval("return box.session.priority('high')")
+cn:eval("return box.stat.net.QUEUE_HIGH.current")
+cn:eval("return box.stat.net.QUEUE_BULK.current")
+box.session.priority('urgent')
+box.stat.net.QUEUE_HIGH.current
+
 space:drop()
 cn:close()
 box.schema.user.revoke('guest','read,write,execute','universe')
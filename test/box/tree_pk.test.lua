@@ -191,3 +191,31 @@ utils.sort(s0.index['i2']:select(0))
 s0:drop()
 s0 = nil
 
+
+-- key prefix hints
+s0 = box.schema.space.create('tweedledum')
+i0 = s0:create_index('primary', { type = 'tree', parts = {1, 'integer'}, hint = true })
+i1 = s0:create_index('i1', { type = 'tree', parts = {2, 'string'}, hint = true })
+i2 = s0:create_index('i2', { type = 'tree', parts = {2, 'string'} })
+s0:insert{-1000000, 'abcdefgha'}
+s0:insert{-1, 'abcdefghb'}
+s0:insert{0, 'abcdefgh'}
+s0:insert{1, 'abc'}
+s0:insert{9223372036854775808ULL, 'abcdefghab'}
+s0:insert{18446744073709551615ULL, 'abcdefg'}
+i0:select()
+i0:select({0}, {iterator = 'LT'})
+i0:select({9223372036854775808ULL}, {iterator = 'GE'})
+i1:select()
+i1:select('abcdefgha')
+i1:select('abcdefgh', {iterator = 'GT'})
+i2:select('abcdefgh', {iterator = 'GT'})
+s0:delete{-1}
+i1:select('abcdefgh', {iterator = 'GT'})
+-- turning hints on or off rebuilds the index
+i2:alter({hint = true})
+i2:select('abcdefgh', {iterator = 'GT'})
+i1:alter({hint = false})
+i1:select('abc', {iterator = 'GE'})
+s0:drop()
+s0 = nil
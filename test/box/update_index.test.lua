@@ -0,0 +1,57 @@
+clock = require('clock')
+log = require('log')
+
+-- UPDATE of a space with many secondary indexes: indexes, which
+-- key parts are not touched by the update, are updated in place.
+s = box.schema.space.create('tweedledum')
+_ = s:create_index('pk')
+_ = s:create_index('tree_uniq', {parts = {2, 'unsigned'}})
+_ = s:create_index('tree_dup', {parts = {3, 'unsigned'}, unique = false})
+_ = s:create_index('tree_multi', {parts = {3, 'unsigned', 4, 'string'}, unique = false})
+_ = s:create_index('hash', {type = 'hash', parts = {5, 'string'}})
+_ = s:create_index('tree_str', {parts = {4, 'string'}, unique = false})
+_ = s:create_index('tree_counter', {parts = {7, 'unsigned'}, unique = false})
+
+box.begin() for i = 1, 1000 do s:insert{i, i, i % 10, 'k' .. (i % 3), 's' .. i, 0, 0} end box.commit()
+
+-- counter-style updates touching no indexed field
+t = clock.monotonic() for j = 1, 10 do for i = 1, 1000 do s:update(i, {{'+', 6, 1}}) end end log.info('update of a non-indexed field: %f', clock.monotonic() - t)
+-- updates changing one indexed field
+t = clock.monotonic() for j = 1, 10 do for i = 1, 1000 do s:update(i, {{'+', 7, 1}}) end end log.info('update of an indexed field: %f', clock.monotonic() - t)
+
+function check() local ok = true for id, idx in pairs(s.index) do if type(id) == 'number' then local cnt = 0 for _, t in idx:pairs() do if s:get(t[1]) ~= t then ok = false end cnt = cnt + 1 end if cnt ~= s:len() then ok = false end end end return ok end
+check()
+s:get(500)
+s.index.tree_uniq:get(500)
+#s.index.tree_dup:select(0)
+#s.index.tree_multi:select({0, 'k1'})
+s.index.hash:get('s500')
+#s.index.tree_str:select('k2')
+#s.index.tree_counter:select(10)
+
+-- an update that changes a unique key fails with no trace
+s:update(1, {{'+', 6, 1}, {'=', 2, 2}})
+s:get(1)
+check()
+
+-- rollback restores the old tuples in all indexes
+box.begin() for i = 1, 1000 do s:update(i, {{'+', 6, 1}}) end box.rollback()
+s:get(500)
+s.index.tree_dup:count(0)
+check()
+
+-- updates of an indexed and a non-indexed field
+s:update(500, {{'=', 3, 11}, {'+', 6, 1}})
+s.index.tree_dup:count(0)
+s.index.tree_dup:select(11)
+s:update(500, {{'!', 6, 0}})
+s.index.tree_counter:select(11)
+s:update(500, {{'#', 6, 1}})
+s.index.tree_counter:count(10)
+check()
+-- a negative field number may refer to an indexed field
+s:update(500, {{'+', -1, 1}})
+s.index.tree_counter:select(11)
+check()
+
+s:drop()
@@ -0,0 +1,62 @@
+-- UPDATE which changes neither indexed fields nor the size of
+-- any field is applied to the tuple in place, unless somebody
+-- else can see the tuple.
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+_ = s:create_index('sk', {parts = {2, 'unsigned'}})
+_ = s:insert{1, 1, 0, 'abc', 1.5, string.rep('x', 2000)}
+_ = collectgarbage('collect')
+
+function get(id) local t = s:get(id) return t and t:update({{'#', 6, 1}}) end
+
+-- counters
+for i = 1, 100 do s:update(1, {{'+', 3, 1}}) collectgarbage('collect') end
+get(1)
+for i = 1, 20 do s:update(1, {{'-', 3, 1}, {'=', 4, 'xyz'}, {'=', 5, 2.5}}) collectgarbage('collect') end
+get(1)
+s.index.sk:get(1)[3]
+
+-- a tuple referenced from Lua is never changed
+t = s:get(1)
+_ = s:update(1, {{'+', 3, 1}})
+t[3]
+s:get(1)[3]
+t = nil
+_ = collectgarbage('collect')
+
+-- field size changes, the slow path
+_ = s:update(1, {{'=', 3, 127}})
+_ = collectgarbage('collect')
+_ = s:update(1, {{'+', 3, 1}})
+_ = collectgarbage('collect')
+_ = s:update(1, {{'=', 4, 'abcd'}})
+get(1)
+
+-- an indexed field is updated in the index
+_ = s:update(1, {{'+', 2, 1}})
+s.index.sk:get(1)
+s.index.sk:get(2)[1]
+
+-- rollback restores the old contents of the tuple
+_ = collectgarbage('collect')
+box.begin() s:update(1, {{'+', 3, 1}}) s:update(1, {{'+', 3, 1}}) s:update(1, {{'=', 4, 'dcba'}}) box.rollback()
+get(1)
+_ = collectgarbage('collect')
+box.begin() s:update(1, {{'+', 3, 1}}) collectgarbage('collect') s:update(1, {{'+', 3, 1}}) box.rollback()
+get(1)
+
+-- on_replace triggers see the old and the new tuple
+_ = collectgarbage('collect')
+old = nil new = nil
+_ = s:on_replace(function(o, n) old = o[3] new = n[3] end)
+_ = s:update(1, {{'+', 3, 1}})
+old, new
+s:on_replace(nil, s:on_replace()[1])
+
+-- the tuple survives a snapshot
+_ = collectgarbage('collect')
+box.snapshot()
+_ = s:update(1, {{'+', 3, 1}})
+get(1)
+
+s:drop()
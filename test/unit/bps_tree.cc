@@ -60,6 +60,58 @@ compare(type_t a, type_t b);
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
 
+/* trees for hint_benchmark test */
+struct hint_elem {
+	const type_t *ptr;
+	uint64_t hint;
+};
+
+static inline uint64_t
+hint_of(type_t value)
+{
+	return (uint64_t)value ^ (1ULL << 63);
+}
+
+#define BPS_TREE_NAME ptr_tree
+#define BPS_TREE_BLOCK_SIZE 512
+#define BPS_TREE_EXTENT_SIZE 2048
+#define BPS_TREE_COMPARE(a, b, arg) compare(*(a), *(b))
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(*(a), b)
+#define bps_tree_elem_t const type_t *
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
+#define BPS_TREE_NAME hint_tree
+#define BPS_TREE_BLOCK_SIZE 512
+#define BPS_TREE_EXTENT_SIZE 2048
+#define BPS_TREE_COMPARE(a, b, arg) ((a).hint != (b).hint ? \
+	((a).hint < (b).hint ? -1 : 1) : compare(*(a).ptr, *(b).ptr))
+#define BPS_TREE_COMPARE_KEY(a, b, arg) ((a).hint != hint_of(b) ? \
+	((a).hint < hint_of(b) ? -1 : 1) : compare(*(a).ptr, b))
+#define BPS_TREE_IS_IDENTICAL(a, b) ((a).ptr == (b).ptr)
+#define bps_tree_elem_t struct hint_elem
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef BPS_TREE_IS_IDENTICAL
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+
 /* tree for approximate_count test */
 #define BPS_TREE_NAME approx
 #define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
@@ -566,6 +618,57 @@ loading_test()
 	footer();
 }
 
+static void
+update_test()
+{
+	header();
+
+	test tree;
+	test_create(&tree, 0, extent_alloc, extent_free, &extents_count);
+
+	const type_t test_count = 1000;
+	for (type_t i = 0; i < test_count; i++)
+		test_insert(&tree, i * 10, 0);
+
+	/* An element that keeps its position is replaced in place */
+	for (type_t i = 0; i < test_count; i++) {
+		if (test_update(&tree, i * 10, i * 10 + 5))
+			fail("update failed", "true");
+	}
+	if (test_debug_check(&tree))
+		fail("debug check nonzero", "true");
+	for (type_t i = 0; i < test_count; i++) {
+		if (test_find(&tree, i * 10 + 5) == NULL)
+			fail("updated element not found", "true");
+	}
+
+	/* An element that moves past its neighbours is rejected */
+	for (type_t i = 0; i < test_count; i++) {
+		if (i > 0 && test_update(&tree, i * 10 + 5, i * 10 - 10) == 0)
+			fail("update past the previous element", "true");
+		if (i < test_count - 1 &&
+		    test_update(&tree, i * 10 + 5, i * 10 + 20) == 0)
+			fail("update past the next element", "true");
+	}
+	/* A missing element is not updated */
+	if (test_update(&tree, 7, 8) == 0)
+		fail("update of a missing element", "true");
+	if (test_debug_check(&tree))
+		fail("debug check nonzero", "true");
+
+	struct test_iterator iterator = test_iterator_first(&tree);
+	for (type_t i = 0; i < test_count; i++) {
+		type_t *v = test_iterator_get_elem(&tree, &iterator);
+		if (!v || *v != i * 10 + 5)
+			fail("wrong update result", "true");
+		test_iterator_next(&tree, &iterator);
+	}
+
+	test_destroy(&tree);
+
+	footer();
+}
+
 static void
 printing_test()
 {
@@ -755,6 +858,101 @@ approximate_count()
 	footer();
 }
 
+/**
+ * Compare lookup throughput of a tree that stores pointers to
+ * keys, like a memtx TREE index stores tuple pointers, with a tree
+ * that stores a hint (an order preserving key prefix) next to each
+ * pointer. Keys are allocated one by one in random order so that
+ * dereferencing them costs a cache miss, like a tuple in the arena.
+ *
+ * Timings are only printed if BPS_TREE_BENCH environment variable
+ * is set, otherwise the test just checks that both trees give the
+ * same results.
+ */
+static void
+hint_benchmark()
+{
+	header();
+
+	bool bench = getenv("BPS_TREE_BENCH") != NULL;
+	const size_t count = bench ? 4 * 1024 * 1024 : 64 * 1024;
+	const size_t lookups = bench ? 8 * 1024 * 1024 : 256 * 1024;
+
+	type_t **keys = (type_t **)malloc(count * sizeof(*keys));
+	for (size_t i = 0; i < count; i++) {
+		keys[i] = (type_t *)malloc(sizeof(type_t));
+		*keys[i] = (type_t)i - (type_t)count / 2;
+	}
+	/* Shuffle insertion order. */
+	for (size_t i = count - 1; i > 0; i--) {
+		size_t j = rand() % (i + 1);
+		type_t *tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	ptr_tree ptree;
+	hint_tree htree;
+	ptr_tree_create(&ptree, 0, extent_alloc, extent_free, &extents_count);
+	hint_tree_create(&htree, 0, extent_alloc, extent_free, &extents_count);
+
+	clock_t start = clock();
+	for (size_t i = 0; i < count; i++)
+		ptr_tree_insert(&ptree, keys[i], NULL);
+	clock_t ptr_insert = clock() - start;
+
+	start = clock();
+	for (size_t i = 0; i < count; i++) {
+		struct hint_elem elem = { keys[i], hint_of(*keys[i]) };
+		hint_tree_insert(&htree, elem, NULL);
+	}
+	clock_t hint_insert = clock() - start;
+
+	type_t *search = (type_t *)malloc(lookups * sizeof(*search));
+	for (size_t i = 0; i < lookups; i++)
+		search[i] = (type_t)(rand() % (count + count / 4)) -
+			    (type_t)count / 2;
+
+	size_t ptr_found = 0;
+	start = clock();
+	for (size_t i = 0; i < lookups; i++) {
+		if (ptr_tree_find(&ptree, search[i]) != NULL)
+			ptr_found++;
+	}
+	clock_t ptr_lookup = clock() - start;
+
+	size_t hint_found = 0;
+	start = clock();
+	for (size_t i = 0; i < lookups; i++) {
+		if (hint_tree_find(&htree, search[i]) != NULL)
+			hint_found++;
+	}
+	clock_t hint_lookup = clock() - start;
+
+	if (ptr_found != hint_found)
+		fail("trees give different results", "true");
+	if (ptr_tree_debug_check(&ptree) || hint_tree_debug_check(&htree))
+		fail("debug check nonzero", "true");
+
+	if (bench) {
+		fprintf(stderr, "insert: ptr %.0f ops/s, hint %.0f ops/s\n",
+			count * (double)CLOCKS_PER_SEC / (ptr_insert + 1),
+			count * (double)CLOCKS_PER_SEC / (hint_insert + 1));
+		fprintf(stderr, "lookup: ptr %.0f ops/s, hint %.0f ops/s\n",
+			lookups * (double)CLOCKS_PER_SEC / (ptr_lookup + 1),
+			lookups * (double)CLOCKS_PER_SEC / (hint_lookup + 1));
+	}
+
+	ptr_tree_destroy(&ptree);
+	hint_tree_destroy(&htree);
+	for (size_t i = 0; i < count; i++)
+		free(keys[i]);
+	free(keys);
+	free(search);
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -763,9 +961,11 @@ main(void)
 	compare_with_sptree_check_branches();
 	bps_tree_debug_self_check();
 	loading_test();
+	update_test();
 	printing_test();
 	white_box_test();
 	approximate_count();
+	hint_benchmark();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 }
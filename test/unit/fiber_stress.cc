@@ -1,11 +1,17 @@
+#include <stdio.h>
 #include "memory.h"
 #include "fiber.h"
 
 enum {
 	ITERATIONS = 50000,
-	FIBERS = 100
+	FIBERS = 100,
+	/** Fibers alive at once in the stack reclamation test. */
+	MANY_FIBERS = 20000,
+	MANY_FIBERS_STACK_SIZE = 32768
 };
 
+static int sleepers;
+
 static int
 yield_f(va_list ap)
 {
@@ -16,6 +22,39 @@ yield_f(va_list ap)
 	return 0;
 }
 
+static int
+sleep_f(va_list ap)
+{
+	fiber_sleep(0.01);
+	sleepers--;
+	return 0;
+}
+
+/**
+ * Keep a lot of fibers alive at once, let them all die and
+ * check that the stacks cached beyond the watermark are
+ * given back to the OS.
+ */
+static void
+stack_reclaim_test()
+{
+	struct cord *cord = cord();
+	fiber_set_stack_size(MANY_FIBERS_STACK_SIZE);
+	uint64_t reclaim_count = cord->stack_reclaim_count;
+	for (int i = 0; i < MANY_FIBERS; i++) {
+		struct fiber *f = fiber_new_xc("sleeper", sleep_f);
+		sleepers++;
+		fiber_wakeup(f);
+	}
+	while (sleepers > 0)
+		fiber_sleep(0.001);
+	printf("stack size: %zu\n", fiber_stack_size());
+	printf("cached fibers: %u\n", (unsigned) cord->dead_count);
+	printf("reclaimed stacks: %llu\n", (unsigned long long)
+	       (cord->stack_reclaim_count - reclaim_count));
+	fiber_set_stack_size(FIBER_STACK_SIZE_DEFAULT);
+}
+
 static int
 benchmark_f(va_list ap)
 {
@@ -29,6 +68,7 @@ benchmark_f(va_list ap)
 		while (fibers[i]->fid > 0)
 			fiber_sleep(0.001);
 	}
+	stack_reclaim_test();
 	ev_break(loop(), EVBREAK_ALL);
 	return 0;
 }
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <inttypes.h>
+#include <time.h>
 
 #include "unit.h"
 #include "salad/rtree.h"
@@ -260,12 +261,263 @@ neighbor_test()
 	footer();
 }
 
+static void
+rand_rect(struct rtree_rect *rect, coord_t space_limit, coord_t box_limit)
+{
+	coord_t x = rand() % 4096 * space_limit / 4096;
+	coord_t y = rand() % 4096 * space_limit / 4096;
+	coord_t w = rand() % 4096 * box_limit / 4096;
+	coord_t h = rand() % 4096 * box_limit / 4096;
+	rtree_set2d(rect, x, y, x + w, y + h);
+}
+
+static bool
+rect_overlaps(const struct rtree_rect *a, const struct rtree_rect *b)
+{
+	for (int i = 0; i < 2; i++) {
+		if (a->coords[2 * i] > b->coords[2 * i + 1] ||
+		    a->coords[2 * i + 1] < b->coords[2 * i])
+			return false;
+	}
+	return true;
+}
+
+/*
+ * A bulk loaded tree must give the same results as a brute force
+ * search and stay a valid tree for further inserts and removals.
+ */
+static void
+build_test()
+{
+	header();
+
+	const size_t counts[] = {0, 1, 17, 18, 100, 1000, 10000};
+	const size_t query_count = 100;
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		size_t count = counts[c];
+		struct rtree_rect *arr = (struct rtree_rect *)
+			malloc((count + 1) * sizeof(*arr));
+		for (size_t i = 0; i < count; i++)
+			rand_rect(&arr[i], 1000, 10);
+
+		struct rtree tree;
+		rtree_init(&tree, 2, extent_size,
+			   extent_alloc, extent_free, &page_count,
+			   RTREE_EUCLID);
+		if (rtree_build_reserve(&tree, count / 2) != 0)
+			fail("reserve failed", "true");
+		for (size_t i = 0; i < count; i++) {
+			if (rtree_build_add(&tree, &arr[i],
+					    (record_t)(i + 1)) != 0)
+				fail("build add failed", "true");
+		}
+		rtree_build(&tree);
+		if (rtree_number_of_records(&tree) != count)
+			fail("Tree count mismatch", "true");
+
+		struct rtree_iterator iterator;
+		rtree_iterator_init(&iterator);
+		for (size_t q = 0; q < query_count; q++) {
+			struct rtree_rect rect;
+			rand_rect(&rect, 1000, 100);
+			size_t expected = 0;
+			for (size_t i = 0; i < count; i++)
+				expected += rect_overlaps(&arr[i], &rect);
+			size_t found = 0;
+			rtree_search(&tree, &rect, SOP_OVERLAPS, &iterator);
+			record_t rec;
+			while ((rec = rtree_iterator_next(&iterator)) != NULL) {
+				size_t i = (size_t)rec - 1;
+				if (!rect_overlaps(&arr[i], &rect))
+					fail("wrong search result", "true");
+				found++;
+			}
+			if (found != expected)
+				fail("search result count mismatch", "true");
+		}
+
+		/* Neighbours come in order of distance */
+		struct rtree_rect basis;
+		rtree_set2dp(&basis, 500, 500);
+		rtree_search(&tree, &basis, SOP_NEIGHBOR, &iterator);
+		coord_t prev = 0;
+		size_t found = 0;
+		record_t rec;
+		while ((rec = rtree_iterator_next(&iterator)) != NULL) {
+			struct rtree_rect *r = &arr[(size_t)rec - 1];
+			coord_t dist = 0;
+			for (int i = 0; i < 2; i++) {
+				coord_t d = 0;
+				if (r->coords[2 * i] > 500)
+					d = r->coords[2 * i] - 500;
+				else if (r->coords[2 * i + 1] < 500)
+					d = 500 - r->coords[2 * i + 1];
+				dist += d * d;
+			}
+			if (dist < prev)
+				fail("wrong neighbour order", "true");
+			prev = dist;
+			found++;
+		}
+		if (found != count)
+			fail("neighbour count mismatch", "true");
+		rtree_iterator_destroy(&iterator);
+
+		/* The built tree is a regular tree */
+		rand_rect(&arr[count], 1000, 10);
+		rtree_insert(&tree, &arr[count], (record_t)(count + 1));
+		for (size_t i = 0; i <= count; i++) {
+			if (!rtree_remove(&tree, &arr[i], (record_t)(i + 1)))
+				fail("delete element in tree", "false");
+		}
+		if (rtree_number_of_records(&tree) != 0)
+			fail("Tree count mismatch", "true");
+
+		rtree_destroy(&tree);
+		free(arr);
+	}
+
+	footer();
+}
+
+/* Exact rectangle of a record of build_benchmark() */
+static void
+benchmark_record_rect(void *ctx, record_t record, struct rtree_rect *rect)
+{
+	const struct rtree_rect *arr = (const struct rtree_rect *)ctx;
+	*rect = arr[(size_t)record - 1];
+}
+
+/*
+ * Compare a tree built by insertion with a bulk loaded one and
+ * a bulk loaded one with float coordinates: build time, memory
+ * and overlap query time.
+ *
+ * Timings are only printed if RTREE_BENCH environment variable
+ * is set, otherwise the test just checks that both trees give the
+ * same results.
+ */
+static void
+build_benchmark()
+{
+	header();
+
+	bool bench = getenv("RTREE_BENCH") != NULL;
+	const size_t count = bench ? 4 * 1024 * 1024 : 64 * 1024;
+	const size_t query_count = bench ? 256 * 1024 : 4 * 1024;
+
+	struct rtree_rect *arr = (struct rtree_rect *)
+		malloc(count * sizeof(*arr));
+	for (size_t i = 0; i < count; i++) {
+		rand_rect(&arr[i], 100000, 0);
+		/* Off the grid of queries and not exact in float */
+		for (int j = 0; j < 4; j++)
+			arr[i].coords[j] += 0.01;
+	}
+	struct rtree_rect *queries = (struct rtree_rect *)
+		malloc(query_count * sizeof(*queries));
+	for (size_t i = 0; i < query_count; i++)
+		rand_rect(&queries[i], 100000, 500);
+
+	struct rtree itree, btree, ftree;
+	rtree_init(&itree, 2, extent_size, extent_alloc, extent_free,
+		   &page_count, RTREE_EUCLID);
+	rtree_init(&btree, 2, extent_size, extent_alloc, extent_free,
+		   &page_count, RTREE_EUCLID);
+	rtree_init(&ftree, 2, extent_size, extent_alloc, extent_free,
+		   &page_count, RTREE_EUCLID);
+	if (rtree_set_coord_type(&ftree, RTREE_COORD_FLOAT,
+				 benchmark_record_rect, arr) != 0)
+		fail("set coord type", "true");
+
+	clock_t start = clock();
+	for (size_t i = 0; i < count; i++)
+		rtree_insert(&itree, &arr[i], (record_t)(i + 1));
+	clock_t insert_build = clock() - start;
+
+	start = clock();
+	rtree_build_reserve(&btree, count);
+	for (size_t i = 0; i < count; i++)
+		rtree_build_add(&btree, &arr[i], (record_t)(i + 1));
+	rtree_build(&btree);
+	clock_t bulk_build = clock() - start;
+
+	rtree_build_reserve(&ftree, count);
+	for (size_t i = 0; i < count; i++)
+		rtree_build_add(&ftree, &arr[i], (record_t)(i + 1));
+	rtree_build(&ftree);
+
+	struct rtree_iterator iterator;
+	rtree_iterator_init(&iterator);
+	size_t ifound = 0, bfound = 0;
+	start = clock();
+	for (size_t i = 0; i < query_count; i++) {
+		rtree_search(&itree, &queries[i], SOP_OVERLAPS, &iterator);
+		while (rtree_iterator_next(&iterator) != NULL)
+			ifound++;
+	}
+	clock_t insert_query = clock() - start;
+	rtree_iterator_destroy(&iterator);
+
+	rtree_iterator_init(&iterator);
+	start = clock();
+	for (size_t i = 0; i < query_count; i++) {
+		rtree_search(&btree, &queries[i], SOP_OVERLAPS, &iterator);
+		while (rtree_iterator_next(&iterator) != NULL)
+			bfound++;
+	}
+	clock_t bulk_query = clock() - start;
+	rtree_iterator_destroy(&iterator);
+
+	size_t ffound = 0;
+	rtree_iterator_init(&iterator);
+	start = clock();
+	for (size_t i = 0; i < query_count; i++) {
+		rtree_search(&ftree, &queries[i], SOP_OVERLAPS, &iterator);
+		while (rtree_iterator_next(&iterator) != NULL)
+			ffound++;
+	}
+	clock_t float_query = clock() - start;
+	rtree_iterator_destroy(&iterator);
+
+	if (ifound != bfound || ifound != ffound)
+		fail("search result count mismatch", "true");
+	if (rtree_used_size(&btree) > rtree_used_size(&itree))
+		fail("bulk loaded tree is bigger", "true");
+	if (rtree_used_size(&ftree) > rtree_used_size(&btree) * 2 / 3)
+		fail("float tree is not smaller", "true");
+
+	if (bench) {
+		printf("insert build: %.3f s, bulk build: %.3f s\n",
+		       (double)insert_build / CLOCKS_PER_SEC,
+		       (double)bulk_build / CLOCKS_PER_SEC);
+		printf("insert tree: %zu bytes, bulk tree: %zu bytes\n",
+		       rtree_used_size(&itree), rtree_used_size(&btree));
+		printf("insert tree query: %.3f s, bulk tree query: %.3f s\n",
+		       (double)insert_query / CLOCKS_PER_SEC,
+		       (double)bulk_query / CLOCKS_PER_SEC);
+		printf("float tree: %zu bytes, float tree query: %.3f s\n",
+		       rtree_used_size(&ftree),
+		       (double)float_query / CLOCKS_PER_SEC);
+	}
+
+	rtree_destroy(&itree);
+	rtree_destroy(&btree);
+	rtree_destroy(&ftree);
+	free(arr);
+	free(queries);
+
+	footer();
+}
+
 
 int
 main(void)
 {
 	simple_check();
 	neighbor_test();
+	build_test();
+	build_benchmark();
 	if (page_count != 0) {
 		fail("memory leak!", "true");
 	}
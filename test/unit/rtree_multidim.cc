@@ -26,6 +26,12 @@ const unsigned TEST_ROUNDS = 1000;
 
 static int page_count = 0;
 
+/*
+ * Added to all random coordinates, so that with float coordinates
+ * in the tree they are rounded and must be re-checked.
+ */
+static coord_t coord_shift = 0;
+
 static void *
 extent_alloc(void *ctx)
 {
@@ -51,7 +57,7 @@ struct CCoordPair {
 coord_t
 rand(coord_t lim)
 {
-	return rand() % 1024 * lim / 1024;
+	return rand() % 1024 * lim / 1024 + coord_shift;
 }
 
 template<unsigned DIMENSION>
@@ -95,7 +101,7 @@ struct CBox {
 			pairs[i].b = pairs[i].a + widths[i];
 		}
 	}
-	void FillRTreeRect(struct rtree_rect *rt)
+	void FillRTreeRect(struct rtree_rect *rt) const
 	{
 		for (unsigned i = 0; i < DIMENSION; i++) {
 			rt->coords[2 * i] = pairs[i].a;
@@ -483,7 +489,16 @@ test_select_strict_in(const CBoxSet<DIMENSION> &set, const struct rtree *tree)
 
 template<unsigned DIMENSION>
 static void
-rand_test()
+record_rect(void *ctx, record_t record, struct rtree_rect *rect)
+{
+	const CBoxSet<DIMENSION> *set = (const CBoxSet<DIMENSION> *)ctx;
+	size_t id = (size_t)(uintptr_t)record - 1;
+	set->entries[id].box.FillRTreeRect(rect);
+}
+
+template<unsigned DIMENSION>
+static void
+rand_test(enum rtree_coord_type coord_type)
 {
 	header();
 
@@ -493,9 +508,14 @@ rand_test()
 	rtree_init(&tree, DIMENSION, extent_size,
 		   extent_alloc, extent_free, &page_count,
 		   RTREE_EUCLID);
+	if (rtree_set_coord_type(&tree, coord_type, record_rect<DIMENSION>,
+				 &set) != 0)
+		fail("set coord type", "true");
+	coord_shift = coord_type == RTREE_COORD_FLOAT ? 1e-9 : 0;
 
-	printf("\tDIMENSION: %u, page size: %u, max fill good: %d\n",
-	       DIMENSION, tree.page_size, tree.page_max_fill >= 10);
+	printf("\tDIMENSION: %u, %s, page size: %u, max fill good: %d\n",
+	       DIMENSION, coord_type == RTREE_COORD_FLOAT ? "float" : "double",
+	       tree.page_size, tree.page_max_fill >= 10);
 
 	for (unsigned i = 0; i < TEST_ROUNDS; i++) {
 		bool insert;
@@ -536,11 +556,16 @@ int
 main(void)
 {
 	srand(time(0));
-	rand_test<1>();
-	rand_test<2>();
-	rand_test<3>();
-	rand_test<8>();
-	rand_test<16>();
+	rand_test<1>(RTREE_COORD_DOUBLE);
+	rand_test<2>(RTREE_COORD_DOUBLE);
+	rand_test<3>(RTREE_COORD_DOUBLE);
+	rand_test<8>(RTREE_COORD_DOUBLE);
+	rand_test<16>(RTREE_COORD_DOUBLE);
+	rand_test<1>(RTREE_COORD_FLOAT);
+	rand_test<2>(RTREE_COORD_FLOAT);
+	rand_test<3>(RTREE_COORD_FLOAT);
+	rand_test<8>(RTREE_COORD_FLOAT);
+	rand_test<16>(RTREE_COORD_FLOAT);
 	if (page_count != 0) {
 		fail("memory leak!", "true");
 	}
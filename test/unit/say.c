@@ -1,7 +1,37 @@
 #include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "unit.h"
 #include "say.h"
 
+enum { ASYNC_THREADS = 4, ASYNC_RECORDS = 100 };
+
+static void *
+async_log_f(void *arg)
+{
+	for (int i = 0; i < ASYNC_RECORDS; i++)
+		say_info("async record %d/%d", (int)(intptr_t) arg, i);
+	return NULL;
+}
+
+/** Count records written by async_log_f() to the log file. */
+static int
+async_count_records(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+		return -1;
+	char line[1024];
+	int count = 0;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		if (strstr(line, "I> async record ") != NULL)
+			count++;
+	}
+	fclose(f);
+	return count;
+}
+
 int
 parse_logger_type(const char *input)
 {
@@ -44,9 +74,14 @@ parse_syslog_opts(const char *input)
 
 int main()
 {
-	say_logger_init("/dev/null", S_INFO, 0, 0);
+	char path[] = "say.test.XXXXXX";
+	int fd = mkstemp(path);
+	if (fd < 0)
+		return 1;
+	close(fd);
+	say_logger_init(path, S_INFO, 0, 0);
 
-	plan(20);
+	plan(22);
 
 #define PARSE_LOGGER_TYPE(input, rc) \
 	ok(parse_logger_type(input) == rc, "%s", input)
@@ -76,5 +111,18 @@ int main()
 	PARSE_SYSLOG_OPTS("facility=local1,facility=local2", -1);
 	PARSE_SYSLOG_OPTS("identity=foo,identity=bar", -1);
 
+	say_logger_async_start();
+	pthread_t threads[ASYNC_THREADS];
+	for (int i = 0; i < ASYNC_THREADS; i++)
+		pthread_create(&threads[i], NULL, async_log_f,
+			       (void *)(intptr_t) i);
+	for (int i = 0; i < ASYNC_THREADS; i++)
+		pthread_join(threads[i], NULL);
+	say_logger_free();
+	ok(say_logger_dropped() == 0, "async: no records dropped");
+	ok(async_count_records(path) == ASYNC_THREADS * ASYNC_RECORDS,
+	   "async: all records written");
+	unlink(path);
+
 	return check_plan();
 }
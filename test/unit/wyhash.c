@@ -0,0 +1,147 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "unit.h"
+#include "salad/wyhash.h"
+#include "third_party/PMurHash.h"
+
+enum {
+	/** Number of hashed keys in every benchmark round. */
+	BENCH_KEYS = 4 * 1000 * 1000,
+	/** Sequential ids for the bit balance check. */
+	SEQ_COUNT = 1 << 16
+};
+
+/**
+ * The hash values are stored on disk in vinyl bloom filters,
+ * so they must never change.
+ */
+static void
+test_vectors(void)
+{
+	header();
+	static const char *strs[] = {
+		"",
+		"a",
+		"abc",
+		"message digest",
+		"abcdefghijklmnopqrstuvwxyz",
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+		"123456789012345678901234567890123456789012345678901234567890"
+		"12345678901234567890",
+	};
+	for (unsigned i = 0; i < sizeof(strs) / sizeof(strs[0]); i++) {
+		printf("wyhash(\"%.16s\", %u) = %016llx\n", strs[i], i,
+		       (unsigned long long) wyhash(strs[i], strlen(strs[i]),
+						   i));
+	}
+	printf("wyhash_u64(0, 0) = %016llx\n",
+	       (unsigned long long) wyhash_u64(0, 0));
+	printf("wyhash_u64(1, 13) = %016llx\n",
+	       (unsigned long long) wyhash_u64(1, 13));
+	footer();
+}
+
+/**
+ * Check that every bit of a 32-bit hash of a sequential id is
+ * set in 45%..55% of the cases. Bloom filters split the hash
+ * into independent parts and need all of them to be random.
+ */
+static bool
+bits_are_balanced(uint32_t (*hash)(uint64_t))
+{
+	unsigned ones[32];
+	memset(ones, 0, sizeof(ones));
+	for (uint64_t i = 0; i < SEQ_COUNT; i++) {
+		uint32_t h = hash(i);
+		for (int bit = 0; bit < 32; bit++)
+			ones[bit] += (h >> bit) & 1;
+	}
+	for (int bit = 0; bit < 32; bit++) {
+		if (ones[bit] < SEQ_COUNT * 0.45 ||
+		    ones[bit] > SEQ_COUNT * 0.55)
+			return false;
+	}
+	return true;
+}
+
+static uint32_t
+identity_hash(uint64_t val)
+{
+	return val;
+}
+
+static uint32_t
+wyhash_folded(uint64_t val)
+{
+	uint64_t h = wyhash_u64(val, 13);
+	return h ^ (h >> 32);
+}
+
+static void
+test_sequential_ids(void)
+{
+	header();
+	printf("identity bits are balanced: %d\n",
+	       bits_are_balanced(identity_hash));
+	printf("wyhash bits are balanced: %d\n",
+	       bits_are_balanced(wyhash_folded));
+	footer();
+}
+
+/**
+ * Hashing throughput, MurmurHash3 vs wyhash, on keys of
+ * typical sizes. The numbers depend on the machine, so they
+ * go to stderr and are not part of the result file.
+ */
+static void
+bench_key_size(size_t size)
+{
+	char *keys = (char *) malloc(size * 1024);
+	for (size_t i = 0; i < size * 1024; i++)
+		keys[i] = rand();
+
+	uint32_t h32 = 0;
+	clock_t start = clock();
+	for (unsigned i = 0; i < BENCH_KEYS; i++) {
+		const char *key = keys + (i % 1024) * size;
+		h32 ^= PMurHash32(13, key, size);
+	}
+	double murmur = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	uint64_t h64 = 0;
+	start = clock();
+	for (unsigned i = 0; i < BENCH_KEYS; i++) {
+		const char *key = keys + (i % 1024) * size;
+		h64 ^= wyhash(key, size, 13);
+	}
+	double wy = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	fprintf(stderr, "%4zu bytes: murmur %.1f MB/s, wyhash %.1f MB/s "
+		"(%x %llx)\n", size, BENCH_KEYS * size / murmur / 1e6,
+		BENCH_KEYS * size / wy / 1e6, h32, (unsigned long long) h64);
+	free(keys);
+}
+
+static void
+bench(void)
+{
+	header();
+	size_t sizes[] = { 4, 8, 16, 32, 64, 256 };
+	for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		bench_key_size(sizes[i]);
+	footer();
+}
+
+int
+main(void)
+{
+	test_vectors();
+	test_sequential_ids();
+	bench();
+	return 0;
+}
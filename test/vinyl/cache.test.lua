@@ -327,3 +327,45 @@ local_space:select{}
 box.commit()
 local_space:select{}
 local_space:drop()
+
+--
+-- A full scan of a cold index doesn't flush hot tuples of another
+-- index out of the cache.
+--
+str = string.rep('!', 100)
+hot = box.schema.space.create('hot', {engine = 'vinyl'})
+_ = hot:create_index('pk')
+cold = box.schema.space.create('cold', {engine = 'vinyl'})
+_ = cold:create_index('pk')
+for i = 1, 10 do hot:insert{i, str} end
+for i = 1, 1000 do cold:insert{i, str} end
+function hot_read() for i = 1, 10 do hot:get{i} end end
+function cache_stat(s) local c = box.info.vinyl().db[s.id .. '/0'].cache return c.hit, c.miss, c.evict end
+hot_read()
+hot_read()
+cache_stat(hot)
+box.begin() t = cold:select{} box.commit()
+#t
+t = nil
+_, _, evict = cache_stat(cold)
+evict > 0
+hot_read()
+cache_stat(hot)
+hot:drop()
+cold:drop()
+
+--
+-- Per-index cache budget.
+--
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {cache_size = -1})
+pk = s:create_index('pk', {cache_size = 1000})
+box.info.vinyl().db[s.id .. '/0'].cache.budget
+for i = 1, 100 do s:insert{i, str} end
+box.begin() t = s:select{} box.commit()
+#t
+t = nil
+box.info.vinyl().db[s.id .. '/0'].cache.count < 100
+_, _, evict = cache_stat(s)
+evict > 0
+s:drop()
@@ -39,5 +39,19 @@ test_run:grep_log('default', 'UPSERT operation failed') ~= nil
 
 space:drop()
 
+-- compaction policy
+space = box.schema.space.create('vinyl', { engine = 'vinyl' })
+_ = space:create_index('primary', { compaction_policy = 'fifo' })
+-- leveled policy compacts as soon as a level has two runs
+_ = space:create_index('primary', { run_count_per_level = 2, compaction_policy = 'leveled' })
+vyinfo().compaction_policy
+space:insert({1})
+box.snapshot()
+space:insert({2})
+box.snapshot()
+while vyinfo().run_count >= 2 do fiber.sleep(0.1) end
+vyinfo().run_count == 1
+space:drop()
+
 fiber = nil
 test_run = nil
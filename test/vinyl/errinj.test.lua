@@ -130,3 +130,21 @@ for i=1,256 do s:upsert({0, 0}, {{'+', 2, 1}}) end
 s:drop() -- index is gone
 fiber.sleep(0.05)
 errinj.set("ERRINJ_VY_SQUASH_TIMEOUT", 0)
+
+--
+-- Check that a point lookup neither returns nor caches a value
+-- replaced while a run page is being read from disk.
+--
+s = box.schema.space.create('test', {engine='vinyl'})
+_ = s:create_index('pk')
+s:replace{1, 'old'}
+box.snapshot()
+errinj.set("ERRINJ_VY_READ_PAGE_TIMEOUT", true)
+function test_get() ret = s:get{1} end
+f1 = fiber.create(test_get)
+s:replace{1, 'new'}
+while f1:status() ~= 'dead' do fiber.sleep(0.01) end
+errinj.set("ERRINJ_VY_READ_PAGE_TIMEOUT", false)
+ret
+s:get{1}
+s:drop()
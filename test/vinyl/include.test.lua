@@ -0,0 +1,42 @@
+-- Fields included into a secondary index are stored in its runs.
+s = box.schema.space.create('test', {engine = 'vinyl', field_count = 3})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, include = {3}})
+box.space._index:get{s.id, sk.id}[5].include
+for i = 1, 5 do s:replace{i, i * 10, 'v' .. i} end
+box.snapshot()
+
+-- The index covers all fields, the primary one is not looked up.
+old = box.info.vinyl().performance.lookup.total
+sk:select({30}, {iterator = 'GE'})
+sk:get{20}
+box.info.vinyl().performance.lookup.total - old
+
+-- Updates of included fields are not skipped.
+s:update(2, {{'=', 3, 'new'}})
+box.snapshot()
+sk:get{20}
+s:drop()
+
+-- Without a fixed field count the tuple is fetched from the primary index.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {2, 'unsigned'}, include = {4}})
+s:replace{1, 10, 'a', 'b', 'c'}
+box.snapshot()
+old = box.info.vinyl().performance.lookup.total
+sk:get{10}
+box.info.vinyl().performance.lookup.total - old
+s:drop()
+
+-- Errors.
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {include = {2}})
+pk = s:create_index('pk')
+s:create_index('sk', {parts = {2, 'unsigned'}, include = {65}})
+s:create_index('sk', {parts = {2, 'unsigned'}, include = {'x'}})
+s:drop()
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+s:create_index('sk', {parts = {2, 'unsigned'}, include = {3}})
+s:drop()
@@ -18,7 +18,10 @@ for _, v in ipairs({ 'path', 'build', 'tx_latency', 'cursor_latency',
                      'page_count', 'memory_used', 'run_max', 'run_histogram',
                      'size', 'size_uncompressed', 'used', 'count', 'rps',
                      'total', 'dumped_statements', 'bandwidth', 'avg', 'max',
-                     'watermark' }) do
+                     'watermark', 'dump_bytes', 'compact_bytes', 'read',
+                     'write', 'space', 'throttle_rate',
+                     'throttle_delay', 'hit', 'miss', 'evict',
+                     'read_bytes', 'write_bytes' }) do
     test_run:cmd("push filter '"..v..": .*' to '"..v..": <"..v..">'")
 end;
 test_run:cmd("setopt delimiter ''");
@@ -57,5 +60,34 @@ box.info.vinyl().memory.min_lsn == box.info.vclock[1]
 space:drop()
 box.info.vinyl().memory.min_lsn
 
+-- Dump and compaction I/O is accounted and throttled.
+box.cfg{vinyl_io_rate_limit = 1}
+box.info.vinyl().scheduler.io_rate_limit
+digest = require('digest')
+space = box.schema.space.create('test', { engine = 'vinyl' })
+index = space:create_index('primary')
+old = box.info.vinyl().scheduler
+for i = 1, 100 do space:replace({i, digest.urandom(4096)}) end
+box.snapshot()
+new = box.info.vinyl().scheduler
+new.write_bytes - old.write_bytes > 100 * 4096
+new.throttle_count > old.throttle_count
+new.throttle_time > old.throttle_time
+space:drop()
+box.cfg{vinyl_io_rate_limit = 0}
+box.info.vinyl().scheduler.io_rate_limit
+
+-- Gets by a full key take the point lookup path.
+space = box.schema.space.create('test', { engine = 'vinyl' })
+index = space:create_index('primary')
+space:replace({1, 1})
+box.snapshot()
+space:upsert({1, 1}, {{'+', 2, 1}})
+old = box.info.vinyl().performance.lookup.total
+space:get({1})
+space:get({2})
+box.info.vinyl().performance.lookup.total - old
+space:drop()
+
 test_run:cmd('switch default')
 test_run:cmd("stop server vinyl_info")
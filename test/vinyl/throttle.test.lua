@@ -0,0 +1,38 @@
+env = require('test_run')
+test_run = env.new()
+
+--
+-- Writers are delayed once memory usage exceeds the quota
+-- watermark and they consume memory faster than it is dumped.
+--
+test_run:cmd('create server vinyl_throttle with script="vinyl/vinyl_throttle.lua"')
+test_run:cmd("start server vinyl_throttle")
+test_run:cmd('switch vinyl_throttle')
+
+fiber = require('fiber')
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk')
+pad = string.rep('x', 1000)
+test_run:cmd("setopt delimiter ';'")
+-- Write as fast as possible and return the longest commit time.
+function write(timeout)
+    local deadline = fiber.time() + timeout
+    local max_delay = 0
+    local i = 0
+    while fiber.time() < deadline and max_delay < 0.05 do
+        i = i + 1
+        local start = fiber.time()
+        s:replace{i % 10000, pad}
+        max_delay = math.max(max_delay, fiber.time() - start)
+    end
+    return max_delay
+end;
+test_run:cmd("setopt delimiter ''");
+
+write(10) >= 0.05
+box.info.vinyl().memory.throttle_delay > 0
+s:drop()
+
+test_run:cmd('switch default')
+test_run:cmd("stop server vinyl_throttle")
+test_run:cmd("cleanup server vinyl_throttle")
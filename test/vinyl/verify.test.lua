@@ -0,0 +1,34 @@
+test_run = require('test_run').new()
+
+--
+-- Page checksums of all runs are verified at startup if
+-- vinyl_verify_runs is set.
+--
+test_run:cmd('create server vinyl_verify with script="vinyl/vinyl_verify.lua"')
+test_run:cmd("start server vinyl_verify")
+test_run:cmd('switch vinyl_verify')
+
+box.cfg.vinyl_verify_runs
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('primary')
+pad = string.rep('x', 1000)
+for i = 1, 300 do s:replace{i, pad} end
+box.snapshot()
+for i = 1, 300, 2 do s:replace{i, i} end
+box.snapshot()
+
+test_run:cmd('switch default')
+test_run:cmd("stop server vinyl_verify")
+test_run:cmd("start server vinyl_verify")
+test_run:cmd('switch vinyl_verify')
+
+s = box.space.test
+s:count()
+s:get(1)[2]
+s:get(2)[2] == pad
+test_run:grep_log('vinyl_verify', 'verified checksums') ~= nil
+s:drop()
+
+test_run:cmd('switch default')
+test_run:cmd("stop server vinyl_verify")
+test_run:cmd("cleanup server vinyl_verify")
@@ -0,0 +1,35 @@
+env = require('test_run')
+test_run = env.new()
+fio = require('fio')
+
+--
+-- Complete WALs are read and decoded by a separate thread
+-- during recovery. Check that it replays a sequence of WALs,
+-- including one with a corrupted tail when force_recovery
+-- is set.
+--
+box.cfg.rows_per_wal
+box.cfg.force_recovery
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:insert{i, string.rep('x', i)} end
+files = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(files)
+#files > 3
+-- replace the eof marker of a complete WAL with garbage
+name = files[#files - 1]
+f = io.open(name, 'rb')
+data = f:read('*a')
+f:close()
+f = io.open(name, 'wb')
+_ = f:write(data:sub(1, -5) .. 'garbage')
+f:close()
+test_run:cmd('restart server default')
+test_run:grep_log('default', 'rows read and decoded at') ~= nil
+test_run:grep_log('default', "can't open tx") ~= nil
+s = box.space.test
+s:count()
+bad = 0
+for i = 1, 100 do local t = s:get{i} if t == nil or t[2] ~= string.rep('x', i) then bad = bad + 1 end end
+bad
+s:drop()